@@ -8,7 +8,7 @@ function server_test {
     ${MYDIR}/bin/"${buildCfg}"/cachelotd &
     local pid=$!
     sleep 1 # ensure listen socket is up
-    ${MYDIR}/test/server_test.py
+    ${MYDIR}/test/server_test.py ${MYDIR}/bin/"${buildCfg}"/cachelotd
     local ret=$?
     kill ${pid} || ret=$?
     [[ ${ret} != 0 ]] && exit ${ret}
@@ -27,7 +27,7 @@ constexpr uint32 max_value_len = 40;
 namespace {
 
     // Hash function
-    static auto calc_hash = fnv1a<cache::Cache::hash_type>::hasher();
+    static auto calc_hash = cache::HashFunction();
 
     static struct stats_type {
         uint64 num_get = 0;
@@ -0,0 +1,92 @@
+#include <cachelot/common.h>
+#include <cachelot/cache.h>
+#include <cachelot/random.h>
+
+#include <iostream>
+#include <iomanip>
+
+//
+// Benchmark of the expiration clock
+//
+// Compares reading the system clock on every access (precise mode) with reading
+// the value updated by a timer (cached mode): the cost of a single clock read and
+// the cost of the cache requests, which check or set an expiration time
+//
+
+using namespace cachelot;
+
+constexpr size_t num_clock_reads = 20000000;
+constexpr size_t num_keys = 100000;
+constexpr size_t num_requests = 4000000;
+constexpr size_t cache_memory = 64 * Megabyte;
+constexpr size_t page_size = 4 * Megabyte;
+
+namespace {
+
+    typedef cache::ExpirationClock clock_type;
+
+    static auto calc_hash = cache::HashFunction();
+
+    template <typename Function>
+    double ns_per_call(const size_t num_calls, Function fun) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for (size_t n = 0; n < num_calls; ++n) {
+            fun(n);
+        }
+        auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_time);
+        return static_cast<double>(time_passed.count()) / num_calls;
+    }
+
+    void run(const char * mode_name, const bool cached, const std::vector<string> & keys) {
+        clock_type::set_cached(cached);
+        // single clock read
+        clock_type::rep time_sum = 0;
+        const double ns_clock = ns_per_call(num_clock_reads, [&time_sum](size_t) {
+            time_sum += clock_type::now().time_since_epoch().count();
+        });
+        // set with TTL (one clock read)
+        auto the_cache = cache::Cache::Create(cache_memory, page_size, 131072, true);
+        const double ns_set = ns_per_call(num_requests, [&the_cache, &keys](size_t n) {
+            const string & k = keys[n % keys.size()];
+            const slice key(k.c_str(), k.size());
+            auto item = the_cache.create_item(key, calc_hash(key), k.size(), 0, cache::seconds(3600));
+            item->assign_value(key);
+            the_cache.do_set(item);
+        });
+        // get of item with TTL (one clock read to check expiration)
+        size_t num_found = 0;
+        const double ns_get = ns_per_call(num_requests, [&the_cache, &keys, &num_found](size_t n) {
+            const string & k = keys[n % keys.size()];
+            const slice key(k.c_str(), k.size());
+            if (the_cache.do_get(key, calc_hash(key)) != nullptr) {
+                num_found += 1;
+            }
+        });
+        if (num_found != num_requests || time_sum == 0) {
+            throw std::logic_error("Unexpected result");
+        }
+        std::cout << std::setw(10) << mode_name << std::setw(14) << ns_clock
+                  << std::setw(14) << ns_set << std::setw(14) << ns_get << std::endl;
+    }
+
+} // anonymous namespace
+
+
+int main(int /*argc*/, char * /*argv*/[]) {
+    std::vector<string> keys;
+    keys.reserve(num_keys);
+    for (size_t n = 0; n < num_keys; ++n) {
+        keys.push_back("key:" + random_string(10, 30) + std::to_string(n));
+    }
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(10) << "clock" << std::setw(14) << "now() ns"
+              << std::setw(14) << "set ns" << std::setw(14) << "get ns" << std::endl;
+    // warm up
+    run("precise", false, keys);
+    run("cached", true, keys);
+    // measure
+    run("precise", false, keys);
+    run("cached", true, keys);
+    clock_type::set_cached(false);
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <cachelot/common.h>
+#include <cachelot/dict.h>
+#include <cachelot/cache.h>
+#include <cachelot/random.h>
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+//
+// Lookup in the dict of entries referencing their keys by pointer (as Cache does with Items)
+//
+// Every key comparison dereferences the pointer, which is a cache miss for a table larger than the CPU cache.
+// Number of such dereferences per lookup is measured with and without key fingerprints, for the good 32-bit hash
+// and for the weak one (only 16 bits of entropy, e.g. poor hash function supplied by the C API user).
+// Hit has to dereference the found entry anyway, any dereference on miss is wasted
+//
+
+using namespace cachelot;
+
+constexpr size_t num_keys = 2000000;
+constexpr size_t num_lookups = 4000000;
+
+namespace {
+
+    static auto calc_hash = wyhash<uint32>::hasher();
+
+    /// key stored out of the hash table, like the Item
+    struct node {
+        string key;
+    };
+
+    size_t num_dereferences = 0;
+
+    /// dict entry referencing the node, like cache::ItemDictEntry
+    class node_entry {
+    public:
+        node_entry() = default;
+        explicit node_entry(const slice &, const node * the_node) noexcept : m_node(the_node) {}
+
+        const slice key() const noexcept {
+            num_dereferences += 1;
+            return slice(m_node->key.c_str(), m_node->key.size());
+        }
+
+        const node * const & value() const noexcept { return m_node; }
+
+        void swap(node_entry & other) noexcept { std::swap(m_node, other.m_node); }
+
+        static uint32 fingerprint(const slice key) noexcept { return cache::ItemDictEntry::fingerprint(key); }
+
+    private:
+        const node * m_node;
+    };
+
+    inline void swap(node_entry & left, node_entry & right) noexcept { left.swap(right); }
+
+    template <bool KeyFingerprints>
+    struct Options {
+        typedef uint32 size_type;
+        typedef uint32 hash_type;
+        static constexpr size_type max_load_factor_percent = 93;
+        static constexpr bool group_probing = true;
+        static constexpr bool key_fingerprints = KeyFingerprints;
+    };
+
+    uint32 good_hash(const slice key) noexcept { return calc_hash(key); }
+
+    uint32 weak_hash(const slice key) noexcept { return (calc_hash(key) & 0xFFFF) * 0x9E3779B1u; }
+
+    typedef uint32 (*hash_function)(const slice);
+
+    template <bool KeyFingerprints>
+    void run(const char * title, hash_function hash_of, const std::vector<node *> & nodes, const std::vector<string> & missing) {
+        typedef dict<slice, const node *, std::equal_to<slice>, node_entry, Options<KeyFingerprints>> dict_type;
+        dict_type the_dict(roundup_pow2(num_keys * 2));
+        for (const node * n : nodes) {
+            const slice key(n->key.c_str(), n->key.size());
+            bool found; typename dict_type::iterator at;
+            tie(found, at) = the_dict.entry_for(key, hash_of(key));
+            the_dict.insert(at, key, hash_of(key), n);
+        }
+        random_int<size_t> rnd(0, nodes.size() - 1);
+        std::vector<slice> hits, misses;
+        for (size_t n = 0; n < num_lookups; ++n) {
+            const node * hit = nodes[rnd()];
+            hits.emplace_back(hit->key.c_str(), hit->key.size());
+            const string & k = missing[rnd() % missing.size()];
+            misses.emplace_back(k.c_str(), k.size());
+        }
+        std::vector<uint32> hit_hashes, miss_hashes;
+        for (size_t n = 0; n < num_lookups; ++n) {
+            hit_hashes.push_back(hash_of(hits[n]));
+            miss_hashes.push_back(hash_of(misses[n]));
+        }
+        std::cout << std::setw(10) << title << std::setw(14) << (KeyFingerprints ? "yes" : "no");
+        for (const auto * lookups : { &hits, &misses }) {
+            const auto & hashes = lookups == &hits ? hit_hashes : miss_hashes;
+            num_dereferences = 0;
+            size_t num_found = 0;
+            const auto start_time = std::chrono::high_resolution_clock::now();
+            for (size_t n = 0; n < num_lookups; ++n) {
+                if (the_dict.contains((*lookups)[n], hashes[n])) {
+                    num_found += 1;
+                }
+            }
+            const auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_time);
+            if (num_found != (lookups == &hits ? num_lookups : 0)) {
+                throw std::logic_error("Unexpected lookup result");
+            }
+            std::cout << std::setw(14) << std::setprecision(4) << static_cast<double>(num_dereferences) / num_lookups
+                      << std::setw(10) << std::setprecision(1) << static_cast<double>(time_passed.count()) / num_lookups;
+        }
+        std::cout << std::endl;
+    }
+
+} // anonymous namespace
+
+
+int main(int /*argc*/, char * /*argv*/[]) {
+    // nodes are allocated in random order to scatter them over the memory, as Items in the arena
+    std::vector<string> keys;
+    for (size_t n = 0; n < num_keys; ++n) {
+        keys.push_back("key:" + std::to_string(n));
+    }
+    std::random_shuffle(keys.begin(), keys.end());
+    std::vector<node *> nodes;
+    for (const auto & k : keys) {
+        nodes.push_back(new node { k });
+    }
+    std::vector<string> missing;
+    for (size_t n = 0; n < num_keys; ++n) {
+        missing.push_back("missing:" + std::to_string(n));
+    }
+    std::cout << std::fixed << num_keys << " keys, key dereferences and ns per lookup" << std::endl;
+    std::cout << std::setw(10) << "hash" << std::setw(14) << "fingerprints" << std::setw(14) << "hit deref" << std::setw(10) << "hit ns"
+              << std::setw(14) << "miss deref" << std::setw(10) << "miss ns" << std::endl;
+    run<false>("32-bit", good_hash, nodes, missing);
+    run<true>("32-bit", good_hash, nodes, missing);
+    run<false>("16-bit", weak_hash, nodes, missing);
+    run<true>("16-bit", weak_hash, nodes, missing);
+    for (auto n : nodes) {
+        delete n;
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <cachelot/common.h>
+#include <cachelot/memalloc.h>
+#include <cachelot/random.h>
+
+#include <iostream>
+#include <iomanip>
+
+//
+// Allocation throughput under sustained eviction pressure
+//
+// Arena is filled up, then every following allocation has to evict a page sooner or later.
+// Cost of allocation must not depend on the arena size (i.e. on the number of pages),
+// neither when pages are marked by the lock-free readers (`concurrent_reads`)
+//
+
+using namespace cachelot;
+
+constexpr uint32 page_size = 16 * Kilobyte;
+constexpr size_t arena_sizes[] = { 16 * Megabyte, 64 * Megabyte, 256 * Megabyte, 1024 * Megabyte };
+constexpr size_t num_allocations = 4000000;
+constexpr size_t min_allocation_size = 64;
+constexpr size_t max_allocation_size = 1024;
+
+namespace {
+
+    void run(const size_t arena_size, const std::vector<size_t> & sizes, const bool concurrent_reads) {
+        memalloc allocator(arena_size, page_size, memalloc::eviction_policy::page_lru, arena_options(), concurrent_reads);
+        size_t num_evicted = 0;
+        const auto on_evict = [&num_evicted](void *) { num_evicted += 1; };
+        // fill up the arena
+        size_t allocated = 0;
+        for (size_t n = 0; allocated < arena_size; n = (n + 1) % sizes.size()) {
+            if (allocator.alloc_or_evict(sizes[n], true, on_evict) == nullptr) {
+                throw std::logic_error("Allocation failed");
+            }
+            allocated += sizes[n];
+        }
+        num_evicted = 0;
+        // every allocation may cause eviction now
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for (size_t n = 0; n < num_allocations; ++n) {
+            void * mem = allocator.alloc_or_evict(sizes[n % sizes.size()], true, on_evict);
+            if (mem == nullptr) {
+                throw std::logic_error("Allocation failed");
+            }
+            if (concurrent_reads) {
+                // as if the reader has got the item just stored
+                allocator.touch_concurrent(mem);
+            }
+        }
+        auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_time);
+        std::cout << std::setw(12) << (concurrent_reads ? "concurrent" : "exclusive") << std::setw(10) << arena_size / Megabyte << std::setw(10) << arena_size / page_size
+                  << std::setw(12) << static_cast<double>(time_passed.count()) / num_allocations
+                  << std::setw(14) << num_evicted << std::endl;
+    }
+
+} // anonymous namespace
+
+
+int main(int /*argc*/, char * /*argv*/[]) {
+    random_int<size_t> rnd_size(min_allocation_size, max_allocation_size);
+    std::vector<size_t> sizes;
+    sizes.reserve(num_allocations / 4);
+    for (size_t n = 0; n < num_allocations / 4; ++n) {
+        sizes.push_back(rnd_size());
+    }
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(12) << "reads" << std::setw(10) << "arena MB" << std::setw(10) << "pages"
+              << std::setw(12) << "ns/alloc" << std::setw(14) << "evicted" << std::endl;
+    for (const bool concurrent_reads : { false, true }) {
+        for (const auto arena_size : arena_sizes) {
+            run(arena_size, sizes, concurrent_reads);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <cachelot/common.h>
+#include <cachelot/bits.h>
+#include <cachelot/hash_function.h>
+#include <cachelot/random.h>
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+//
+// Benchmark of the hash functions available to the cache
+//
+// Throughput is measured on the memcached-like keys ("user:12345:session", ...)
+// Quality is measured as the distribution of keys over the hash table buckets (the least significant bits),
+// over the cache shards (the most significant bits) and as the number of full collisions
+//
+
+using namespace cachelot;
+
+constexpr size_t num_keys = 1000000;
+constexpr size_t num_rounds = 10;
+constexpr uint32 num_buckets = 1 << 20;
+constexpr uint32 num_shards = 16;
+
+namespace {
+
+    typedef std::vector<string> key_array;
+
+    /// keys of the several realistic shapes: sequential numbers with common prefix and random tokens
+    key_array make_keys() {
+        static const char * const prefixes[] = { "user:", "session:", "product:catalog:item:", "cache:page:/index.html?id=" };
+        key_array keys;
+        keys.reserve(num_keys);
+        random_int<size_t> rnd_prefix(0, sizeof(prefixes) / sizeof(prefixes[0]) - 1);
+        for (size_t n = 0; n < num_keys; ++n) {
+            if (n % 4 == 3) {
+                keys.push_back(prefixes[rnd_prefix()] + random_string(16, 64));
+            } else {
+                keys.push_back(prefixes[rnd_prefix()] + std::to_string(n) + ":" + std::to_string(n % 100));
+            }
+        }
+        return keys;
+    }
+
+    /// ratio of the longest bucket chain to the ideal uniform one
+    double max_to_avg(const std::vector<uint32> & counters) {
+        const double avg = static_cast<double>(num_keys) / counters.size();
+        return *std::max_element(counters.begin(), counters.end()) / avg;
+    }
+
+    void run(const hash_algorithm algorithm, const key_array & keys) {
+        typedef selectable_hasher<uint32> hasher_type;
+        hasher_type::select(algorithm);
+        const hasher_type calc_hash;
+        size_t total_bytes = 0;
+        for (const auto & key : keys) { total_bytes += key.size(); }
+        // throughput
+        uint32 checksum = 0;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for (size_t round = 0; round < num_rounds; ++round) {
+            for (const auto & key : keys) {
+                checksum += calc_hash(slice(key.c_str(), key.size()));
+            }
+        }
+        auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_time);
+        const double ns_per_key = static_cast<double>(time_passed.count()) / (num_keys * num_rounds);
+        const double mb_per_sec = static_cast<double>(total_bytes * num_rounds) / Megabyte / (time_passed.count() / 1e9);
+        // quality
+        std::vector<uint32> buckets(num_buckets, 0);
+        std::vector<uint32> shards(num_shards, 0);
+        std::vector<uint32> hashes;
+        hashes.reserve(num_keys);
+        for (const auto & key : keys) {
+            const uint32 hash = calc_hash(slice(key.c_str(), key.size()));
+            buckets[hash & (num_buckets - 1)] += 1;
+            shards[hash >> (32 - log2u(num_shards))] += 1;
+            hashes.push_back(hash);
+        }
+        std::sort(hashes.begin(), hashes.end());
+        const size_t num_collisions = hashes.size() - static_cast<size_t>(std::unique(hashes.begin(), hashes.end()) - hashes.begin());
+        std::cout << std::setw(8) << hash_algorithm_name(algorithm)
+                  << std::setw(12) << ns_per_key << std::setw(12) << mb_per_sec
+                  << std::setw(14) << max_to_avg(buckets) << std::setw(14) << max_to_avg(shards)
+                  << std::setw(12) << num_collisions
+                  << std::setw(12) << std::hex << checksum << std::dec << std::endl;
+    }
+
+} // anonymous namespace
+
+
+int main(int /*argc*/, char * /*argv*/[]) {
+    const key_array keys = make_keys();
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(8) << "hash" << std::setw(12) << "ns/key" << std::setw(12) << "MB/s"
+              << std::setw(14) << "bucket max" << std::setw(14) << "shard max"
+              << std::setw(12) << "collisions" << std::setw(12) << "checksum" << std::endl;
+    for (auto algorithm : { hash_algorithm::fnv1a, hash_algorithm::crc32c, hash_algorithm::wyhash }) {
+        run(algorithm, keys);
+    }
+    return 0;
+}
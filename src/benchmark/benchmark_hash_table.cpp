@@ -0,0 +1,108 @@
+#include <cachelot/common.h>
+#include <cachelot/hash_table.h>
+#include <cachelot/group_hash_table.h>
+#include <cachelot/hash_fnv1a.h>
+#include <cachelot/random.h>
+
+#include <iostream>
+#include <iomanip>
+
+//
+// Lookup benchmark of the hash table implementations
+//
+// Table is filled up to the given load factor, then existing (hit) and
+// non-existing (miss) keys are searched in random order
+//
+
+using namespace cachelot;
+
+constexpr uint32 table_capacity = 1 << 20;
+constexpr size_t num_lookups = 4000000;
+constexpr uint32 load_factors_percent[] = { 50, 75, 90, 93 };
+
+namespace {
+
+    struct RobinHoodOptions {
+        typedef uint32 size_type;
+        typedef uint32 hash_type;
+        static constexpr size_type max_load_factor_percent = 94;
+        static constexpr bool group_probing = false;
+        static constexpr bool key_fingerprints = false;
+    };
+
+    struct GroupProbingOptions : RobinHoodOptions {
+        static constexpr bool group_probing = true;
+    };
+
+    static auto calc_hash = fnv1a<uint32>::hasher();
+
+    typedef std::vector<string> key_array;
+
+    key_array make_keys(const size_t num_keys, const char * prefix) {
+        key_array keys;
+        keys.reserve(num_keys);
+        for (size_t n = 0; n < num_keys; ++n) {
+            keys.push_back(prefix + random_string(10, 30) + std::to_string(n));
+        }
+        return keys;
+    }
+
+    key_array shuffled_lookups(const key_array & keys) {
+        key_array result;
+        result.reserve(num_lookups);
+        random_int<size_t> rnd(0, keys.size() - 1);
+        for (size_t n = 0; n < num_lookups; ++n) {
+            result.push_back(keys[rnd()]);
+        }
+        return result;
+    }
+
+    template <class Table>
+    double ns_per_lookup(const Table & table, const key_array & lookups, const bool expect_found) {
+        size_t num_found = 0;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for (const auto & key : lookups) {
+            const slice k(key.c_str(), key.size());
+            if (table.contains(k, calc_hash(k))) {
+                num_found += 1;
+            }
+        }
+        auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_time);
+        if (num_found != (expect_found ? lookups.size() : 0)) {
+            throw std::logic_error("Unexpected lookup result");
+        }
+        return static_cast<double>(time_passed.count()) / lookups.size();
+    }
+
+    template <class Options>
+    void run(const char * name, const key_array & keys, const key_array & missing_keys) {
+        typedef hash_table<slice, const char *, std::equal_to<slice>, internal::hash_table_entry<slice, const char *>, Options> robin_hood_table;
+        typedef group_hash_table<slice, const char *, std::equal_to<slice>, internal::hash_table_entry<slice, const char *>, Options> group_table;
+        typedef typename std::conditional<Options::group_probing, group_table, robin_hood_table>::type table_type;
+        for (const auto load_factor : load_factors_percent) {
+            std::unique_ptr<table_type> table(new table_type(table_capacity));
+            const size_t num_keys = static_cast<size_t>(table_capacity) * load_factor / 100;
+            key_array stored(keys.begin(), keys.begin() + static_cast<std::ptrdiff_t>(num_keys));
+            for (const auto & key : stored) {
+                const slice k(key.c_str(), key.size());
+                table->put(k, calc_hash(k), key.c_str());
+            }
+            const double hit = ns_per_lookup(*table, shuffled_lookups(stored), true);
+            const double miss = ns_per_lookup(*table, shuffled_lookups(missing_keys), false);
+            std::cout << std::setw(12) << name << std::setw(8) << load_factor << '%'
+                      << std::setw(12) << hit << std::setw(12) << miss << std::endl;
+        }
+    }
+
+} // anonymous namespace
+
+
+int main(int /*argc*/, char * /*argv*/[]) {
+    const key_array keys = make_keys(table_capacity, "key:");
+    const key_array missing_keys = make_keys(table_capacity / 4, "missing:");
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(12) << "table" << std::setw(9) << "load" << std::setw(12) << "hit ns" << std::setw(12) << "miss ns" << std::endl;
+    run<RobinHoodOptions>("robin hood", keys, missing_keys);
+    run<GroupProbingOptions>("group", keys, missing_keys);
+    return 0;
+}
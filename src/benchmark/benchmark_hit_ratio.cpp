@@ -0,0 +1,128 @@
+#include <cachelot/common.h>
+#include <cachelot/cache.h>
+#include <cachelot/random.h>
+
+#include <iostream>
+#include <iomanip>
+
+//
+// Hit ratio of the eviction policies
+//
+// Cache-aside trace: every key is requested with `get`, missing keys are stored with `set`.
+// Keys follow the Zipf distribution, cache holds only a fraction of them.
+// Every policy replays exactly the same trace, with and without the TinyLFU admission filter
+//
+
+using namespace cachelot;
+
+constexpr size_t num_keys = 1000000;
+constexpr size_t num_requests = 5000000;
+constexpr size_t cache_memory = 64 * Megabyte;
+constexpr size_t page_size = 1 * Megabyte;
+constexpr size_t hash_initial = 262144;
+constexpr uint32 min_value_len = 16;
+constexpr uint32 max_value_len = 1024;
+constexpr double zipf_skews[] = { 0.8, 0.99, 1.2 };
+// fraction of requests to the keys which are never requested again (scans, batch jobs)
+constexpr double one_hit_fractions[] = { 0.0, 0.3 };
+
+namespace {
+
+    static auto calc_hash = cache::HashFunction();
+
+    struct trace_type {
+        std::vector<string> keys;
+        std::vector<uint32> value_lengths;
+        std::vector<uint32> requests;
+    };
+
+    trace_type make_trace(const double skew, const double one_hit_fraction) {
+        trace_type trace;
+        random_int<uint32> rnd_length(min_value_len, max_value_len);
+        const auto add_key = [&trace, &rnd_length](const string & prefix) -> uint32 {
+            trace.keys.push_back(prefix + std::to_string(trace.keys.size()));
+            trace.value_lengths.push_back(rnd_length());
+            return static_cast<uint32>(trace.keys.size() - 1);
+        };
+        for (size_t n = 0; n < num_keys; ++n) {
+            add_key("key:");
+        }
+        // popularity must not correlate with the key number (insertion order)
+        std::vector<uint32> rank_to_key(num_keys);
+        for (uint32 n = 0; n < num_keys; ++n) { rank_to_key[n] = n; }
+        std::shuffle(rank_to_key.begin(), rank_to_key.end(), std::minstd_rand());
+        random_zipf zipf(num_keys, skew);
+        random_int<uint32> rnd_percent(0, 99);
+        trace.requests.reserve(num_requests);
+        for (size_t n = 0; n < num_requests; ++n) {
+            if (rnd_percent() < one_hit_fraction * 100) {
+                trace.requests.push_back(add_key("once:"));
+            } else {
+                trace.requests.push_back(rank_to_key[zipf()]);
+            }
+        }
+        return trace;
+    }
+
+    double hit_ratio(const trace_type & trace, const cache::EvictionPolicy policy, const bool admission_filter = false) {
+        static const string value_data(max_value_len, 'x');
+        auto the_cache = cache::Cache::Create(cache_memory, page_size, hash_initial, true, policy, admission_filter);
+        // the first half of the trace warms up the cache
+        const size_t warmup = trace.requests.size() / 2;
+        size_t num_hits = 0;
+        for (size_t n = 0; n < trace.requests.size(); ++n) {
+            const auto key_no = trace.requests[n];
+            const slice key(trace.keys[key_no].c_str(), trace.keys[key_no].size());
+            const auto hash = calc_hash(key);
+            if (the_cache.do_get(key, hash) != nullptr) {
+                num_hits += n >= warmup ? 1 : 0;
+            } else {
+                try {
+                    auto item = the_cache.create_item(key, hash, trace.value_lengths[key_no], 0, cache::Item::infinite_TTL);
+                    item->assign_value(slice(value_data.c_str(), trace.value_lengths[key_no]));
+                    the_cache.do_set(item);
+                } catch (const system_error &) {
+                    // rejected by the admission filter
+                }
+            }
+        }
+        return 100.0 * num_hits / (trace.requests.size() - warmup);
+    }
+
+} // anonymous namespace
+
+
+int main(int /*argc*/, char * /*argv*/[]) {
+    struct policy_config {
+        const char * name;
+        cache::EvictionPolicy policy;
+        bool admission_filter;
+    };
+    const policy_config configs[] = {
+        { "page lru",    cache::EvictionPolicy::page_lru,    false },
+        { "value aware", cache::EvictionPolicy::value_aware, false },
+        { "page slru",   cache::EvictionPolicy::page_slru,   false },
+        { "page clock",  cache::EvictionPolicy::page_clock,  false },
+        { "page fifo",   cache::EvictionPolicy::page_fifo,   false },
+        { "item clock",  cache::EvictionPolicy::item_clock,  false },
+        { "lru+tlfu",    cache::EvictionPolicy::page_lru,    true },
+        { "clock+tlfu",  cache::EvictionPolicy::item_clock,  true }
+    };
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(8) << "skew" << std::setw(10) << "one-hit";
+    for (const auto & config : configs) {
+        std::cout << std::setw(13) << config.name;
+    }
+    std::cout << std::endl;
+    for (const auto one_hit_fraction : one_hit_fractions) {
+        for (const auto skew : zipf_skews) {
+            const auto trace = make_trace(skew, one_hit_fraction);
+            std::cout << std::setw(8) << skew << std::setw(9) << one_hit_fraction * 100 << '%';
+            for (const auto & config : configs) {
+                std::cout << std::setw(12) << hit_ratio(trace, config.policy, config.admission_filter) << '%' << std::flush;
+            }
+            std::cout << std::endl;
+        }
+    }
+    return 0;
+}
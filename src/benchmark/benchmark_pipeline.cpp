@@ -0,0 +1,191 @@
+#include <cachelot/common.h>
+#include <cachelot/sharded_cache.h>
+#include <server/memcached/conversation.h>
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <thread>
+#include <dlfcn.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+//
+// Pipelined requests benchmark
+//
+// Client sends `depth` memcached requests at once and waits for all the replies.
+// Socket syscalls of the server reactor are counted by the interposed libc functions
+// used by boost::asio (client uses plain `read` / `write` which are not counted)
+//
+
+using namespace cachelot;
+
+constexpr size_t num_requests = 200000;
+constexpr size_t num_keys = 10000;
+constexpr size_t value_length = 32;
+constexpr size_t pipeline_depths[] = { 1, 2, 5, 10, 20, 50, 100 };
+
+namespace {
+
+    std::atomic<uint64> num_recv(0);
+    std::atomic<uint64> num_send(0);
+    std::atomic<uint64> num_epoll_wait(0);
+
+    template <typename Function>
+    Function real_function(const char * name) {
+        return reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+    }
+
+    inline uint64 num_syscalls() noexcept {
+        return num_recv.load() + num_send.load() + num_epoll_wait.load();
+    }
+
+} // anonymous namespace
+
+
+extern "C" {
+
+    ssize_t recv(int fd, void * buf, size_t len, int flags) {
+        static const auto real_recv = real_function<ssize_t (*)(int, void *, size_t, int)>("recv");
+        num_recv.fetch_add(1, std::memory_order_relaxed);
+        return real_recv(fd, buf, len, flags);
+    }
+
+    ssize_t send(int fd, const void * buf, size_t len, int flags) {
+        static const auto real_send = real_function<ssize_t (*)(int, const void *, size_t, int)>("send");
+        num_send.fetch_add(1, std::memory_order_relaxed);
+        return real_send(fd, buf, len, flags);
+    }
+
+    ssize_t recvmsg(int fd, struct msghdr * msg, int flags) {
+        static const auto real_recvmsg = real_function<ssize_t (*)(int, struct msghdr *, int)>("recvmsg");
+        num_recv.fetch_add(1, std::memory_order_relaxed);
+        return real_recvmsg(fd, msg, flags);
+    }
+
+    ssize_t sendmsg(int fd, const struct msghdr * msg, int flags) {
+        static const auto real_sendmsg = real_function<ssize_t (*)(int, const struct msghdr *, int)>("sendmsg");
+        num_send.fetch_add(1, std::memory_order_relaxed);
+        return real_sendmsg(fd, msg, flags);
+    }
+
+    int epoll_wait(int epfd, struct epoll_event * events, int maxevents, int timeout) {
+        static const auto real_epoll_wait = real_function<int (*)(int, struct epoll_event *, int, int)>("epoll_wait");
+        num_epoll_wait.fetch_add(1, std::memory_order_relaxed);
+        return real_epoll_wait(epfd, events, maxevents, timeout);
+    }
+
+} // extern "C"
+
+
+class Client {
+public:
+    explicit Client(const uint16 port) : m_fd(::socket(AF_INET, SOCK_STREAM, 0)) {
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (m_fd < 0 || ::connect(m_fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+            throw std::runtime_error("failed to connect");
+        }
+    }
+
+    ~Client() { ::close(m_fd); }
+
+    // send the whole batch of requests and read `reply_length` bytes of the replies
+    void roundtrip(const string & requests, const size_t reply_length) {
+        size_t sent = 0;
+        while (sent < requests.size()) {
+            auto n = ::write(m_fd, requests.data() + sent, requests.size() - sent);
+            if (n <= 0) { throw std::runtime_error("write failed"); }
+            sent += static_cast<size_t>(n);
+        }
+        m_reply.resize(reply_length);
+        size_t received = 0;
+        while (received < reply_length) {
+            auto n = ::read(m_fd, &m_reply[received], reply_length - received);
+            if (n <= 0) { throw std::runtime_error("read failed"); }
+            received += static_cast<size_t>(n);
+        }
+    }
+
+private:
+    int m_fd;
+    string m_reply;
+};
+
+
+static string key_of(const size_t n) {
+    return "key:" + std::to_string(n);
+}
+
+
+static const string the_value(value_length, 'v');
+
+
+// build `depth` requests (`set` and `get` interleaved) starting with the request number `first`
+static std::tuple<string, size_t> make_batch(const size_t first, const size_t depth) {
+    string requests; size_t reply_length = 0;
+    for (size_t n = first; n < first + depth; ++n) {
+        const auto key = key_of(n % num_keys);
+        if (n % 2 == 0) {
+            requests += "set " + key + " 0 0 " + std::to_string(value_length) + "\r\n" + the_value + "\r\n";
+            reply_length += std::strlen("STORED\r\n");
+        } else {
+            // key is always set by the preceding request
+            const auto key_set = key_of((n - 1) % num_keys);
+            requests += "get " + key_set + "\r\n";
+            reply_length += ("VALUE " + key_set + " 0 " + std::to_string(value_length) + "\r\n" + the_value + "\r\nEND\r\n").size();
+        }
+    }
+    return std::make_tuple(requests, reply_length);
+}
+
+
+int main(int /*argc*/, char * /*argv*/[]) {
+    try {
+        auto the_cache = cache::ShardedCache::Create(1, 64 * Megabyte, 1 * Megabyte, 65536, true);
+        net::reactor_pool reactors(1);
+        memcached::TcpServer server(the_cache, reactors);
+        server.start(net::tcp::endpoint(net::ip::address_v4::loopback(), 0));
+        const uint16 port = server.local_endpoint().port();
+        std::thread server_thread([&reactors]() { reactors.run(); });
+
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << std::setw(8) << "depth" << std::setw(14) << "rps" << std::setw(12) << "recv/r"
+                  << std::setw(12) << "send/r" << std::setw(12) << "epoll/r" << std::setw(14) << "syscalls/r" << std::endl;
+        for (const auto depth : pipeline_depths) {
+            Client client(port);
+            const uint64 recv_before = num_recv.load(), send_before = num_send.load(), epoll_before = num_epoll_wait.load();
+            const uint64 syscalls_before = num_syscalls();
+            auto start_time = std::chrono::high_resolution_clock::now();
+            size_t done = 0;
+            while (done < num_requests) {
+                string requests; size_t reply_length;
+                std::tie(requests, reply_length) = make_batch(done, depth);
+                client.roundtrip(requests, reply_length);
+                done += depth;
+            }
+            auto time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_time);
+            const double sec = static_cast<double>(time_passed.count()) / 1000000000;
+            const double per_request = 1.0 / static_cast<double>(done);
+            std::cout << std::setw(8) << depth
+                      << std::setw(14) << static_cast<double>(done) / sec
+                      << std::setw(12) << static_cast<double>(num_recv.load() - recv_before) * per_request
+                      << std::setw(12) << static_cast<double>(num_send.load() - send_before) * per_request
+                      << std::setw(12) << static_cast<double>(num_epoll_wait.load() - epoll_before) * per_request
+                      << std::setw(14) << static_cast<double>(num_syscalls() - syscalls_before) * per_request << std::endl;
+        }
+
+        reactors.stop();
+        server_thread.join();
+        return 0;
+    } catch (const std::exception & e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,73 @@
+#include <cachelot/common.h>
+#include <cachelot/cache.h>
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+//
+// Latency of `set` requests while the hash table grows
+//
+// Keys are inserted into the Cache with the small initial hash table, so it expands several times.
+// Inline rehash moves items by the requests, background rehash leaves it to the idle time
+// (do_background_work() is called every `requests_per_idle` requests, outside of the measured time).
+// With background rehash tail latency during growth must be the same as in the steady state
+//
+
+using namespace cachelot;
+
+constexpr size_t num_keys = 4000000;
+constexpr size_t cache_memory = 512 * Megabyte;
+constexpr size_t page_size = 1 * Megabyte;
+constexpr size_t hash_initial = 1024;
+constexpr size_t requests_per_idle = 64;
+constexpr auto idle_time_budget = std::chrono::microseconds(100);
+constexpr double percentiles[] = { 50.0, 99.0, 99.9, 99.99 };
+
+namespace {
+
+    static auto calc_hash = fnv1a<cache::Cache::hash_type>::hasher();
+
+    void run(const char * title, const bool background_rehash, const std::vector<string> & keys) {
+        auto the_cache = cache::Cache::Create(cache_memory, page_size, hash_initial, true, cache::EvictionPolicy::page_lru,
+                                              false, true, 0, cache::ArenaOptions(), false, background_rehash);
+        std::vector<uint64> latency;
+        latency.reserve(keys.size());
+        for (size_t n = 0; n < keys.size(); ++n) {
+            const slice key(keys[n].c_str(), keys[n].length());
+            const auto hash = calc_hash(key);
+            const auto started = std::chrono::high_resolution_clock::now();
+            the_cache.do_set(the_cache.create_item(key, hash, key, 0, cache::Item::infinite_TTL));
+            latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - started).count());
+            if (n % requests_per_idle == 0) {
+                the_cache.do_background_work(idle_time_budget);
+            }
+        }
+        std::sort(latency.begin(), latency.end());
+        std::cout << std::setw(12) << title;
+        for (const auto p : percentiles) {
+            const size_t at = std::min(static_cast<size_t>(latency.size() * p / 100.0), latency.size() - 1);
+            std::cout << std::setw(12) << latency[at];
+        }
+        std::cout << std::setw(12) << latency.back() << std::endl;
+    }
+
+} // anonymous namespace
+
+
+int main(int /*argc*/, char * /*argv*/[]) {
+    std::vector<string> keys;
+    keys.reserve(num_keys);
+    for (size_t n = 0; n < num_keys; ++n) {
+        keys.push_back("key:" + std::to_string(n));
+    }
+    std::cout << "`set` latency of " << num_keys << " keys while hash table grows from " << hash_initial << " entries, ns" << std::endl;
+    std::cout << std::setw(12) << "rehash";
+    for (const auto p : percentiles) {
+        std::cout << std::setw(11) << p << '%';
+    }
+    std::cout << std::setw(12) << "max" << std::endl;
+    run("inline", false, keys);
+    run("background", true, keys);
+    return 0;
+}
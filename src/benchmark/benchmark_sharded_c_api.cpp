@@ -0,0 +1,136 @@
+#include <cachelot/common.h>
+#include <cachelot/c_api.h>
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <random>
+
+//
+// Throughput of the C API used by several threads at once
+//
+// Single cache behind a global mutex (the only way to share the `cachelot_*` API between threads)
+// is compared to the thread safe `cachelot_sharded_*` API.
+// Sharded `get` doesn't take the lock, so the single shard shows the scalability of the lock-free reads alone.
+// Every thread runs the mix of `get` and `set` requests to the random keys
+//
+
+using namespace cachelot;
+
+constexpr size_t num_keys = 200000;
+constexpr size_t requests_per_thread = 1000000;
+constexpr size_t cache_memory = 256 * Megabyte;
+constexpr size_t page_size = 1 * Megabyte;
+constexpr size_t hash_initial = 262144;
+constexpr size_t value_length = 64;
+constexpr unsigned get_percent = 90;
+constexpr size_t num_threads[] = { 1, 2, 4, 8, 16 };
+
+namespace {
+
+    std::vector<CachelotItemKey> make_keys(std::vector<string> & key_storage) {
+        std::vector<CachelotItemKey> keys;
+        key_storage.reserve(num_keys);
+        keys.reserve(num_keys);
+        for (size_t n = 0; n < num_keys; ++n) {
+            key_storage.push_back("key:" + std::to_string(n));
+            const string & k = key_storage.back();
+            keys.push_back(CachelotItemKey { k.c_str(), k.size(), cachelot_hash(k.c_str(), k.size()) });
+        }
+        return keys;
+    }
+
+    const CachelotOptions cache_options = { cache_memory, page_size, hash_initial, true, false, false, 0 };
+    const string value_data(value_length, 'x');
+
+
+    /// run `requests_per_thread` requests in every of the `thread_count` threads, return requests per second
+    template <typename Get, typename Set>
+    double run_threads(const size_t thread_count, const std::vector<CachelotItemKey> & keys, Get get, Set set) {
+        std::atomic<bool> start(false);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&start, &keys, get, set, t]() {
+                // random_int shares the engine among threads, every thread needs its own
+                std::minstd_rand random_engine(static_cast<std::minstd_rand::result_type>(t + 1));
+                std::uniform_int_distribution<size_t> rnd_key(0, keys.size() - 1);
+                std::uniform_int_distribution<unsigned> rnd_percent(0, 99);
+                char buffer[value_length];
+                while (not start.load()) {
+                    std::this_thread::yield();
+                }
+                for (size_t n = 0; n < requests_per_thread; ++n) {
+                    const auto & key = keys[rnd_key(random_engine)];
+                    if (rnd_percent(random_engine) < get_percent) {
+                        get(key, buffer);
+                    } else {
+                        set(key);
+                    }
+                }
+            });
+        }
+        const auto started = std::chrono::high_resolution_clock::now();
+        start.store(true);
+        for (auto & thread : threads) {
+            thread.join();
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - started;
+        return thread_count * requests_per_thread / elapsed.count();
+    }
+
+
+    double global_mutex_throughput(const size_t thread_count, const std::vector<CachelotItemKey> & keys) {
+        CachelotPtr c = cachelot_init(cache_options, nullptr);
+        std::mutex global_lock;
+        const auto get = [c, &global_lock](const CachelotItemKey & key, char * buffer) {
+            std::lock_guard<std::mutex> _(global_lock);
+            CachelotConstItemPtr item = cachelot_get_unsafe(c, key, nullptr);
+            if (item != nullptr) {
+                std::memcpy(buffer, cachelot_item_get_value(item), cachelot_item_get_valuelen(item));
+            }
+        };
+        const auto set = [c, &global_lock](const CachelotItemKey & key) {
+            std::lock_guard<std::mutex> _(global_lock);
+            CachelotItemPtr item = cachelot_create_item_raw(c, key, value_data.c_str(), value_data.size(), nullptr);
+            cachelot_set(c, item, nullptr);
+        };
+        const double result = run_threads(thread_count, keys, get, set);
+        cachelot_destroy(c);
+        return result;
+    }
+
+
+    double sharded_throughput(const size_t thread_count, const size_t num_shards, const std::vector<CachelotItemKey> & keys) {
+        CachelotShardedPtr c = cachelot_init_sharded(cache_options, num_shards, nullptr);
+        const auto get = [c](const CachelotItemKey & key, char * buffer) {
+            size_t valuelen;
+            cachelot_sharded_get(c, key, buffer, value_length, &valuelen, nullptr);
+        };
+        const auto set = [c](const CachelotItemKey & key) {
+            cachelot_sharded_set(c, key, value_data.c_str(), value_data.size(), cachelot_infinite_TTL, nullptr);
+        };
+        const double result = run_threads(thread_count, keys, get, set);
+        cachelot_destroy_sharded(c);
+        return result;
+    }
+
+} // anonymous namespace
+
+
+int main(int /*argc*/, char * /*argv*/[]) {
+    std::vector<string> key_storage;
+    const auto keys = make_keys(key_storage);
+    std::cout << "Mrequests/s, " << get_percent << "% get / " << 100 - get_percent << "% set" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "global mutex" << std::setw(16) << "1 shard" << std::setw(16) << "16 shards" << std::setw(16) << "64 shards" << std::endl;
+    for (const auto thread_count : num_threads) {
+        std::cout << std::setw(8) << thread_count << std::flush;
+        std::cout << std::setw(16) << global_mutex_throughput(thread_count, keys) / 1e6 << std::flush;
+        std::cout << std::setw(16) << sharded_throughput(thread_count, 1, keys) / 1e6 << std::flush;
+        std::cout << std::setw(16) << sharded_throughput(thread_count, 16, keys) / 1e6 << std::flush;
+        std::cout << std::setw(16) << sharded_throughput(thread_count, 64, keys) / 1e6 << std::endl;
+    }
+    return 0;
+}
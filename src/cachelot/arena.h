@@ -0,0 +1,168 @@
+#ifndef CACHELOT_ARENA_H_INCLUDED
+#define CACHELOT_ARENA_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+#ifndef CACHELOT_STATS_H_INCLUDED
+#  include <cachelot/stats.h>
+#endif
+
+#if defined(HAVE_MMAP)
+#  include <sys/mman.h>
+#endif
+#if defined(HAVE_SYS_MBIND)
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#  include <linux/mempolicy.h> // MPOL_BIND
+#endif
+#include <cerrno>
+#include <system_error>
+
+namespace cachelot {
+
+    /// @addtogroup memalloc
+    /// @{
+
+    /// How the memory of the allocator arena is obtained from the OS
+    struct arena_options {
+        /// back the arena by huge pages to save TLB misses on random access:
+        /// explicit ones (`MAP_HUGETLB`) if the system has enough of them reserved, transparent ones (`MADV_HUGEPAGE`) otherwise
+        bool huge_pages = false;
+        /// bind the arena memory to the NUMA node (`-1` - default memory policy)
+        int numa_node = -1;
+    };
+
+
+    namespace internal {
+
+        /// releases the arena depending on how it was allocated
+        struct arena_deleter {
+            size_t mapped_size; // `0` if arena is allocated on the heap
+            void operator()(void * memory) const noexcept {
+            #if defined(HAVE_MMAP)
+                if (mapped_size > 0) {
+                    munmap(memory, mapped_size);
+                    return;
+                }
+            #endif
+                std::free(memory);
+            }
+        };
+
+    #if defined(HAVE_MMAP)
+        /// size of huge page on the most of platforms (explicit huge pages are only used if arena is a multiple of it)
+        constexpr size_t default_huge_page_size = 2 * 1024 * 1024;
+
+        /// map `size` bytes aligned to the `alignment` boundary, mapping is naturally aligned to `natural_alignment`
+        inline void * map_aligned(const size_t size, const size_t alignment, const size_t natural_alignment, const int flags) noexcept {
+            const size_t extra = alignment > natural_alignment ? alignment : 0;
+            void * mapped = mmap(nullptr, size + extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+            if (mapped == MAP_FAILED) {
+                return nullptr;
+            }
+            // trim the unaligned head and the rest of the tail
+            auto begin = reinterpret_cast<uint8 *>(mapped);
+            auto aligned = reinterpret_cast<uint8 *>((reinterpret_cast<uintptr_t>(begin) + alignment - 1) & ~(uintptr_t(alignment) - 1));
+            if (aligned > begin) {
+                munmap(begin, aligned - begin);
+            }
+            if (begin + size + extra > aligned + size) {
+                munmap(aligned + size, (begin + size + extra) - (aligned + size));
+            }
+            return aligned;
+        }
+    #endif
+
+    #if defined(HAVE_SYS_MBIND)
+        /// bind memory to the NUMA node (`mbind` syscall is used directly, so there is no dependency on libnuma)
+        inline void bind_to_numa_node(void * memory, const size_t size, const int node) {
+            constexpr size_t bits_per_word = sizeof(unsigned long) * 8;
+            std::vector<unsigned long> node_mask(static_cast<size_t>(node) / bits_per_word + 1, 0);
+            node_mask[static_cast<size_t>(node) / bits_per_word] |= 1ul << (static_cast<size_t>(node) % bits_per_word);
+            // kernel counts `maxnode - 1` bits
+            const unsigned long max_node = node_mask.size() * bits_per_word + 1;
+            if (syscall(SYS_mbind, memory, size, MPOL_BIND, node_mask.data(), max_node, 0) != 0) {
+                throw std::system_error(errno, std::system_category(), "failed to bind memory to the NUMA node " + std::to_string(node));
+            }
+        }
+    #endif
+
+    } // namespace internal
+
+
+    typedef std::unique_ptr<void, internal::arena_deleter> arena_ptr;
+
+    /**
+     * Allocate `size` bytes of the arena aligned to the `alignment` boundary
+     *
+     * Huge pages are best effort: explicit ones are tried first, then transparent ones, then regular pages are used.
+     * Amount of memory backed by huge pages is reported by the `mem.hugetlb_bytes` and `mem.thp_advised_bytes` stats.
+     * Failure to bind memory to the requested NUMA node is an error.
+     * @note memory is bound before it's touched, so it is not faulted on the local node first
+     */
+    inline arena_ptr allocate_arena(const size_t size, const size_t alignment, const arena_options & options) {
+        STAT_SET(mem.hugetlb_bytes, 0);
+        STAT_SET(mem.thp_advised_bytes, 0);
+        STAT_SET(mem.numa_bound, false);
+        if (not options.huge_pages && options.numa_node < 0) {
+            arena_ptr arena(aligned_alloc(alignment, size), internal::arena_deleter { 0 });
+            if (not arena) {
+                throw std::bad_alloc();
+            }
+            return arena;
+        }
+    #if defined(HAVE_MMAP)
+        using namespace internal;
+        arena_ptr arena(nullptr, arena_deleter { size });
+        #if defined(HAVE_MAP_HUGETLB)
+        if (options.huge_pages && size % default_huge_page_size == 0) {
+            arena.reset(map_aligned(size, alignment, default_huge_page_size, MAP_HUGETLB));
+            if (arena) {
+                STAT_SET(mem.hugetlb_bytes, size);
+            }
+        }
+        #endif
+        if (not arena) {
+            // transparent huge page must be aligned to its size
+            const size_t mapping_alignment = options.huge_pages ? std::max(alignment, default_huge_page_size) : alignment;
+            arena.reset(map_aligned(size, mapping_alignment, 4096, 0));
+            if (not arena) {
+                throw std::bad_alloc();
+            }
+            #if defined(HAVE_MADV_HUGEPAGE)
+            if (options.huge_pages && madvise(arena.get(), size, MADV_HUGEPAGE) == 0) {
+                STAT_SET(mem.thp_advised_bytes, size);
+            }
+            #endif
+        }
+        if (options.numa_node >= 0) {
+        #if defined(HAVE_SYS_MBIND)
+            bind_to_numa_node(arena.get(), size, options.numa_node);
+            STAT_SET(mem.numa_bound, true);
+        #else
+            throw std::invalid_argument("binding memory to the NUMA node is not supported on this platform");
+        #endif
+        }
+        return arena;
+    #else
+        if (options.numa_node >= 0) {
+            throw std::invalid_argument("binding memory to the NUMA node is not supported on this platform");
+        }
+        // huge pages are not available, fallback to the regular memory
+        arena_ptr arena(aligned_alloc(alignment, size), internal::arena_deleter { 0 });
+        if (not arena) {
+            throw std::bad_alloc();
+        }
+        return arena;
+    #endif
+    }
+
+    /// @}
+
+} // namespace cachelot
+
+#endif // CACHELOT_ARENA_H_INCLUDED
@@ -7,6 +7,7 @@
 #include <cachelot/common.h>
 #include <cachelot/c_api.h>
 #include <cachelot/cache.h>
+#include <cachelot/sharded_cache.h>
 #include <cachelot/version.h>
 
 
@@ -24,6 +25,11 @@ extern "C" {
     };
 
 
+    struct cachelot_sharded_t {
+        cache::ShardedCache cache;
+    };
+
+
 
     struct cachelot_item_t {
         unsigned char __filler[sizeof(cache::Item)];
@@ -71,9 +77,21 @@ extern "C" {
     }
 
 
+    inline cache::ArenaOptions arena_options_from(const CachelotOptions & opts) {
+        if (opts.bind_to_numa_node && opts.numa_node > static_cast<unsigned>(std::numeric_limits<int>::max())) {
+            throw std::invalid_argument("numa_node is too big");
+        }
+        cache::ArenaOptions arena;
+        arena.huge_pages = opts.huge_pages;
+        arena.numa_node = opts.bind_to_numa_node ? static_cast<int>(opts.numa_node) : -1;
+        return arena;
+    }
+
+
     CachelotPtr cachelot_init(CachelotOptions opts, CachelotError * out_error) {
         try {
-            cachelot_t * c = new cachelot_t{cache::Cache::Create(opts.memory_limit, opts.mem_page_size, opts.initial_dict_size, opts.enable_evictions)};
+            cachelot_t * c = new cachelot_t{cache::Cache::Create(opts.memory_limit, opts.mem_page_size, opts.initial_dict_size, opts.enable_evictions,
+                                                                 cache::EvictionPolicy::page_lru, false, true, 0, arena_options_from(opts))};
             return c;
         } catch (const system_error & e) {
             system_error_to_err_struct(e, out_error);
@@ -95,7 +113,13 @@ extern "C" {
 
     CachelotItemPtr cachelot_create_item_raw(CachelotPtr c, CachelotItemKey k, const char * value, size_t valuelen, CachelotError * out_error) {
         try {
-            auto new_item = c->cache.create_item(slice(k.key, k.keylen), k.hash, valuelen, 0, cache::Item::infinite_TTL);
+            // TTL may be assigned later by `cachelot_item_set_ttl_seconds`
+            const bool mutable_ttl = true;
+            // value of the item is given to the user as a contiguous memory
+            if (c->cache.is_chained_item(slice(k.key, k.keylen), valuelen, 0, cache::Item::infinite_TTL, mutable_ttl)) {
+                throw system_error(error::item_too_big);
+            }
+            auto new_item = c->cache.create_item(slice(k.key, k.keylen), k.hash, valuelen, 0, cache::Item::infinite_TTL, mutable_ttl);
             new_item->assign_value(slice(value, valuelen));
             return reinterpret_cast<CachelotItemPtr>(new_item);
         } catch (const system_error & e) {
@@ -185,6 +209,29 @@ extern "C" {
     }
 
 
+    bool cachelot_get_multi(CachelotPtr c, const CachelotItemKey * k, size_t count, CachelotConstItemPtr * out_items, CachelotError * out_error) {
+        try {
+            std::vector<slice> keys; keys.reserve(count);
+            std::vector<cache::hash_type> hashes; hashes.reserve(count);
+            for (size_t n = 0; n < count; ++n) {
+                keys.emplace_back(k[n].key, k[n].keylen);
+                hashes.push_back(k[n].hash);
+            }
+            static_assert(sizeof(CachelotConstItemPtr) == sizeof(cache::ConstItemPtr), "Item pointers must be interchangeable");
+            c->cache.do_get_batch(keys.data(), hashes.data(), count, reinterpret_cast<cache::ConstItemPtr *>(out_items));
+            none_error(out_error);
+            return true;
+        } catch (const system_error & e) {
+            system_error_to_err_struct(e, out_error);
+        } catch(const std::exception & e) {
+            std_exception_to_err_struct(e, out_error);
+        } catch (...) {
+            unknown_exception_to_err_struct(out_error);
+        }
+        return false;
+    }
+
+
     bool cachelot_add(CachelotPtr c, CachelotItemPtr i, CachelotError * out_error) {
         try {
             auto item = reinterpret_cast<cache::ItemPtr>(i);
@@ -355,5 +402,183 @@ extern "C" {
     }
 
 
+    CachelotShardedPtr cachelot_init_sharded(CachelotOptions opts, size_t num_shards, CachelotError * out_error) {
+        try {
+            cachelot_sharded_t * c = new cachelot_sharded_t{cache::ShardedCache::Create(num_shards, opts.memory_limit, opts.mem_page_size, opts.initial_dict_size, opts.enable_evictions,
+                                                                                         cache::EvictionPolicy::page_lru, false, true, 0, arena_options_from(opts), true)};
+            return c;
+        } catch (const system_error & e) {
+            system_error_to_err_struct(e, out_error);
+        } catch(const std::exception & e) {
+            std_exception_to_err_struct(e, out_error);
+        } catch (...) {
+            unknown_exception_to_err_struct(out_error);
+        }
+        return nullptr;
+    }
+
+
+    void cachelot_destroy_sharded(CachelotShardedPtr c) {
+        if (c != nullptr) {
+            delete c;
+        }
+    }
+
+
+    typedef bool (*sharded_store_operation)(cache::Cache &, cache::ItemPtr);
+
+    // create Item holding a copy of the `value` and pass it to the store operation of its shard
+    inline bool sharded_store(CachelotShardedPtr c, CachelotItemKey k, const char * value, size_t valuelen, uint32_t keepalive_sec, CachelotError * out_error, sharded_store_operation store) {
+        try {
+            auto shard = c->cache.lock_shard_for(k.hash);
+            auto new_item = shard->create_item(slice(k.key, k.keylen), k.hash, slice(value, valuelen), 0, cache::seconds(keepalive_sec));
+            auto ret = store(*shard, new_item);
+            none_error(out_error);
+            return ret;
+        } catch (const system_error & e) {
+            system_error_to_err_struct(e, out_error);
+        } catch(const std::exception & e) {
+            std_exception_to_err_struct(e, out_error);
+        } catch (...) {
+            unknown_exception_to_err_struct(out_error);
+        }
+        return false;
+    }
+
+
+    bool cachelot_sharded_set(CachelotShardedPtr c, CachelotItemKey k, const char * value, size_t valuelen, uint32_t keepalive_sec, CachelotError * out_error) {
+        return sharded_store(c, k, value, valuelen, keepalive_sec, out_error, [](cache::Cache & shard, cache::ItemPtr item) -> bool {
+            shard.do_set(item);
+            return true;
+        });
+    }
+
+
+    bool cachelot_sharded_add(CachelotShardedPtr c, CachelotItemKey k, const char * value, size_t valuelen, uint32_t keepalive_sec, CachelotError * out_error) {
+        return sharded_store(c, k, value, valuelen, keepalive_sec, out_error, [](cache::Cache & shard, cache::ItemPtr item) -> bool {
+            return shard.do_add(item);
+        });
+    }
+
+
+    bool cachelot_sharded_replace(CachelotShardedPtr c, CachelotItemKey k, const char * value, size_t valuelen, uint32_t keepalive_sec, CachelotError * out_error) {
+        return sharded_store(c, k, value, valuelen, keepalive_sec, out_error, [](cache::Cache & shard, cache::ItemPtr item) -> bool {
+            return shard.do_replace(item);
+        });
+    }
+
+
+    bool cachelot_sharded_get(CachelotShardedPtr c, CachelotItemKey k, char * buffer, size_t buffer_size, size_t * out_valuelen, CachelotError * out_error) {
+        try {
+            size_t valuelen = 0;
+            // item memory is valid only within the reader, value is copied out
+            const bool found = c->cache.do_get(slice(k.key, k.keylen), k.hash, [&](cache::ConstItemPtr item) -> void {
+                valuelen = item->uncompressed_length();
+                if (valuelen <= buffer_size) {
+                    item->uncompress_value(buffer);
+                }
+            });
+            none_error(out_error);
+            if (found && out_valuelen != nullptr) {
+                *out_valuelen = valuelen;
+            }
+            return found;
+        } catch (const system_error & e) {
+            system_error_to_err_struct(e, out_error);
+        } catch(const std::exception & e) {
+            std_exception_to_err_struct(e, out_error);
+        } catch (...) {
+            unknown_exception_to_err_struct(out_error);
+        }
+        return false;
+    }
+
+
+    bool cachelot_sharded_delete(CachelotShardedPtr c, CachelotItemKey k, CachelotError * out_error) {
+        try {
+            auto ret = c->cache.lock_shard_for(k.hash)->do_delete(slice(k.key, k.keylen), k.hash);
+            none_error(out_error);
+            return ret;
+        } catch (const system_error & e) {
+            system_error_to_err_struct(e, out_error);
+        } catch(const std::exception & e) {
+            std_exception_to_err_struct(e, out_error);
+        } catch (...) {
+            unknown_exception_to_err_struct(out_error);
+        }
+        return false;
+    }
+
+
+    bool cachelot_sharded_touch(CachelotShardedPtr c, CachelotItemKey k, uint32_t keepalive_sec, CachelotError * out_error) {
+        try {
+            auto ret = c->cache.lock_shard_for(k.hash)->do_touch(slice(k.key, k.keylen), k.hash, cache::seconds(keepalive_sec));
+            none_error(out_error);
+            return ret;
+        } catch (const system_error & e) {
+            system_error_to_err_struct(e, out_error);
+        } catch(const std::exception & e) {
+            std_exception_to_err_struct(e, out_error);
+        } catch (...) {
+            unknown_exception_to_err_struct(out_error);
+        }
+        return false;
+    }
+
+
+    bool cachelot_sharded_incr(CachelotShardedPtr c, CachelotItemKey k, uint64_t delta, uint64_t * result, CachelotError * out_error) {
+        try {
+            bool found; uint64 newval;
+            tie(found, newval) = c->cache.lock_shard_for(k.hash)->do_incr(slice(k.key, k.keylen), k.hash, delta);
+            if (result != nullptr) {
+                *result = newval;
+            }
+            none_error(out_error);
+            return found;
+        } catch (const system_error & e) {
+            system_error_to_err_struct(e, out_error);
+        } catch(const std::exception & e) {
+            std_exception_to_err_struct(e, out_error);
+        } catch (...) {
+            unknown_exception_to_err_struct(out_error);
+        }
+        return false;
+    }
+
+
+    bool cachelot_sharded_decr(CachelotShardedPtr c, CachelotItemKey k, uint64_t delta, uint64_t * result, CachelotError * out_error) {
+        try {
+            bool found; uint64 newval;
+            tie(found, newval) = c->cache.lock_shard_for(k.hash)->do_decr(slice(k.key, k.keylen), k.hash, delta);
+            if (result != nullptr) {
+                *result = newval;
+            }
+            none_error(out_error);
+            return found;
+        } catch (const system_error & e) {
+            system_error_to_err_struct(e, out_error);
+        } catch(const std::exception & e) {
+            std_exception_to_err_struct(e, out_error);
+        } catch (...) {
+            unknown_exception_to_err_struct(out_error);
+        }
+        return false;
+    }
+
+
+    void cachelot_sharded_flush_all(CachelotShardedPtr c, CachelotError * out_error) {
+        try {
+            c->cache.do_flush_all();
+            none_error(out_error);
+        } catch (const system_error & e) {
+            system_error_to_err_struct(e, out_error);
+        } catch(const std::exception & e) {
+            std_exception_to_err_struct(e, out_error);
+        } catch (...) {
+            unknown_exception_to_err_struct(out_error);
+        }
+    }
+
+
 } // extern "C"
 
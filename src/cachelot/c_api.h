@@ -19,7 +19,7 @@ extern "C" {
 /**
  * @defgroup c_api Cachelot C language API
  *
- * @warning This API is *not* thread safe
+ * @warning This API is *not* thread safe, see the `cachelot_sharded_*` functions for the concurrent one
  *
  *
  * Please keep in mind that Cachelot uses its own memory space. All stored items are in this separate space.
@@ -62,6 +62,15 @@ typedef struct cachelot_options_t {
 
     /** whether to evict item when out of memory or just report an error */
     bool enable_evictions;
+
+    /** back the memory by huge pages if possible (best effort, fewer TLB misses on large memory_limit) */
+    bool huge_pages;
+
+    /** whether to bind the memory to the `numa_node` */
+    bool bind_to_numa_node;
+
+    /** NUMA node to allocate the memory on (used only if `bind_to_numa_node` is set) */
+    unsigned numa_node;
 } CachelotOptions;
 
 
@@ -136,6 +145,15 @@ bool cachelot_set(CachelotPtr c, CachelotItemPtr i, CachelotError * error);
  */
 CachelotConstItemPtr cachelot_get_unsafe(CachelotPtr c, CachelotItemKey key, CachelotError * error);
 
+/**
+ * Retrieve several Items at once, memory latency of the lookups is overlapped
+ * @return
+ *     - `out_items[n]` is a pointer to the Item for `keys[n]` or NULL if none was found
+ *     - false on error
+ * @warning pointers are only valid until the next cache call
+ */
+bool cachelot_get_multi(CachelotPtr c, const CachelotItemKey * keys, size_t count, CachelotConstItemPtr * out_items, CachelotError * error);
+
 /** @copydoc cachelot::cache::Cache::do_add */
 bool cachelot_add(CachelotPtr c, CachelotItemPtr i, CachelotError * error);
 
@@ -179,6 +197,69 @@ uint32_t cachelot_hash(const char * key, size_t keylen);
 /** retrieve Cachelot version */
 const char * cachelot_version();
 
+
+/**
+ * @name Thread safe API
+ *
+ * Sharded cache may be used by any number of threads at once.
+ * Items are partitioned by the `CachelotItemKey.hash` across `num_shards` independent caches, each one has its own lock,
+ * so threads contend only when they access the same shard.
+ * Values are copied in under the shard lock, there are no pointers into the cache memory.
+ * `cachelot_sharded_get()` copies the value out without taking the lock, so readers don't contend with each other,
+ * it only locks the shard when the lookup conflicts with a concurrent modification.
+ * @{
+ */
+
+struct cachelot_sharded_t;
+
+/** Pointer to the thread safe sharded cache */
+typedef struct cachelot_sharded_t * CachelotShardedPtr;
+
+/**
+ * Create new sharded cache
+ *
+ * `opts.memory_limit` and `opts.initial_dict_size` are equally divided among the `num_shards` (power of 2)
+ */
+CachelotShardedPtr cachelot_init_sharded(CachelotOptions opts, size_t num_shards, CachelotError * out_error);
+
+/** Destroy previously created sharded cache, no other thread may use it meanwhile */
+void cachelot_destroy_sharded(CachelotShardedPtr c);
+
+/** Store the value unconditionally */
+bool cachelot_sharded_set(CachelotShardedPtr c, CachelotItemKey key, const char * value, size_t valuelen, uint32_t keepalive_sec, CachelotError * error);
+
+/** Store the value only if there is no such key */
+bool cachelot_sharded_add(CachelotShardedPtr c, CachelotItemKey key, const char * value, size_t valuelen, uint32_t keepalive_sec, CachelotError * error);
+
+/** Store the value only if the key already exists */
+bool cachelot_sharded_replace(CachelotShardedPtr c, CachelotItemKey key, const char * value, size_t valuelen, uint32_t keepalive_sec, CachelotError * error);
+
+/**
+ * Copy the value of the key into the `buffer`
+ * @return
+ *     - false if key was not found
+ *     - true and the value length in `out_valuelen`,
+ *       value is copied only if it fits the `buffer_size` (otherwise the call may be repeated with a larger buffer)
+ */
+bool cachelot_sharded_get(CachelotShardedPtr c, CachelotItemKey key, char * buffer, size_t buffer_size, size_t * out_valuelen, CachelotError * error);
+
+/** @copydoc cachelot::cache::Cache::do_delete */
+bool cachelot_sharded_delete(CachelotShardedPtr c, CachelotItemKey key, CachelotError * error);
+
+/** @copydoc cachelot::cache::Cache::do_touch */
+bool cachelot_sharded_touch(CachelotShardedPtr c, CachelotItemKey key, uint32_t keepalive_sec, CachelotError * error);
+
+/** @copydoc cachelot::cache::Cache::do_incr */
+bool cachelot_sharded_incr(CachelotShardedPtr c, CachelotItemKey key, uint64_t delta, uint64_t * result, CachelotError * error);
+
+/** @copydoc cachelot::cache::Cache::do_decr */
+bool cachelot_sharded_decr(CachelotShardedPtr c, CachelotItemKey key, uint64_t delta, uint64_t * result, CachelotError * error);
+
+/** @copydoc cachelot::cache::Cache::do_flush_all */
+void cachelot_sharded_flush_all(CachelotShardedPtr c, CachelotError * error);
+
+/** @} */
+
 /** @} */
 
 #ifdef __cplusplus
@@ -17,8 +17,8 @@
 #ifndef CACHELOT_DICT_H_INCLUDED
 #  include <cachelot/dict.h>
 #endif
-#ifndef CACHELOT_HASH_FNV1A_H_INCLUDED
-#  include <cachelot/hash_fnv1a.h>
+#ifndef CACHELOT_HASH_FUNCTION_H_INCLUDED
+#  include <cachelot/hash_function.h>
 #endif
 #ifndef CACHELOT_ERROR_H_INCLUDED
 #  include <cachelot/error.h>
@@ -29,6 +29,9 @@
 #ifndef CACHELOT_STATS_H_INCLUDED
 #  include <cachelot/stats.h>
 #endif
+#ifndef CACHELOT_FREQUENCY_SKETCH_H_INCLUDED
+#  include <cachelot/frequency_sketch.h>
+#endif
 
 namespace cachelot {
 
@@ -43,8 +46,8 @@ namespace cachelot {
         /// Hash value type
         typedef Item::hash_type hash_type;
 
-        /// Hashing algorithm
-        typedef fnv1a<cache::hash_type>::hasher HashFunction;
+        /// Hashing algorithm (chosen at the startup, see selectable_hasher)
+        typedef selectable_hasher<cache::hash_type> HashFunction;
 
         /// Clock to maintain expiration
         typedef Item::clock clock;
@@ -55,6 +58,12 @@ namespace cachelot {
         /// User defined flags
         typedef Item::opaque_flags_type opaque_flags_type;
 
+        /// Strategy to choose the memory to evict
+        typedef memalloc::eviction_policy EvictionPolicy;
+
+        /// How the storage memory is obtained from the OS (huge pages, NUMA node)
+        typedef arena_options ArenaOptions;
+
         /// Value type of CAS operation
         typedef Item::timestamp_type timestamp_type;
 
@@ -88,6 +97,13 @@ namespace cachelot {
                 return m_item;
             }
 
+            // fingerprint of the key, it's independent of the hash so keys of the items are compared only on the real match
+            static uint32 fingerprint(const slice key) noexcept {
+                static constexpr uint64 fingerprint_seed = 0x9E3779B97F4A7C15ull;
+                const uint64 h = internal::wyhash64(key, fingerprint_seed);
+                return static_cast<uint32>(h ^ (h >> 32));
+            }
+
             // swap with other entry
             void swap(ItemDictEntry & other) {
                 using std::swap;
@@ -110,13 +126,16 @@ namespace cachelot {
             typedef uint32 size_type;
             typedef ::cachelot::cache::hash_type hash_type;
             static constexpr size_type max_load_factor_percent = 93;
+            static constexpr bool group_probing = true;
+            // 32-bit hash already makes false key comparisons rare, fingerprints only add to the hit latency
+            static constexpr bool key_fingerprints = false;
         };
 
 
         /**
          * One cache class to rule them all
          *
-         * @note Cache is *not* thread safe
+         * @note Cache is *not* thread safe, except for `do_get_concurrent()` of the Cache created with `concurrent_reads`
          * @ingroup cache
          */
         class Cache {
@@ -127,9 +146,23 @@ namespace cachelot {
             enum class ArithmeticOperation { INCR, DECR };
             /// APPEND/PREPEND
             enum class ExtendOperation { APPEND, PREPEND };
+            /// Average item size assumed to estimate the number of keys tracked by the admission filter
+            static constexpr size_t admission_expected_item_size = 64;
+            /// Number of lookups conflicted with the writer before the lock-free reader gives up
+            static constexpr unsigned max_concurrent_get_attempts = 4;
+            /// Hits and misses of the lock-free readers, one per reader slot so they don't share the cache line
+            struct ConcurrentReaderStats {
+                std::atomic<uint64> hits;
+                std::atomic<uint64> misses;
+                char padding[cpu_l1d_cache_line - 2 * sizeof(std::atomic<uint64>)];
+            };
+        public:
+            /// Values shorter than this are not worth to compress
+            static constexpr size_t min_compression_threshold = 64;
+        private:
 
             // Private constructor
-            explicit Cache(size_t memory_limit, uint32 mem_page_size, dict_type::size_type initial_dict_size, bool enable_evictions);
+            explicit Cache(size_t memory_limit, uint32 mem_page_size, dict_type::size_type initial_dict_size, bool enable_evictions, EvictionPolicy eviction_policy, bool enable_admission_filter, bool enable_cas, size_t compression_threshold, const ArenaOptions & arena, bool concurrent_reads, bool background_rehash);
         public:
             typedef dict_type::hash_type hash_type;
             typedef dict_type::size_type size_type;
@@ -141,9 +174,19 @@ namespace cachelot {
              * @param mem_page_size - size of the allocator memory page
              * @param initial_dict_size - number of reserved items in dictionary
              * @param enable_evictions - evict existing items in order to store new ones
+             * @param eviction_policy - how to choose the memory page to evict
+             * @param enable_admission_filter - store new item only if it's accessed more often than the items it would evict (TinyLFU)
+             * @param enable_cas - keep the CAS timestamp in every item, when disabled items are 8 bytes smaller and `cas` is not supported
+             * @param compression_threshold - compress values of this length or longer when they're stored (`0` - never compress)
+             * @param arena - back the storage by huge pages and / or bind it to the NUMA node
+             * @param concurrent_reads - allow `do_get_concurrent()` from the other threads while the Cache is modified (not compatible with the admission filter)
+             * @param background_rehash - hash table is expanded by do_background_work() instead of the requests
              * @note may throw exception
              */
-            static Cache Create(size_t memory_limit, size_t mem_page_size, size_t initial_dict_size, bool enable_evictions);
+            static Cache Create(size_t memory_limit, size_t mem_page_size, size_t initial_dict_size, bool enable_evictions,
+                                EvictionPolicy eviction_policy = EvictionPolicy::page_lru, bool enable_admission_filter = false,
+                                bool enable_cas = true, size_t compression_threshold = 0, const ArenaOptions & arena = ArenaOptions(),
+                                bool concurrent_reads = false, bool background_rehash = false);
 
 
             /**
@@ -166,6 +209,45 @@ namespace cachelot {
              */
             ConstItemPtr do_get(const slice key, const hash_type hash) noexcept;
 
+            /**
+             * `get` of several items at once, result for the `keys[n]` is stored in the `out[n]`
+             *
+             * Memory latency of lookups is overlapped: hash table slots of all the keys are prefetched first,
+             * then headers of the found items, and only then keys are compared
+             * @warning returned pointers guaranteed to be valid only *until* the next Cachelot call
+             */
+            void do_get_batch(const slice keys[], const hash_type hashes[], const size_t count, ConstItemPtr out[]) noexcept;
+
+            /**
+             * `get` by the lock-free reader, it may be called from any thread while the Cache is modified by another one
+             *
+             * Found item is passed to the `reader(ConstItemPtr item)` which must copy whatever it needs:
+             * item may be removed meanwhile, its memory is only guaranteed not to be reused until `reader` returns.
+             * Expired items are reported as missing, they're left to the writer to remove.
+             * Recency of the found item is tracked per allocator page, so LRU order is less accurate than with do_get()
+             *
+             * @return tuple<completed, found> where `completed` is `false` if lookup conflicted with the writer
+             *         (or hash table is expanding) and must be repeated by do_get() under the writer lock
+             * @note Cache must be created with `concurrent_reads`
+             */
+            template <typename Reader>
+            tuple<bool, bool> do_get_concurrent(const slice key, const hash_type hash, Reader reader) const;
+
+            /**
+             * Check whether Cache is created with `concurrent_reads`
+             */
+            bool concurrent_reads_enabled() const noexcept { return m_allocator.epochs() != nullptr; }
+
+            /**
+             * Background work to be done when there are no requests, for up to `time_budget`
+             *
+             * Hash table is expanded ahead of time (or shrunk when it's sparse) and its items are moved to the new table in small steps
+             * (see dict::rehash_step()), so requests don't pay for the expansion
+             * @return `true` if there is more work to do
+             * @note does nothing unless Cache is created with `background_rehash`, may throw std::bad_alloc
+             */
+            bool do_background_work(const std::chrono::microseconds time_budget);
+
             /**
              * `set` - store item unconditionally
              *
@@ -203,6 +285,7 @@ namespace cachelot {
              * - `[true, false]` - item was not updated as it has been modified since
              * - `[false, false]` - no such key
              *
+             * @throws system_error(error::not_implemented) if the Cache was created without CAS support
              * @warning item pointer will not be valid after the call
              */
             tuple<bool, bool> do_cas(ItemPtr item, timestamp_type cas_unique);
@@ -244,8 +327,10 @@ namespace cachelot {
              * @return
              * - `true` - item TTL was updated
              * - `false` - no such key
+             *
+             * @note item stored without the expiration time is re-created to make it expire, this may throw
              */
-            bool do_touch(const slice key, const hash_type hash, seconds keepalive) noexcept;
+            bool do_touch(const slice key, const hash_type hash, seconds keepalive);
 
             /**
              * `flush_all` - invalidate every item in the cache (remove expired items)
@@ -279,15 +364,46 @@ namespace cachelot {
             /**
              * Create new Item from the pre-allocated memory arena
              *
+             * Item which doesn't fit the single memory page gets its value stored in the chain of page-sized chunks (see Item::is_chained()),
+             * value of such Item may be up to the half of the `memory_limit`.
+             * When admission filter is enabled and the new key requires eviction, it throws `error::not_admitted`
+             * unless the key is accessed more often than the items to be evicted
+             * @param mutable_ttl - reserve room for the expiration time, so Item::set_ttl() works for the item created with `infinite_TTL`
              * @warning returned pointer is only *valid until* next cachelot call
              */
-            ItemPtr create_item(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive);
+            ItemPtr create_item(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive, bool mutable_ttl = false);
+
+            /**
+             * Create new Item holding the `value`
+             *
+             * Value is compressed beforehand if it's long enough, so only the compressed size is allocated
+             * @see create_item()
+             */
+            ItemPtr create_item(const slice key, const hash_type hash, const slice value, opaque_flags_type flags, seconds keepalive);
+
+            /**
+             * Check whether the Item of the given fields would be chained, so its value is not contiguous
+             */
+            bool is_chained_item(const slice key, size_t value_length, opaque_flags_type flags, seconds keepalive, bool mutable_ttl = false) const noexcept;
 
             /**
              * Free existing Item and return the memory
              */
             void destroy_item(ItemPtr item) noexcept;
 
+            /**
+             * Keep `item` memory valid after the cache call, so it could be read later without copying (i.e. sent directly from the cache memory)
+             *
+             * Pinned item may be removed or replaced as usual, but its memory won't be freed or evicted until the matching `unpin_item()`
+             * Every chunk of the chained item is pinned as well
+             */
+            void pin_item(ConstItemPtr item) noexcept;
+
+            /**
+             * Release `item` pinned by the `pin_item()`, free it if it was removed meanwhile
+             */
+            void unpin_item(ConstItemPtr item) noexcept;
+
             /**
              * Publish dynamic stats
              */
@@ -321,6 +437,75 @@ namespace cachelot {
              */
             tuple<bool, dict_type::iterator> retrieve_item(const slice key, const hash_type hash, bool readonly = false);
 
+            /**
+             * Decide whether the new item is worth to evict existing ones in order to store it (TinyLFU)
+             *
+             * Item is admitted if its key was accessed more often than an average eviction victim
+             */
+            bool admit(const slice key, const hash_type hash, const size_t size_required) noexcept;
+
+            /**
+             * Compress the `value` into the temporary buffer if it's long enough and compression saves enough memory
+             * @return compressed value or empty slice if it's not compressed
+             * @throws std::bad_alloc if value is longer than the buffer preallocated for the single page
+             */
+            slice compress_value(const slice value);
+
+            /**
+             * Compress value of the Item being stored if it's long enough and shrink its memory
+             * Item is not chained, so its value fits the preallocated buffer
+             */
+            void compress_item(ItemPtr item) noexcept;
+
+            /**
+             * Retrieve the value of Item, compressed value is uncompressed and chained one is gathered into the `buffer`
+             * @warning returned slice is valid only until the `buffer` is modified
+             */
+            slice uncompressed_value(ConstItemPtr item, std::vector<char> & buffer);
+
+            /**
+             * Construct new Item in the allocated `memory`, with the next CAS timestamp if CAS is enabled
+             */
+            ItemPtr construct_item(void * memory, const slice key, const hash_type hash, uint32 value_length, opaque_flags_type flags, seconds keepalive, bool mutable_ttl = false) noexcept;
+
+            /**
+             * Allocate and construct new Item, chained one if it doesn't fit the single page
+             * @return `nullptr` if there is not enough memory
+             */
+            ItemPtr allocate_item(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive, bool mutable_ttl, bool evict_if_necessary);
+
+            /**
+             * Allocate memory, evicting existing items if necessary (and allowed), evicted chains are released afterwards
+             */
+            void * allocate(size_t size, bool evict_if_necessary);
+
+            /**
+             * Remove Item which memory (or memory of its chunk) is evicted
+             *
+             * The rest of the chain is detached, it's released by the release_detached() once the allocation is done
+             */
+            void on_evicted(void * memory) noexcept;
+
+            /**
+             * Free memory of the evicted chains
+             */
+            void release_detached() noexcept;
+
+            /**
+             * Free memory of an Item or a Chunk, deferring it while its page is pinned or lock-free readers may access it
+             */
+            void free_memory(void * memory) noexcept;
+
+            /**
+             * Mark Item and all its chunks as recently used
+             */
+            void touch_item(ConstItemPtr item) noexcept;
+
+            /**
+             * Maximal size of the single allocation
+             */
+            size_t max_allocation_size() const noexcept { return m_allocator.page_size - memalloc::header_size(); }
+
             class ItemAutoDelete {
                 Cache * m_cache;
                 Item * m_item;
@@ -345,12 +530,23 @@ namespace cachelot {
             memalloc m_allocator;
             dict_type m_dict;
             const bool m_evictions_enabled;
+            const bool m_cas_enabled;
+            const size_t m_compression_threshold;
+            // temporary storage of compressed / uncompressed values
+            std::vector<char> m_compressed_value;
+            std::vector<char> m_uncompressed_value;
+            // access frequency of recently seen keys, `nullptr` if admission filter is disabled
+            std::unique_ptr<frequency_sketch<hash_type>> m_frequency_sketch;
+            // parts of the evicted chains to be freed after the allocation
+            std::vector<void *> m_detached;
+            // stats of the lock-free readers, `nullptr` unless `concurrent_reads` are enabled
+            std::unique_ptr<ConcurrentReaderStats[]> m_reader_stats;
             timestamp_type m_oldest_timestamp;
             timestamp_type m_newest_timestamp;
         };
 
 
-        inline Cache Cache::Create(size_t memory_limit, size_t mem_page_size, size_t initial_dict_size, bool enable_evictions) {
+        inline Cache Cache::Create(size_t memory_limit, size_t mem_page_size, size_t initial_dict_size, bool enable_evictions, EvictionPolicy eviction_policy, bool enable_admission_filter, bool enable_cas, size_t compression_threshold, const ArenaOptions & arena, bool concurrent_reads, bool background_rehash) {
             if (not ispow2(memory_limit)) {
                 throw std::invalid_argument("memory_limit must be power of 2");
             }
@@ -363,8 +559,8 @@ namespace cachelot {
             if (mem_page_size == 0) {
                 throw std::invalid_argument("mem_page_size must be non-zero");
             }
-            if (mem_page_size > std::numeric_limits<uint32>::max()) {
-                throw std::invalid_argument("mem_page_size is too big (max is INT32_MAX)");
+            if (mem_page_size > 1 * Gigabyte) {
+                throw std::invalid_argument("mem_page_size is too big (max is 1Gb)");
             }
             if (mem_page_size < 256) {
                 throw std::invalid_argument("mem_page_size is too small (min 256b)");
@@ -378,16 +574,37 @@ namespace cachelot {
             if (initial_dict_size > std::numeric_limits<dict_type::size_type>::max()) {
                 throw std::invalid_argument("initial_dict_size is too big");
             }
-            return Cache(memory_limit, mem_page_size, initial_dict_size, enable_evictions);
+            if (compression_threshold != 0 && compression_threshold < min_compression_threshold) {
+                throw std::invalid_argument("compression_threshold is too small (min 64b)");
+            }
+            if (concurrent_reads && enable_admission_filter) {
+                // lock-free readers don't update the access frequencies
+                throw std::invalid_argument("admission filter can't be used with concurrent_reads");
+            }
+            return Cache(memory_limit, mem_page_size, initial_dict_size, enable_evictions, eviction_policy, enable_admission_filter, enable_cas, compression_threshold, arena, concurrent_reads, background_rehash);
         }
 
 
-        inline Cache::Cache(size_t memory_limit, uint32 mem_page_size, dict_type::size_type initial_dict_size, bool enable_evictions)
-            : m_allocator(memory_limit, mem_page_size)
-            , m_dict(initial_dict_size)
+        inline Cache::Cache(size_t memory_limit, uint32 mem_page_size, dict_type::size_type initial_dict_size, bool enable_evictions, EvictionPolicy eviction_policy, bool enable_admission_filter, bool enable_cas, size_t compression_threshold, const ArenaOptions & arena, bool concurrent_reads, bool background_rehash)
+            : m_allocator(memory_limit, mem_page_size, eviction_policy, arena, concurrent_reads)
+            , m_dict(initial_dict_size, background_rehash)
             , m_evictions_enabled(enable_evictions)
+            , m_cas_enabled(enable_cas)
+            , m_compression_threshold(compression_threshold)
+            , m_compressed_value()
+            , m_uncompressed_value()
+            , m_frequency_sketch(enable_admission_filter ? new frequency_sketch<hash_type>(memory_limit / admission_expected_item_size) : nullptr)
+            , m_detached()
+            , m_reader_stats(concurrent_reads ? new ConcurrentReaderStats[epoch_domain::max_readers]() : nullptr)
             , m_oldest_timestamp(std::numeric_limits<timestamp_type>::max())
             , m_newest_timestamp(std::numeric_limits<timestamp_type>::min()) {
+            if (concurrent_reads) {
+                m_dict.enable_concurrent_reads(*m_allocator.epochs());
+            }
+            if (m_compression_threshold != 0) {
+                // values are compressed by the noexcept compress_item() too, buffer mustn't grow there
+                m_compressed_value.reserve(max_allocation_size());
+            }
         }
 
 
@@ -396,17 +613,22 @@ namespace cachelot {
                 destroy_item(item);
                 return true;
             });
+            // there are no readers anymore
+            m_allocator.reclaim();
         }
 
 
         inline tuple<bool, Cache::dict_type::iterator> Cache::retrieve_item(const slice key, const hash_type hash, bool readonly) {
             bool found; iterator at;
+            if (m_frequency_sketch) {
+                m_frequency_sketch->increment(hash);
+            }
             tie(found, at) = m_dict.entry_for(key, hash, readonly);
             if (found) {
                 ItemPtr item = at.value();
                 // validate item
                 if (not item->is_expired()) {
-                    m_allocator.touch(item);
+                    touch_item(item);
                 } else {
                     m_dict.remove(at);
                     destroy_item(item);
@@ -435,6 +657,58 @@ namespace cachelot {
         }
 
 
+        template <typename Reader>
+        inline tuple<bool, bool> Cache::do_get_concurrent(const slice key, const hash_type hash, Reader reader) const {
+            debug_assert(concurrent_reads_enabled());
+            epoch_domain::read_guard guard(*m_allocator.epochs());
+            if (not guard.ok()) {
+                // too many readers
+                return make_tuple(false, false);
+            }
+            for (unsigned attempt = 0; attempt < max_concurrent_get_attempts; ++attempt) {
+                bool completed, found; ItemPtr item;
+                tie(completed, found, item) = m_dict.concurrent_get(hash, [=](ConstItemPtr candidate) -> bool {
+                    return candidate->hash() == hash && candidate->key() == key;
+                });
+                if (not completed) {
+                    continue;
+                }
+                ConcurrentReaderStats & counters = m_reader_stats[guard.slot()];
+                if (found && not item->is_expired()) {
+                    m_allocator.touch_concurrent(item);
+                    if (item->is_chained()) {
+                        for (auto chunk = item->first_chunk(); chunk != nullptr; chunk = chunk->next()) {
+                            m_allocator.touch_concurrent(chunk);
+                        }
+                    }
+                    reader(static_cast<ConstItemPtr>(item));
+                    counters.hits.fetch_add(1, std::memory_order_relaxed);
+                    return make_tuple(true, true);
+                } else {
+                    counters.misses.fetch_add(1, std::memory_order_relaxed);
+                    return make_tuple(true, false);
+                }
+            }
+            return make_tuple(false, false);
+        }
+
+
+        inline void Cache::do_get_batch(const slice keys[], const hash_type hashes[], const size_t count, ConstItemPtr out[]) noexcept {
+            for (size_t n = 0; n < count; ++n) {
+                m_dict.prefetch(hashes[n]);
+            }
+            for (size_t n = 0; n < count; ++n) {
+                auto candidate = m_dict.entry_with_hash(hashes[n]);
+                if (candidate != nullptr) {
+                    prefetch_read(candidate->value());
+                }
+            }
+            for (size_t n = 0; n < count; ++n) {
+                out[n] = do_get(keys[n], hashes[n]);
+            }
+        }
+
+
         inline void Cache::do_set(ItemPtr item) {
             STAT_INCR(cache.cmd_set, 1);
             ItemAutoDelete _item_uniq_ptr(this, item);
@@ -483,8 +757,11 @@ namespace cachelot {
 
 
         inline tuple<bool, bool> Cache::do_cas(ItemPtr item, timestamp_type cas_unique) {
-            STAT_INCR(cache.cmd_cas, 1);
             ItemAutoDelete _item_uniq_ptr(this, item);
+            if (not m_cas_enabled) {
+                throw system_error(error::not_implemented);
+            }
+            STAT_INCR(cache.cmd_cas, 1);
             bool found; iterator at;
             tie(found, at) = retrieve_item(item->key(), item->hash());
             if (found) {
@@ -515,18 +792,24 @@ namespace cachelot {
             tie(found, at) = retrieve_item(piece->key(), piece->hash());
             if (found) {
                 auto old_item = at.value();
-                const size_t new_value_size = old_item->value().length() + piece->value().length();
+                const slice old_value = uncompressed_value(old_item, m_uncompressed_value);
+                std::vector<char> piece_buffer;
+                const slice piece_value = uncompressed_value(piece, piece_buffer);
+                const size_t new_value_size = old_value.length() + piece_value.length();
+                if (new_value_size > Item::max_value_length) {
+                    throw system_error(error::item_too_big);
+                }
                 // do not evict existing items to avoid accidentally free the `piece` or the `old_item`
-                auto memory = m_allocator.alloc_or_evict(Item::CalcSizeRequired(old_item->key(), new_value_size), false, [=](void *){});
-                if (memory != nullptr) {
-                    auto new_item = new (memory) Item(old_item->key(), old_item->hash(), static_cast<uint32>(new_value_size), old_item->opaque_flags(), old_item->ttl(), ++m_newest_timestamp);
+                const bool evict_if_necessary = false;
+                auto new_item = allocate_item(old_item->key(), old_item->hash(), new_value_size, old_item->opaque_flags(), old_item->ttl(), false, evict_if_necessary);
+                if (new_item != nullptr) {
                     ItemAutoDelete _item_uniq_ptr(this, new_item);
                     if (op == ExtendOperation::APPEND) {
-                        new_item->assign_compose(old_item->value(), piece->value());
+                        new_item->assign_compose(old_value, piece_value);
                         STAT_INCR(cache.append_stored, 1);
                     } else {
                         debug_assert(op == ExtendOperation::PREPEND);
-                        new_item->assign_compose(piece->value(), old_item->value());
+                        new_item->assign_compose(piece_value, old_value);
                         STAT_INCR(cache.prepend_stored, 1);
                     }
                     replace_item_at(at, _item_uniq_ptr);
@@ -553,6 +836,7 @@ namespace cachelot {
                 ItemPtr item = at.value();
                 m_dict.remove(at);
                 destroy_item(item);
+                m_dict.shrink_if_sparse();
                 STAT_INCR(cache.delete_hits, 1);
                 return true;
             } else {
@@ -563,14 +847,34 @@ namespace cachelot {
         }
 
 
-        inline bool Cache::do_touch(const slice key, const hash_type hash, seconds keepalive) noexcept {
+        inline bool Cache::do_touch(const slice key, const hash_type hash, seconds keepalive) {
             STAT_INCR(cache.cmd_touch, 1);
             bool found; iterator at; const bool readonly = true;
             tie(found, at) = retrieve_item(key, hash, readonly);
             if (found) {
                 auto item = at.value();
-                m_allocator.touch(item); // mark item as recent in LRU list
-                item->set_ttl(keepalive); // update lifetime
+                touch_item(item); // mark item as recent in LRU list
+                if (not item->set_ttl(keepalive)) { // update lifetime
+                    // chained items always have the expiration time
+                    debug_assert(not item->is_chained());
+                    // item has no room for the expiration time, copy it into the new one
+                    // do not evict existing items to avoid accidentally free the `item`
+                    auto memory = m_allocator.alloc_or_evict(Item::CalcSizeRequired(item->key(), item->value().length(), item->opaque_flags(), keepalive, item->has_timestamp()), false, [=](void *){});
+                    if (memory == nullptr) {
+                        throw system_error(error::out_of_memory);
+                    }
+                    const auto value_length = static_cast<uint32>(item->value().length());
+                    // `touch` doesn't modify the item, so its CAS timestamp is kept
+                    auto new_item = item->has_timestamp() ? new (memory) Item(key, hash, value_length, item->opaque_flags(), keepalive, item->timestamp())
+                                                          : new (memory) Item(key, hash, value_length, item->opaque_flags(), keepalive);
+                    ItemAutoDelete _item_uniq_ptr(this, new_item);
+                    if (item->is_compressed()) {
+                        new_item->assign_compressed_value(item->value());
+                    } else {
+                        new_item->assign_value(item->value());
+                    }
+                    replace_item_at(at, _item_uniq_ptr);
+                }
                 STAT_INCR(cache.touch_hits, 1);
                 return true;
             } else {
@@ -590,6 +894,7 @@ namespace cachelot {
                     return false;
                 }
             });
+            m_dict.shrink_if_sparse();
         }
 
 
@@ -613,7 +918,7 @@ namespace cachelot {
             }
             // retrieve item value stored as an ASCII string
             auto old_item = at.value();
-            auto old_ascii_value = at.value()->value();
+            auto old_ascii_value = uncompressed_value(old_item, m_uncompressed_value);
             auto old_int_value = str_to_int<uint64>(old_ascii_value.begin(), old_ascii_value.end());
             // process arithmetic command
             uint64 new_int_value = 0;
@@ -635,30 +940,27 @@ namespace cachelot {
             ItemAutoDelete _item_uniq_ptr(this, new_item);
             new_item->assign_value(slice(new_ascii_value, new_ascii_value_length));
             replace_item_at(at, _item_uniq_ptr);
+            // new item may have evicted others, table is checked only now as `at` had to stay valid
+            m_dict.shrink_if_sparse();
             return make_tuple(true, new_int_value);
         }
 
 
-        inline ItemPtr Cache::create_item(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive) {
-            void * memory;
+        inline ItemPtr Cache::create_item(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive, bool mutable_ttl) {
             if (key.length() > Item::max_key_length) {
                 throw system_error(error::key_too_long);
             }
-            const size_t size_required = Item::CalcSizeRequired(key, value_length);
-            if (size_required > m_allocator.page_size) {
+            // chain must leave enough memory for the rest of items
+            if (value_length > Item::max_value_length || value_length > m_allocator.arena_size / 2) {
                 throw system_error(error::item_too_big);
             }
-            const auto on_delete = [=](void * ptr) noexcept -> void {
-                auto i = reinterpret_cast<Item *>(ptr);
-                debug_only(bool deleted = ) this->m_dict.del(i->key(), i->hash());
-                debug_assert(deleted);
-                if (on_eviction) {
-                    on_eviction(i);
-                }
-            };
-            memory = m_allocator.alloc_or_evict(size_required, m_evictions_enabled, on_delete);
-            if (memory != nullptr) {
-                auto item = new (memory) Item(key, hash, static_cast<uint32>(value_length), flags, keepalive, ++m_newest_timestamp);
+            const size_t size_required = Item::CalcSizeRequired(key, value_length, flags, keepalive, m_cas_enabled, mutable_ttl);
+            // chained item is admitted by the victims of its first page
+            if (m_frequency_sketch && m_evictions_enabled && not admit(key, hash, std::min(size_required, max_allocation_size()))) {
+                throw system_error(error::not_admitted);
+            }
+            auto item = allocate_item(key, hash, value_length, flags, keepalive, mutable_ttl, m_evictions_enabled);
+            if (item != nullptr) {
                 return item;
             } else {
                 throw system_error(error::out_of_memory);
@@ -666,32 +968,298 @@ namespace cachelot {
         }
 
 
+        inline bool Cache::is_chained_item(const slice key, size_t value_length, opaque_flags_type flags, seconds keepalive, bool mutable_ttl) const noexcept {
+            return Item::CalcSizeRequired(key, value_length, flags, keepalive, m_cas_enabled, mutable_ttl) > max_allocation_size();
+        }
+
+
+        inline ItemPtr Cache::allocate_item(const slice key, const hash_type hash, size_t value_length, opaque_flags_type flags, seconds keepalive, bool mutable_ttl, bool evict_if_necessary) {
+            if (not is_chained_item(key, value_length, flags, keepalive, mutable_ttl)) {
+                auto memory = allocate(Item::CalcSizeRequired(key, value_length, flags, keepalive, m_cas_enabled, mutable_ttl), evict_if_necessary);
+                if (memory == nullptr) {
+                    return nullptr;
+                }
+                return construct_item(memory, key, hash, static_cast<uint32>(value_length), flags, keepalive, mutable_ttl);
+            }
+            // chained item keeps room for the expiration time, so `touch` never has to copy the whole value
+            mutable_ttl = true;
+            auto memory = allocate(Item::CalcHeadSizeRequired(key, value_length, flags, keepalive, m_cas_enabled, mutable_ttl), evict_if_necessary);
+            if (memory == nullptr) {
+                return nullptr;
+            }
+            auto item = construct_item(memory, key, hash, static_cast<uint32>(value_length), flags, keepalive, mutable_ttl);
+            item->attach_chunks(nullptr);
+            // parts of the chain are pinned, so allocation of the next chunk won't evict them
+            m_allocator.pin(item);
+            const size_t chunk_capacity = max_allocation_size() - sizeof(Item::Chunk);
+            Item::Chunk * last = nullptr;
+            bool allocated = true;
+            for (size_t left = value_length; left > 0; ) {
+                const auto chunk_length = static_cast<uint32>(std::min(left, chunk_capacity));
+                auto chunk_memory = allocate(Item::Chunk::CalcSizeRequired(chunk_length), evict_if_necessary);
+                if (chunk_memory == nullptr) {
+                    allocated = false;
+                    break;
+                }
+                auto chunk = new (chunk_memory) Item::Chunk(item, chunk_length);
+                m_allocator.pin(chunk);
+                if (last != nullptr) {
+                    last->set_next(chunk);
+                } else {
+                    item->attach_chunks(chunk);
+                }
+                last = chunk;
+                left -= chunk_length;
+            }
+            unpin_item(item);
+            if (not allocated) {
+                destroy_item(item);
+                return nullptr;
+            }
+            STAT_INCR(cache.chained_items, 1);
+            return item;
+        }
+
+
+        inline void * Cache::allocate(size_t size, bool evict_if_necessary) {
+            debug_assert(size <= max_allocation_size());
+            auto memory = m_allocator.alloc_or_evict(size, evict_if_necessary, [=](void * ptr) noexcept -> void {
+                this->on_evicted(ptr);
+            });
+            release_detached();
+            return memory;
+        }
+
+
+        inline void Cache::on_evicted(void * memory) noexcept {
+            auto detached = std::find(m_detached.begin(), m_detached.end(), memory);
+            if (detached != m_detached.end()) {
+                // Item is already removed along with another part of its chain
+                *detached = m_detached.back();
+                m_detached.pop_back();
+                return;
+            }
+            auto item = Item::IsChunk(memory) ? reinterpret_cast<Item::Chunk *>(memory)->owner() : reinterpret_cast<ItemPtr>(memory);
+            debug_only(bool deleted = ) m_dict.del(item->key(), item->hash());
+            debug_assert(deleted);
+            if (on_eviction) {
+                on_eviction(item);
+            }
+            if (item->is_chained()) {
+                // the rest of the chain can't be freed while allocator evicts the page
+                if (item != memory) {
+                    m_detached.push_back(item);
+                }
+                for (auto chunk = item->first_chunk(); chunk != nullptr; chunk = chunk->next()) {
+                    if (chunk != memory) {
+                        m_detached.push_back(chunk);
+                    }
+                }
+            }
+        }
+
+
+        inline void Cache::release_detached() noexcept {
+            for (auto memory : m_detached) {
+                free_memory(memory);
+            }
+            m_detached.clear();
+        }
+
+
+        inline ItemPtr Cache::construct_item(void * memory, const slice key, const hash_type hash, uint32 value_length, opaque_flags_type flags, seconds keepalive, bool mutable_ttl) noexcept {
+            if (m_cas_enabled) {
+                return new (memory) Item(key, hash, value_length, flags, keepalive, ++m_newest_timestamp, mutable_ttl);
+            } else {
+                return new (memory) Item(key, hash, value_length, flags, keepalive, mutable_ttl);
+            }
+        }
+
+
+        inline ItemPtr Cache::create_item(const slice key, const hash_type hash, const slice value, opaque_flags_type flags, seconds keepalive) {
+            const slice compressed = compress_value(value);
+            if (compressed && not is_chained_item(key, compressed.length(), flags, keepalive)) {
+                auto item = create_item(key, hash, compressed.length(), flags, keepalive);
+                item->assign_compressed_value(compressed);
+                return item;
+            } else {
+                auto item = create_item(key, hash, value.length(), flags, keepalive);
+                item->assign_value(value);
+                return item;
+            }
+        }
+
+
+        inline bool Cache::admit(const slice key, const hash_type hash, const size_t size_required) noexcept {
+            uint64 num_victims = 0;
+            uint64 victims_frequency = 0;
+            m_allocator.foreach_eviction_victim(size_required, [&](void * ptr) noexcept -> void {
+                num_victims += 1;
+                victims_frequency += m_frequency_sketch->estimate(reinterpret_cast<ConstItemPtr>(ptr)->hash());
+            });
+            if (num_victims == 0 || m_dict.contains(key, hash)) {
+                // nothing to evict or existing item is updated
+                return true;
+            }
+            // current request counts too, otherwise the key that is only written would never be admitted
+            const uint64 frequency = m_frequency_sketch->estimate(hash) + 1;
+            if (frequency * num_victims > victims_frequency) {
+                STAT_INCR(cache.admission_accepted, 1);
+                return true;
+            } else {
+                STAT_INCR(cache.admission_rejected, 1);
+                return false;
+            }
+        }
+
+
         inline void Cache::destroy_item(ItemPtr item) noexcept {
-            m_allocator.free(item);
+            if (item->is_chained()) {
+                for (auto chunk = item->first_chunk(); chunk != nullptr; ) {
+                    auto next = chunk->next();
+                    free_memory(chunk);
+                    chunk = next;
+                }
+            }
+            free_memory(item);
+        }
+
+
+        inline void Cache::free_memory(void * memory) noexcept {
+            if (concurrent_reads_enabled()) {
+                // allocator frees it once the readers leave and the page is unpinned
+                m_allocator.retire(memory);
+            } else {
+                // item may be in use while its page is pinned, allocator frees it on unpin
+                m_allocator.free_when_unpinned(memory);
+            }
+        }
+
+
+        inline void Cache::touch_item(ConstItemPtr item) noexcept {
+            m_allocator.touch(const_cast<ItemPtr>(item));
+            if (item->is_chained()) {
+                for (auto chunk = item->first_chunk(); chunk != nullptr; chunk = chunk->next()) {
+                    m_allocator.touch(chunk);
+                }
+            }
+        }
+
+
+        inline void Cache::pin_item(ConstItemPtr item) noexcept {
+            m_allocator.pin(item);
+            if (item->is_chained()) {
+                for (auto chunk = item->first_chunk(); chunk != nullptr; chunk = chunk->next()) {
+                    m_allocator.pin(chunk);
+                }
+            }
+        }
+
+
+        inline void Cache::unpin_item(ConstItemPtr item) noexcept {
+            if (item->is_chained()) {
+                for (auto chunk = item->first_chunk(); chunk != nullptr; ) {
+                    // removed chunk is freed by the last unpin of its page
+                    auto next = chunk->next();
+                    m_allocator.unpin(chunk);
+                    chunk = next;
+                }
+            }
+            m_allocator.unpin(item);
         }
 
 
         inline void Cache::replace_item_at(iterator at, ItemAutoDelete & lockedItem) noexcept {
             auto old_item = at.value();
             auto new_item = lockedItem.get();
+            compress_item(new_item);
             debug_assert(old_item->hash() == new_item->hash() && old_item->key() == new_item->key());
-            destroy_item(old_item);
             at.unsafe_replace_kv(new_item->key(), new_item->hash(), new_item);
             lockedItem.reset(); // Item will live
+            // old item is unreachable for the lock-free readers from now on
+            destroy_item(old_item);
         }
 
 
         inline void Cache::insert_item_at(const iterator at, ItemAutoDelete & lockedItem) noexcept {
             auto i = lockedItem.get();
+            compress_item(i);
             m_dict.insert(at, i->key(), i->hash(), i);
             lockedItem.reset();
         }
 
 
+        inline slice Cache::compress_value(const slice value) {
+            if (m_compression_threshold == 0 || value.length() < m_compression_threshold) {
+                return slice();
+            }
+            // compression must save at least 1/8 of the value to pay off its decompression
+            m_compressed_value.resize(value.length() - value.length() / 8);
+            const size_t compressed_length = Item::CompressValue(value, m_compressed_value.data(), m_compressed_value.size());
+            if (compressed_length == 0) {
+                STAT_INCR(cache.incompressible_values, 1);
+                return slice();
+            }
+            STAT_INCR(cache.compressed_values, 1);
+            STAT_INCR(cache.compression_saved_bytes, value.length() - compressed_length);
+            return slice(m_compressed_value.data(), compressed_length);
+        }
+
+
+        inline void Cache::compress_item(ItemPtr item) noexcept {
+            // chained value is only compressed by create_item() if it fits the single page afterwards
+            if (item->is_compressed() || item->is_chained()) {
+                return;
+            }
+            debug_assert(m_compression_threshold == 0 || item->value().length() <= m_compressed_value.capacity());
+            const slice compressed = compress_value(item->value());
+            if (compressed) {
+                item->assign_compressed_value(compressed);
+                // give the freed tail of the Item back to the allocator
+                m_allocator.realloc_inplace(item, item->size());
+            }
+        }
+
+
+        inline slice Cache::uncompressed_value(ConstItemPtr item, std::vector<char> & buffer) {
+            if (not item->is_compressed() && not item->is_chained()) {
+                return item->value();
+            }
+            buffer.resize(item->uncompressed_length());
+            item->uncompress_value(buffer.data());
+            return slice(buffer.data(), buffer.size());
+        }
+
+
+        inline bool Cache::do_background_work(const std::chrono::microseconds time_budget) {
+            // number of items moved between the clock checks
+            static constexpr dict_type::size_type rehash_step_size = 64;
+            if (not m_dict.background_rehash()) {
+                return false;
+            }
+            const auto deadline = std::chrono::steady_clock::now() + time_budget;
+            do {
+                if (not m_dict.rehash_step(rehash_step_size)) {
+                    return false;
+                }
+            } while (std::chrono::steady_clock::now() < deadline);
+            return true;
+        }
+
+
         inline void Cache::publish_stats() noexcept {
             STAT_SET(cache.hash_capacity, m_dict.capacity());
             STAT_SET(cache.curr_items, m_dict.size());
             STAT_SET(cache.hash_is_expanding, m_dict.is_expanding());
+            if (m_reader_stats) {
+                uint64 hits = 0, misses = 0;
+                for (size_t n = 0; n < epoch_domain::max_readers; ++n) {
+                    hits += m_reader_stats[n].hits.load(std::memory_order_relaxed);
+                    misses += m_reader_stats[n].misses.load(std::memory_order_relaxed);
+                }
+                STAT_SET(cache.concurrent_get_hits, hits);
+                STAT_SET(cache.concurrent_get_misses, misses);
+            }
         }
 
     } // namespace cache
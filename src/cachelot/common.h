@@ -116,6 +116,15 @@ namespace cachelot {
     }
     #endif // aligned_alloc
 
+    /// hint CPU to load the cache line containing `addr` for reading (never faults, even on invalid address)
+    inline void prefetch_read(const void * addr) noexcept {
+    #if defined(__GNUC__)
+        __builtin_prefetch(addr, 0);
+    #else
+        (void)addr;
+    #endif
+    }
+
     constexpr size_t cpu_l1d_cache_line = 64;
     constexpr int the_answer_to_life_the_universe_and_everything = 42;
 
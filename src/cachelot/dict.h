@@ -9,6 +9,8 @@
 
 
 #include <cachelot/hash_table.h> // hash_table
+#include <cachelot/group_hash_table.h> // group_hash_table
+#include <cachelot/epoch.h> // concurrent reads
 
 namespace cachelot {
 
@@ -23,6 +25,16 @@ namespace cachelot {
      * new table allocated as a new primary and every update operation on dict moves some
      * items from the secondary table back to the primary, util no items left in the secondary
      *
+     * dict shrinks the same way when it becomes sparse after the mass removal (see shrink_if_sparse()),
+     * but never below its initial size. Table filled up by the deleted slots rather than by items is rehashed at the same size
+     *
+     * In the background rehash mode (see rehash_step()) update operations don't move items,
+     * expansion begins ahead of time and items are moved by the caller when it's idle.
+     * Update operations move items only when background work falls behind and the new table is about to fill up
+     *
+     * dict based on the group_hash_table may be read by the lock-free readers (see enable_concurrent_reads()),
+     * while it's expanding they have to fallback to the locked path
+     *
      * @note dict does not manage stored items lifetime. It expects items to be POD data with trivial destructor and copy.
      *
      * @tparam Key - key type
@@ -49,6 +61,10 @@ namespace cachelot {
      *      typedef size_t hash_type;
      *      // percentage of hash table fill untill threshold, must be in (0, 100) range
      *      static constexpr size_type max_load_factor_percent = 93;
+     *      // use group_hash_table (probes tags of 16 slots at once) instead of the Robin Hood hash_table
+     *      static constexpr bool group_probing = false;
+     *      // keep the fingerprint of the key next to its hash, `Entry::fingerprint(key)` must be provided (group_hash_table only)
+     *      static constexpr bool key_fingerprints = false;
      *  };
      * @endcode
      *
@@ -57,7 +73,9 @@ namespace cachelot {
     template <typename Key, typename T, typename KeyEqual = std::equal_to<Key>,
               class Entry = internal::hash_table_entry<Key, T>, class Options = internal::DefaultOptions>
     class dict {
-        typedef hash_table<Key, T, KeyEqual, Entry, Options> hash_table_type;
+        typedef typename std::conditional<Options::group_probing,
+                                          group_hash_table<Key, T, KeyEqual, Entry, Options>,
+                                          hash_table<Key, T, KeyEqual, Entry, Options>>::type hash_table_type;
     public:
         typedef typename hash_table_type::size_type size_type;
         typedef typename hash_table_type::hash_type hash_type;
@@ -116,15 +134,33 @@ namespace cachelot {
 
     private:
         static constexpr size_type default_initial_size = 16;
+        /// number of items moved by every update operation during expansion
+        static constexpr size_type inline_rehash_batch_size = 512;
         typedef typename hash_table_type::entry_type entry;
 
     public:
-        /// constructor
-        dict(const size_type initial_size = default_initial_size)
+        /// in the background rehash mode expansion begins when table is filled by this percentage of its threshold
+        static constexpr size_type background_expand_percent = 75;
+        /// table is shrunk when it's filled by less than this percentage of its threshold
+        static constexpr size_type shrink_percent = 20;
+        /// table which reached its threshold while items fill less than this percentage of it
+        /// is rehashed at the same size to get rid of the deleted slots (group_hash_table)
+        static constexpr size_type same_size_rehash_percent = 50;
+
+        /**
+         * constructor
+         *
+         * @param initial_size - number of reserved items
+         * @param background_rehash - leave the expansion to rehash_step() instead of doing it by the update operations
+         */
+        dict(const size_type initial_size = default_initial_size, const bool background_rehash = false)
             : m_primary_tbl(new hash_table_type(roundup_pow2(initial_size)))
             , m_secondary_tbl(nullptr)
             , m_hashpower(log2u(roundup_pow2(initial_size)))
+            , m_min_hashpower(m_hashpower)
             , m_expand_pos(0)
+            , m_background_rehash(background_rehash)
+            , m_concurrent(nullptr)
         {
             debug_assert(initial_size > 0);
             if (not m_primary_tbl->ok()) {
@@ -155,6 +191,37 @@ namespace cachelot {
             }
         }
 
+        /**
+         * Allow lock-free readers of the `epochs` domain
+         *
+         * Writers remain serialized, concurrent_get() may be called at the same time from the other threads
+         */
+        void enable_concurrent_reads(epoch_domain & epochs) {
+            static_assert(Options::group_probing, "concurrent reads require group_hash_table");
+            debug_assert(not is_expanding());
+            if (not m_primary_tbl->enable_concurrent_reads()) {
+                throw std::bad_alloc();
+            }
+            m_concurrent.reset(new concurrent_state(epochs));
+            m_concurrent->published.store(raw_pointer(m_primary_tbl), std::memory_order_release);
+        }
+
+        /**
+         * Lookup by the lock-free reader, see group_hash_table::concurrent_get()
+         *
+         * @return tuple<completed, found, value> where `completed` is `false` if lookup conflicted with the writer or dict is expanding
+         * @note reader must be within the epoch_domain::read_guard of the domain given to enable_concurrent_reads()
+         */
+        template <typename Match>
+        tuple<bool, bool, mapped_type> concurrent_get(const hash_type hash, Match match) const {
+            debug_assert(m_concurrent);
+            const hash_table_type * table = m_concurrent->published.load(std::memory_order_acquire);
+            if (table == nullptr) {
+                return tuple<bool, bool, mapped_type>(false, false, mapped_type());
+            }
+            return table->concurrent_get(hash, match);
+        }
+
         /// return either iterator referencing existing entry or pointer to insertion position
         tuple<bool, iterator> entry_for(key_type key, hash_type hash, bool readonly = false) {
             if (not is_expanding()) {
@@ -182,11 +249,28 @@ namespace cachelot {
                 if (not deleted) {
                     deleted = m_primary_tbl->del(key, hash);
                 }
-                rehash_some();
+                if (inline_rehash_required()) {
+                    rehash_some(inline_rehash_batch_size);
+                }
                 return deleted;
             }
         }
 
+        /**
+         * Begin to shrink the table if less than `shrink_percent` of its threshold is used
+         *
+         * Removal operations never shrink the table themselves, so iterators obtained before them stay valid,
+         * caller checks it once no iterator is in use.
+         * Items are moved to the smaller table the same way as on expansion, in the background rehash mode
+         * shrinking is left to the rehash_step()
+         * @note invalidates iterators
+         */
+        void shrink_if_sparse() noexcept {
+            if (not m_background_rehash && not is_expanding() && shrink_due()) {
+                begin_shrink();
+            }
+        }
+
         /// @copydoc hash_table::remove
         void remove(iterator where) noexcept {
             hash_table_type * table = where.m_table;
@@ -213,6 +297,25 @@ namespace cachelot {
             }
         }
 
+        /// @copydoc hash_table::prefetch
+        void prefetch(const hash_type hash) const noexcept {
+            m_primary_tbl->prefetch(hash);
+            if (is_expanding()) {
+                m_secondary_tbl->prefetch(hash);
+            }
+        }
+
+        /// @copydoc hash_table::entry_with_hash
+        const entry_type * entry_with_hash(const hash_type hash) const noexcept {
+            if (is_expanding()) {
+                const entry_type * e = m_secondary_tbl->entry_with_hash(hash);
+                if (e != nullptr) {
+                    return e;
+                }
+            }
+            return m_primary_tbl->entry_with_hash(hash);
+        }
+
         /// capacity of dict
         size_type capacity() const noexcept {
             return m_primary_tbl->capacity();
@@ -233,12 +336,41 @@ namespace cachelot {
             return size() == 0;
         }
 
-        /// indicates that dict is in progress of moving items to the new hash_table
+        /// indicates that dict is in progress of moving items to the new (larger or smaller) hash_table
         bool is_expanding() const noexcept { return m_secondary_tbl != nullptr; }
 
+        /// check whether expansion is left to rehash_step()
+        bool background_rehash() const noexcept { return m_background_rehash; }
+
+        /**
+         * Background expansion work, up to `max_items` items are moved to the new table
+         *
+         * Expansion begins once the table is filled by the `background_expand_percent` of its threshold,
+         * shrinking once it's filled by less than `shrink_percent`.
+         * New table is allocated by this call, so update operations neither allocate nor move items.
+         * Call it repeatedly while it returns `true` (there is more work to do) and periodically afterwards
+         * @note useful only in the background rehash mode, otherwise update operations do the work themselves
+         */
+        bool rehash_step(const size_type max_items) {
+            debug_assert(max_items > 0);
+            if (not is_expanding()) {
+                if (background_expand_due(m_primary_tbl->size(), *m_primary_tbl)) {
+                    begin_expand();
+                    return true;
+                }
+                return shrink_due() && begin_shrink();
+            }
+            rehash_some(max_items);
+            return is_expanding();
+        }
+
         /// empty the dictionary
         void clear() noexcept {
-            m_secondary_tbl.reset(nullptr);
+            if (is_expanding()) {
+                // readers aren't allowed during expansion
+                m_secondary_tbl.reset(nullptr);
+                publish_primary();
+            }
             m_primary_tbl->clear();
         }
 
@@ -264,19 +396,16 @@ namespace cachelot {
         }
 
         tuple<bool, iterator> search_secondary(key_type key, hash_type hash) noexcept {
-            rehash_some();
+            if (inline_rehash_required()) {
+                rehash_some(inline_rehash_batch_size);
+            }
             if (is_expanding()) {  // are we still expanding after rehash
                 bool found; size_type old_pos;
                 // lookup in secondary table first
                 tie(found, old_pos) = m_secondary_tbl->entry_for(key, hash);
                 if (found) {
                     // move item to the primary table and return its position there
-                    bool __; size_type new_pos;
-                    tie(__, new_pos) = m_primary_tbl->entry_for(key, hash);
-                    debug_assert(not __); // not found in primary as it is in secondary already
-                    const entry_type & e = m_secondary_tbl->entry_at(old_pos);
-                    new_pos = m_primary_tbl->insert(new_pos, e.key(), hash, e.value());
-                    m_secondary_tbl->remove(old_pos);
+                    const size_type new_pos = move_to_primary(old_pos);
                     return make_tuple(true, iter(m_primary_tbl, new_pos));
                 }
             }
@@ -286,17 +415,66 @@ namespace cachelot {
         }
 
         void begin_expand() {
+            debug_assert(not is_expanding());
+            // threshold may be reached by the deleted slots rather than by items, table doesn't need to grow then
+            const size_type new_hashpower = sparse(m_primary_tbl->size(), m_hashpower, same_size_rehash_percent) ? m_hashpower : m_hashpower + 1;
+            std::unique_ptr<hash_table_type> new_table = allocate_table(new_hashpower);
+            if (not new_table) {
+                throw std::bad_alloc();
+            }
+            begin_resize(std::move(new_table), new_hashpower);
+        }
+
+        /// begin to shrink the table to the size where items fill less than twice the `shrink_percent` of threshold,
+        /// return `false` if there is no memory for the new table
+        bool begin_shrink() noexcept {
+            debug_assert(not is_expanding());
+            debug_assert(m_hashpower > m_min_hashpower);
+            size_type new_hashpower = m_hashpower - 1;
+            while (new_hashpower > m_min_hashpower && sparse(size(), new_hashpower - 1, 2 * shrink_percent)) {
+                new_hashpower -= 1;
+            }
+            std::unique_ptr<hash_table_type> new_table = allocate_table(new_hashpower);
+            if (not new_table) {
+                return false;
+            }
+            begin_resize(std::move(new_table), new_hashpower);
+            return true;
+        }
+
+        /// check whether the table is sparse enough to be shrunk
+        bool shrink_due() const noexcept {
+            return m_hashpower > m_min_hashpower && sparse(size(), m_hashpower, shrink_percent);
+        }
+
+        /// check whether `num_items` fill less than `percent` of the threshold of the table of `hashpower`
+        static bool sparse(const size_type num_items, const size_type hashpower, const size_type percent) noexcept {
+            return uint64(num_items) * 100 < pow2(uint64(hashpower)) * Options::max_load_factor_percent / 100 * percent;
+        }
+
+        /// new table of `pow2(hashpower)` capacity, `nullptr` if there is not enough memory
+        std::unique_ptr<hash_table_type> allocate_table(const size_type hashpower) const noexcept {
+            std::unique_ptr<hash_table_type> new_table(new (nothrow) hash_table_type(pow2(hashpower)));
+            if (not new_table || not new_table->ok() || (m_concurrent && not enable_concurrent_reads(*new_table, std::integral_constant<bool, Options::group_probing>()))) {
+                return nullptr;
+            }
+            return new_table;
+        }
+
+        /// make the `new_table` primary and begin to move items there from the current one
+        void begin_resize(std::unique_ptr<hash_table_type> new_table, const size_type new_hashpower) noexcept {
             debug_assert(not is_expanding());
             m_expand_pos = 0;
+            if (m_concurrent) {
+                // readers fallback to the locked path until expansion is done, so entries may move freely
+                m_concurrent->published.store(nullptr, std::memory_order_release);
+                m_concurrent->epochs.synchronize();
+            }
             m_primary_tbl.swap(m_secondary_tbl);
-            m_primary_tbl.reset(new hash_table_type(pow2(m_hashpower + 1)));
-            if (m_primary_tbl && m_primary_tbl->ok()) {
-                m_hashpower += 1;
-                rehash_some();
-            } else {
-                m_primary_tbl.swap(m_secondary_tbl);
-                m_secondary_tbl.reset(nullptr);
-                throw std::bad_alloc();
+            m_primary_tbl = std::move(new_table);
+            m_hashpower = new_hashpower;
+            if (not m_background_rehash) {
+                rehash_some(inline_rehash_batch_size);
             }
         }
 
@@ -305,23 +483,68 @@ namespace cachelot {
             debug_assert(m_secondary_tbl->empty());
             m_secondary_tbl.reset(nullptr);
             m_expand_pos = 0;
+            publish_primary();
         }
 
-        void rehash_some() noexcept {
-            static constexpr size_type min_batch_size = 512;
-            const size_type batch_size = std::min<size_type>(min_batch_size, m_secondary_tbl->size());
+        /// let the lock-free readers use the primary table
+        void publish_primary() noexcept {
+            if (m_concurrent) {
+                m_concurrent->published.store(raw_pointer(m_primary_tbl), std::memory_order_release);
+            }
+        }
+
+        /// allow lock-free readers of the `table` (group_hash_table only)
+        static bool enable_concurrent_reads(hash_table_type & table, std::true_type /*group_probing*/) noexcept {
+            return table.enable_concurrent_reads();
+        }
+
+        static bool enable_concurrent_reads(hash_table_type &, std::false_type /*group_probing*/) noexcept {
+            return false;
+        }
+
+        /// check whether `num_items` fill the `table` enough to begin its expansion in the background rehash mode
+        static bool background_expand_due(const size_type num_items, const hash_table_type & table) noexcept {
+            return uint64(num_items) * 100 >= uint64(table.max_size()) * background_expand_percent;
+        }
+
+        /// update operations move items unless it's left to the background work which is not too late yet
+        /// (all the items must fit the new table before it needs to expand again)
+        bool inline_rehash_required() const noexcept {
+            return not m_background_rehash || background_expand_due(size(), *m_primary_tbl);
+        }
+
+        /// move entry at `pos` of the secondary table to the primary one, return its new position
+        size_type move_to_primary(const size_type pos) noexcept {
+            debug_assert(not m_primary_tbl->contains(m_secondary_tbl->entry_at(pos).key(), m_secondary_tbl->hash_at(pos)));
+            return move_entry(*m_primary_tbl, *m_secondary_tbl, pos, std::integral_constant<bool, Options::group_probing>());
+        }
+
+        /// group_hash_table copies the stored hash and fingerprint, so entry isn't dereferenced
+        static size_type move_entry(hash_table_type & to, hash_table_type & from, const size_type pos, std::true_type /*group_probing*/) noexcept {
+            return to.move_from(from, pos);
+        }
+
+        static size_type move_entry(hash_table_type & to, hash_table_type & from, const size_type pos, std::false_type /*group_probing*/) noexcept {
+            const hash_type hash = from.hash_at(pos);
+            const entry_type & e = from.entry_at(pos);
+            bool __; size_type new_pos;
+            tie(__, new_pos) = to.entry_for(e.key(), hash);
+            debug_assert(not __);
+            new_pos = to.insert(new_pos, e.key(), hash, e.value());
+            from.remove(pos);
+            return new_pos;
+        }
+
+        void rehash_some(const size_type max_items) noexcept {
+            debug_assert(is_expanding());
+            const size_type batch_size = std::min<size_type>(max_items, m_secondary_tbl->size());
             size_type elements_moved = 0;
             while (elements_moved < batch_size) {
                 while (m_secondary_tbl->empty_at(m_expand_pos)) {
                     m_expand_pos += 1;
                 }
                 debug_assert(m_expand_pos < m_secondary_tbl->capacity());
-                const hash_table_type * old = m_secondary_tbl.get();
-                hash_type hash = old->hash_at(m_expand_pos);
-                const entry_type & e = old->entry_at(m_expand_pos);
-                debug_assert(not m_primary_tbl->contains(e.key(), hash));
-                m_primary_tbl->put(e.key(), hash, e.value());
-                m_secondary_tbl->remove(m_expand_pos);
+                move_to_primary(m_expand_pos);
                 elements_moved += 1;
             }
             if (m_secondary_tbl->empty()) {
@@ -333,7 +556,18 @@ namespace cachelot {
         std::unique_ptr<hash_table_type> m_primary_tbl;
         std::unique_ptr<hash_table_type> m_secondary_tbl;
         size_type m_hashpower;  // power of 2
+        size_type m_min_hashpower; // dict doesn't shrink below its initial size
         size_type m_expand_pos; // index of last element moved from secondary table to the primary
+        bool m_background_rehash; // expansion is done by rehash_step()
+
+        /// state shared with the lock-free readers, it's kept on the heap to make the dict movable
+        struct concurrent_state {
+            explicit concurrent_state(epoch_domain & the_epochs) noexcept : epochs(the_epochs), published(nullptr) {}
+            epoch_domain & epochs;
+            // table readers look into, `nullptr` while dict is expanding
+            std::atomic<hash_table_type *> published;
+        };
+        std::unique_ptr<concurrent_state> m_concurrent;
     };
 
 } // namespace cachelot
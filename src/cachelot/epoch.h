@@ -0,0 +1,208 @@
+#ifndef CACHELOT_EPOCH_H_INCLUDED
+#define CACHELOT_EPOCH_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+#ifndef CACHELOT_COMMON_H_INCLUDED
+#  include <cachelot/common.h>
+#endif
+#ifndef CACHELOT_BITS_H_INCLUDED
+#  include <cachelot/bits.h>
+#endif
+
+#include <atomic>
+#include <deque>
+#include <thread>
+
+namespace cachelot {
+
+    /// @addtogroup memalloc
+    /// @{
+
+    /**
+     * Epoch based reclamation of the memory shared with the lock-free readers
+     *
+     * Reader announces the current epoch in its slot for the duration of the read (see read_guard),
+     * writer stamps the removed memory with the epoch of removal (see retire()).
+     * Memory is safe to reuse when every active reader announced the later epoch,
+     * as reader which entered after the removal can't reach the removed memory anymore.
+     *
+     * @note Writer side is not thread safe, writers must be serialized by the caller (i.e. by the shard lock)
+     */
+    class epoch_domain {
+    public:
+        /// maximal number of threads reading at the same time, the rest must fallback to the locked path
+        static constexpr size_t max_readers = 64;
+
+        /**
+         * Scope of the lock-free read, memory reachable within it is not reused until guard is released
+         *
+         * @note guard is not re-entrant, thread must not hold two guards of the same domain
+         */
+        class read_guard {
+        public:
+            explicit read_guard(const epoch_domain & domain) noexcept
+                : m_slot(this_thread_slot())
+                , m_epoch(nullptr) {
+                if (m_slot < max_readers) {
+                    m_epoch = &domain.m_readers[m_slot].epoch;
+                    // stale (older) epoch is fine, it's only more conservative
+                    m_epoch->store(domain.m_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    // announcement must be visible to the writer before anything is read
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                }
+            }
+
+            ~read_guard() {
+                if (m_epoch != nullptr) {
+                    m_epoch->store(0, std::memory_order_release);
+                }
+            }
+
+            /// `false` if there are too many readers already
+            bool ok() const noexcept { return m_epoch != nullptr; }
+
+            /// number of the reader slot in range `[0, max_readers)`
+            size_t slot() const noexcept { return m_slot; }
+
+            // disallow copying
+            read_guard(const read_guard &) = delete;
+            read_guard & operator= (const read_guard &) = delete;
+
+        private:
+            const size_t m_slot;
+            std::atomic<uint64> * m_epoch;
+        };
+
+    public:
+        /// constructor
+        epoch_domain() noexcept
+            : m_epoch(1) {
+            for (auto & reader : m_readers) {
+                reader.epoch.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        // disallow copying
+        epoch_domain(const epoch_domain &) = delete;
+        epoch_domain & operator= (const epoch_domain &) = delete;
+
+        /// stamp removed `ptr` with the current epoch, it's passed to the `reclaim()` callback once no reader may access it
+        /// @note `ptr` must be unreachable for the readers entering from now on
+        void retire(void * ptr) {
+            m_retired.emplace_back(m_epoch.load(std::memory_order_relaxed), ptr);
+        }
+
+        /// number of retired pointers waiting for reclamation
+        size_t num_retired() const noexcept { return m_retired.size(); }
+
+        /// call `on_reclaimed(void * ptr)` for every retired pointer no reader may access anymore, return number of them
+        template <typename ForeachReclaimed>
+        size_t reclaim(ForeachReclaimed on_reclaimed) {
+            if (m_retired.empty()) {
+                return 0;
+            }
+            const uint64 oldest = oldest_active_epoch();
+            size_t num_reclaimed = 0;
+            while (not m_retired.empty() && m_retired.front().first < oldest) {
+                on_reclaimed(m_retired.front().second);
+                m_retired.pop_front();
+                num_reclaimed += 1;
+            }
+            return num_reclaimed;
+        }
+
+        /// wait until every reader which may access memory removed before the call leaves
+        void synchronize() noexcept {
+            const uint64 current = advance();
+            for (const auto & reader : m_readers) {
+                for (unsigned spins = 0; ; ++spins) {
+                    const uint64 announced = reader.epoch.load(std::memory_order_acquire);
+                    if (announced == 0 || announced >= current) {
+                        break;
+                    }
+                    if (spins > 64) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        }
+
+    private:
+        /// start the new epoch, return its number
+        uint64 advance() noexcept {
+            const uint64 current = m_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+            // removals must be visible before the announcements are checked
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return current;
+        }
+
+        /// start the new epoch, return the oldest one announced by the active readers
+        uint64 oldest_active_epoch() noexcept {
+            uint64 oldest = advance();
+            for (const auto & reader : m_readers) {
+                const uint64 announced = reader.epoch.load(std::memory_order_acquire);
+                if (announced != 0 && announced < oldest) {
+                    oldest = announced;
+                }
+            }
+            return oldest;
+        }
+
+        /// process-wide slot of the calling thread (the same in every domain), `max_readers` if there is no free one
+        static size_t this_thread_slot() noexcept {
+            static thread_local const reader_registration registration;
+            return registration.slot;
+        }
+
+        /// thread occupies the slot from the first read until its exit
+        struct reader_registration {
+            reader_registration() noexcept : slot(max_readers) {
+                uint64 taken = slots_taken().load(std::memory_order_relaxed);
+                while (taken != ~uint64(0)) {
+                    const size_t free_slot = bit::least_significant(~taken);
+                    if (slots_taken().compare_exchange_weak(taken, taken | (uint64(1) << free_slot), std::memory_order_acq_rel)) {
+                        slot = free_slot;
+                        break;
+                    }
+                }
+            }
+
+            ~reader_registration() {
+                if (slot < max_readers) {
+                    slots_taken().fetch_and(~(uint64(1) << slot), std::memory_order_acq_rel);
+                }
+            }
+
+            static std::atomic<uint64> & slots_taken() noexcept {
+                static std::atomic<uint64> the_slots(0);
+                return the_slots;
+            }
+
+            size_t slot;
+        };
+        static_assert(max_readers == sizeof(uint64) * 8, "reader slots are tracked by the bitmask");
+
+        /// announced epoch (`0` - reader is inactive), padded to not share the cache line with other readers
+        struct reader_slot {
+            std::atomic<uint64> epoch;
+            char padding[cpu_l1d_cache_line - sizeof(std::atomic<uint64>)];
+        };
+
+    private:
+        std::atomic<uint64> m_epoch;
+        // written by the readers
+        mutable reader_slot m_readers[max_readers];
+        // retired pointers ordered by the epoch of their removal
+        std::deque<std::pair<uint64, void *>> m_retired;
+    };
+
+    /// @}
+
+} // namespace cachelot
+
+#endif // CACHELOT_EPOCH_H_INCLUDED
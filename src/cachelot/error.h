@@ -23,10 +23,11 @@ namespace cachelot {
         x(numeric_convert,      "Numeric conversion error")         \
         x(numeric_overflow,     "Numeric value is out of range")    \
         x(key_too_long,         "Key is too long")                  \
-        x(item_too_big,         "Item size exceeds the page size")  \
+        x(item_too_big,         "Item is too big")                  \
         x(not_implemented,      "Operation does not supported")     \
         x(incomplete_request,   "Request packet is incomplete")     \
-        x(broken_request,       "Request packet is broken")
+        x(broken_request,       "Request packet is broken")         \
+        x(not_admitted,         "Rejected by the admission filter")
 
     /// system error handling
     using boost::system::error_code;      // boost::error is used rather than std's because it is used by boost::asio
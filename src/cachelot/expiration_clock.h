@@ -9,6 +9,7 @@
 
 
 #include <chrono>   // std::chrono
+#include <atomic>   // std::atomic
 
 /// @ingroup cache
 /// @{
@@ -19,8 +20,14 @@ namespace cachelot {
 
         typedef std::chrono::duration<uint32> seconds;
 
-        /// Simple std::chrono based monotonic clock to count item expiration time in secons
-        /// Custom clock type allows to use uint32 time_point
+        /**
+         * Simple std::chrono based monotonic clock to count item expiration time in secons
+         * Custom clock type allows to use uint32 time_point
+         *
+         * Reading the system clock on every item access is relatively expensive, while expiration
+         * requires only the second resolution. In the *cached* mode now() returns the value stored
+         * by the last tick(), which is called periodically by an event loop timer (see `net::clock_ticker`)
+         */
         class ExpirationClock {
         public:
             typedef seconds duration;
@@ -29,10 +36,47 @@ namespace cachelot {
             typedef std::chrono::time_point<ExpirationClock, seconds> time_point;
             static constexpr bool is_steady = true;
 
+            /// current time, either cached or read from the system clock
             static time_point now() noexcept {
+                if (cached_flag().load(std::memory_order_relaxed)) {
+                    return time_point(duration(cached_time().load(std::memory_order_relaxed)));
+                }
+                return precise_now();
+            }
+
+            /// current time read from the system clock
+            static time_point precise_now() noexcept {
                 const auto now = std::chrono::steady_clock::now();
                 return time_point(std::chrono::duration_cast<duration>(now.time_since_epoch()));
             }
+
+            /// update cached time
+            static void tick() noexcept {
+                cached_time().store(precise_now().time_since_epoch().count(), std::memory_order_relaxed);
+            }
+
+            /// switch between cached and precise mode
+            /// cached time is updated only by tick(), caller must ensure that it's called at least once per second
+            static void set_cached(const bool enable) noexcept {
+                if (enable) {
+                    tick();
+                }
+                cached_flag().store(enable, std::memory_order_relaxed);
+            }
+
+            /// check whether clock is in the cached mode
+            static bool is_cached() noexcept { return cached_flag().load(std::memory_order_relaxed); }
+
+        private:
+            static std::atomic<rep> & cached_time() noexcept {
+                static std::atomic<rep> the_time(0);
+                return the_time;
+            }
+
+            static std::atomic<bool> & cached_flag() noexcept {
+                static std::atomic<bool> the_flag(false);
+                return the_flag;
+            }
        };
 
 
@@ -0,0 +1,125 @@
+#ifndef CACHELOT_FREQUENCY_SKETCH_H_INCLUDED
+#define CACHELOT_FREQUENCY_SKETCH_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+#ifndef CACHELOT_BITS_H_INCLUDED
+#  include <cachelot/bits.h> // pow2 utils
+#endif
+
+namespace cachelot {
+
+    /// @addtogroup cache
+    /// @{
+
+   /**
+    * Approximate counter of recent occurrences of the hash values (Count-Min Sketch used by the TinyLFU admission)
+    *
+    * Counters are 4 bits wide and packed by 16 into the 64-bit words, every hash is mapped to `depth` of them
+    * and the estimation is the minimum among them. So the sketch takes 4 bits per tracked hash and never underestimates.
+    * Only the smallest of the hash counters are incremented (conservative update), which reduces overestimation by collisions.
+    * Once the number of increments reaches the number of counters, all of the counters are halved,
+    * that way the old history fades out.
+    */
+    template <typename HashType>
+    class frequency_sketch {
+        typedef uint64 word_type;
+    public:
+        /// maximal value of the single counter
+        static constexpr uint32 max_frequency = 15;
+        /// number of counters per hash
+        static constexpr uint32 depth = 4;
+
+        /// constructor
+        /// @p expected_items - number of distinct hashes to track
+        explicit frequency_sketch(const size_t expected_items)
+            : m_table(roundup_pow2<size_t>(std::max<size_t>(expected_items, counters_per_word)) / counters_per_word, 0)
+            , m_counter_mask(m_table.size() * counters_per_word - 1)
+            , m_sample_size(m_table.size() * counters_per_word)
+            , m_num_increments(0) {
+        }
+
+        /// count one more occurrence of the `hash`
+        void increment(const HashType hash) noexcept {
+            const uint32 frequency = estimate(hash);
+            if (frequency == max_frequency) {
+                return;
+            }
+            uint32 h1, h2; tie(h1, h2) = spread(hash);
+            for (uint32 n = 0; n < depth; ++n) {
+                const size_t counter_no = (h1 + n * h2) & m_counter_mask;
+                if (counter_at(counter_no) == frequency) {
+                    increment_at(counter_no);
+                }
+            }
+            if (++m_num_increments >= m_sample_size) {
+                age();
+            }
+        }
+
+        /// estimated number of recent occurrences of the `hash`
+        uint32 estimate(const HashType hash) const noexcept {
+            uint32 h1, h2; tie(h1, h2) = spread(hash);
+            uint32 frequency = max_frequency;
+            for (uint32 n = 0; n < depth; ++n) {
+                frequency = std::min(frequency, counter_at((h1 + n * h2) & m_counter_mask));
+            }
+            return frequency;
+        }
+
+        /// halve all of the counters
+        void age() noexcept {
+            constexpr word_type halve_mask = 0x7777777777777777ull;
+            for (auto & word : m_table) {
+                word = (word >> 1) & halve_mask;
+            }
+            m_num_increments /= 2;
+        }
+
+        /// total number of counters
+        size_t num_counters() const noexcept { return m_table.size() * counters_per_word; }
+
+    private:
+        static constexpr uint32 counter_bits = 4;
+        static constexpr uint32 counters_per_word = sizeof(word_type) * 8 / counter_bits;
+
+        /// derive two independent indexes from the `hash` (counters are chosen by the double hashing)
+        static tuple<uint32, uint32> spread(const HashType hash) noexcept {
+            uint64 x = static_cast<uint64>(hash);
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            x = x ^ (x >> 31);
+            // second index must be odd to visit different counters
+            return make_tuple(static_cast<uint32>(x), static_cast<uint32>(x >> 32) | 1u);
+        }
+
+        uint32 counter_at(const size_t counter_no) const noexcept {
+            const auto shift = (counter_no % counters_per_word) * counter_bits;
+            return static_cast<uint32>((m_table[counter_no / counters_per_word] >> shift) & max_frequency);
+        }
+
+        void increment_at(const size_t counter_no) noexcept {
+            const auto shift = (counter_no % counters_per_word) * counter_bits;
+            debug_assert(((m_table[counter_no / counters_per_word] >> shift) & max_frequency) < max_frequency);
+            m_table[counter_no / counters_per_word] += word_type(1) << shift;
+        }
+
+    private:
+        std::vector<word_type> m_table;
+        const size_t m_counter_mask;
+        const size_t m_sample_size;
+        size_t m_num_increments;
+    };
+
+    template <typename HashType> constexpr uint32 frequency_sketch<HashType>::max_frequency;
+    template <typename HashType> constexpr uint32 frequency_sketch<HashType>::depth;
+
+    /// @}
+
+} // namespace cachelot
+
+#endif // CACHELOT_FREQUENCY_SKETCH_H_INCLUDED
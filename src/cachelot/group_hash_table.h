@@ -0,0 +1,528 @@
+#ifndef CACHELOT_GROUP_HASH_TABLE_H_INCLUDED
+#define CACHELOT_GROUP_HASH_TABLE_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+
+#include <cachelot/hash_table.h> // hash_table_entry, DefaultOptions
+#include <atomic>
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+namespace cachelot {
+
+    namespace internal {
+
+        /**
+         * Group of the hash_table control bytes (tags) probed at once
+         *
+         * Each slot has 1-byte tag: either `empty`, `deleted` or 7 bits of the hash value of stored entry
+         * Tags of a group are compared in a single SSE2 instruction, or one by one if SSE2 is not available
+         */
+        struct tag_group {
+            typedef uint8 tag_type;
+            static constexpr size_t size = 16;
+            static constexpr tag_type empty = 0x80;
+            static constexpr tag_type deleted = 0xFE;
+            static constexpr tag_type sentinel = 0xFF; // padding of a table smaller than a group
+            static constexpr tag_type tag_mask = 0x7F;
+
+            explicit tag_group(const tag_type * tags) noexcept : m_tags(tags) {}
+
+            /// bitmask of the slots which tag equals `tag`
+            uint32 match(const tag_type tag) const noexcept {
+            #if defined(__SSE2__)
+                const __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(m_tags));
+                return static_cast<uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(tag)))));
+            #else
+                uint32 result = 0;
+                for (size_t n = 0; n < size; ++n) {
+                    if (m_tags[n] == tag) {
+                        result |= (1u << n);
+                    }
+                }
+                return result;
+            #endif
+            }
+
+            /// bitmask of the empty slots
+            uint32 match_empty() const noexcept { return match(empty); }
+
+            /// bitmask of the slots available for insertion (either empty or deleted)
+            uint32 match_available() const noexcept { return match(empty) | match(deleted); }
+
+        private:
+            const tag_type * m_tags;
+        };
+
+
+        /// full hash value of the stored entry
+        template <typename HashType, bool WithFingerprint>
+        struct stored_hash {
+            HashType hash;
+
+            void assign(const HashType the_hash, const uint32) noexcept { hash = the_hash; }
+            constexpr bool fingerprint_matches(const uint32) const noexcept { return true; }
+        };
+
+        /// full hash value of the stored entry along with the independent fingerprint of its key
+        template <typename HashType>
+        struct stored_hash<HashType, true> {
+            HashType hash;
+            uint32 fingerprint;
+
+            void assign(const HashType the_hash, const uint32 the_fingerprint) noexcept { hash = the_hash; fingerprint = the_fingerprint; }
+            constexpr bool fingerprint_matches(const uint32 other) const noexcept { return fingerprint == other; }
+        };
+
+    } // namespace internal
+
+
+    /**
+     * Open addressing hash table that probes slots by groups of 16 (a.k.a. [SwissTable](https://abseil.io/about/design/swisstables))
+     *
+     * In addition to the full hash values, 7 bits of every hash are kept in a compact array of tags.
+     * Lookup compares the whole group of tags at once and touches hashes and entries only on tag match,
+     * that makes both hits and misses cheap even when table is almost full.
+     * It has the same interface as hash_table and is selected by the `Options::group_probing`
+     *
+     * Table may be read by the lock-free readers along with a single writer (see concurrent_get()),
+     * every group has a version which is odd while the group is being modified (seqlock).
+     * Readers must not dereference stored values unless they're protected from reuse (see epoch_domain)
+     *
+     * With `Options::key_fingerprints` every stored hash is followed by the 32-bit fingerprint of the key
+     * (`Entry::fingerprint(key)`), independent of the hash. Keys are compared only if both hash and fingerprint match,
+     * which pays off when `Entry::key()` is expensive (e.g. dereferences the pointer)
+     *
+     * @note this is low level implementation class it doesn't support resizing
+     * @see dict class
+     * @ingroup common
+     */
+    template <typename Key, typename T, typename KeyEqual = std::equal_to<Key>,
+              class Entry = internal::hash_table_entry<Key, T>, class Options = internal::DefaultOptions>
+    class group_hash_table {
+    public:
+        typedef Key key_type;
+        typedef T mapped_type;
+        typedef KeyEqual key_equal;
+        typedef Entry entry_type;
+        typedef typename Options::size_type size_type;
+        typedef typename Options::hash_type hash_type;
+        static constexpr size_type max_load_factor_percent = Options::max_load_factor_percent;
+        static_assert(std::is_unsigned<size_type>::value, "size_type must be unsigned");
+        static_assert((max_load_factor_percent > 0) && (max_load_factor_percent < 100), "max_load_factor_percent must be in range (0..100)");
+    private:
+        // implementation details
+        typedef internal::tag_group group;
+        typedef group::tag_type tag_type;
+        typedef std::unique_ptr<tag_type[]> tag_array_type;
+        typedef internal::stored_hash<hash_type, Options::key_fingerprints> stored_hash_type;
+        typedef std::unique_ptr<stored_hash_type[]> hash_array_type;
+        typedef std::unique_ptr<entry_type[]> entry_array_type;
+        typedef std::unique_ptr<std::atomic<uint32>[]> version_array_type;
+        static constexpr size_type group_size = static_cast<size_type>(group::size);
+    public:
+        /// constructor
+        group_hash_table(const size_type the_capacity) noexcept
+            : m_size(0)
+            , m_num_deleted(0)
+            , m_capacity(the_capacity)
+            , m_group_mask(std::max<size_type>(the_capacity / group_size, 1) - 1)
+            , m_tags(new (nothrow) tag_type[std::max<size_type>(the_capacity, static_cast<size_type>(group_size))])
+            , m_hashes(new (nothrow) stored_hash_type[the_capacity])
+            , m_entries(new (nothrow) entry_type[the_capacity])
+            , m_versions(nullptr) {
+            debug_assert(the_capacity > 0);
+            debug_assert(ispow2(the_capacity));
+            if (ok()) {
+                // tail of the single group of a small table is never used
+                for (size_type pos = the_capacity; pos < group_size; ++pos) {
+                    m_tags[pos] = group::sentinel;
+                }
+                clear();
+            }
+        }
+
+        // disallow copying
+        group_hash_table(const group_hash_table &) = delete;
+        group_hash_table & operator= (const group_hash_table &) = delete;
+
+        /// @copydoc hash_table::get()
+        tuple<bool, mapped_type> get(const key_type key, const hash_type hash) const noexcept {
+            bool found; size_type pos;
+            tie(found, pos) = entry_for(key, hash);
+            mapped_type result = found ? entry_at(pos).value() : mapped_type();
+            return tuple<bool, mapped_type>(found, result);
+        }
+
+        /**
+         * Allow lock-free readers, return `false` if there is not enough memory for the group versions
+         */
+        bool enable_concurrent_reads() noexcept {
+            const size_type num_groups = m_group_mask + 1;
+            m_versions.reset(new (nothrow) std::atomic<uint32>[num_groups]);
+            if (not m_versions) {
+                return false;
+            }
+            for (size_type group_no = 0; group_no < num_groups; ++group_no) {
+                m_versions[group_no].store(0, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        /**
+         * Lookup by the lock-free reader, `match(mapped_type value)` tells whether the value of the matched hash has the key being searched
+         *
+         * Values are passed to the `match` only after the group they're read from is validated,
+         * so they're the values stored in the table at some point
+         * @return tuple<completed, found, value> where `completed` is `false` if lookup conflicted with the writer and has to be retried
+         * @note table must be enabled for the concurrent reads
+         */
+        template <typename Match>
+        tuple<bool, bool, mapped_type> concurrent_get(const hash_type hash, Match match) const {
+            debug_assert(m_versions);
+            const tag_type tag = tag_of(hash);
+            size_type group_no = desired_group(hash);
+            for (size_type num_probes = 1; num_probes <= m_group_mask + 1; ++num_probes) {
+                const uint32 version = m_versions[group_no].load(std::memory_order_acquire);
+                if ((version & 1) != 0) {
+                    // writer is modifying the group
+                    return tuple<bool, bool, mapped_type>(false, false, mapped_type());
+                }
+                const group g(&m_tags[group_no * group_size]);
+                mapped_type candidates[group_size];
+                size_type num_candidates = 0;
+                for (uint32 matches = g.match(tag); matches != 0; matches &= matches - 1) {
+                    const size_type pos = group_no * group_size + bit::least_significant(matches);
+                    if (hash_at(pos) == hash) {
+                        candidates[num_candidates++] = entry_at(pos).value();
+                    }
+                }
+                const bool last_group = g.match_empty() != 0;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (m_versions[group_no].load(std::memory_order_relaxed) != version) {
+                    return tuple<bool, bool, mapped_type>(false, false, mapped_type());
+                }
+                for (size_type n = 0; n < num_candidates; ++n) {
+                    if (match(candidates[n])) {
+                        return tuple<bool, bool, mapped_type>(true, true, candidates[n]);
+                    }
+                }
+                if (last_group) {
+                    break;
+                }
+                group_no = (group_no + num_probes) & m_group_mask;
+            }
+            return tuple<bool, bool, mapped_type>(true, false, mapped_type());
+        }
+
+        /// @copydoc hash_table::put()
+        bool put(key_type key, hash_type hash, mapped_type value) noexcept {
+            bool found; size_type pos;
+            tie(found, pos) = entry_for(key, hash);
+            if (found) {
+                debug_assert(eq(entry_at(pos).key(), key));
+                entry_type & curr_entry = entry_at(pos);
+                entry_type new_entry(key, value);
+                begin_write(pos);
+                std::swap(curr_entry, new_entry);
+                end_write(pos);
+                return false;
+            } else {
+                insert(pos, key, hash, value);
+                return true;
+            }
+        }
+
+        /// @copydoc hash_table::del()
+        bool del(key_type key, hash_type hash) noexcept {
+            bool found; size_type pos;
+            tie(found, pos) = entry_for(key, hash);
+            if (found) {
+                debug_assert(eq(entry_at(pos).key(), key));
+                remove(pos);
+                return true;
+            } else {
+                return false;
+            }
+        }
+
+        /// @copydoc hash_table::remove_if()
+        template <typename ConditionFun>
+        void remove_if(ConditionFun predicate) noexcept {
+            for (size_type pos = 0; pos < capacity(); ++pos) {
+                if (not empty_at(pos) && predicate(entry_at(pos).value())) {
+                    remove(pos);
+                }
+            }
+        }
+
+        /// @copydoc hash_table::contains()
+        bool contains(key_type key, hash_type hash) const noexcept {
+            bool found; size_t __;
+            tie(found, __) = entry_for(key, hash);
+            return found;
+        }
+
+        /// @copydoc hash_table::entry_for()
+        tuple<bool, size_type> entry_for(const key_type key, const hash_type hash) const noexcept {
+            const tag_type tag = tag_of(hash);
+            size_type group_no = desired_group(hash);
+            size_type insert_pos = capacity(); // none yet
+            // fingerprint is calculated only if some hash matches
+            uint32 fingerprint = 0; bool has_fingerprint = false;
+            // triangular probing visits every group once when number of groups is a power of 2
+            for (size_type num_probes = 1; num_probes <= m_group_mask + 1; ++num_probes) {
+                const group g(&m_tags[group_no * group_size]);
+                for (uint32 matches = g.match(tag); matches != 0; matches &= matches - 1) {
+                    const size_type pos = group_no * group_size + bit::least_significant(matches);
+                    if (hash_at(pos) == hash) {
+                        if (not has_fingerprint) {
+                            fingerprint = fingerprint_of(key);
+                            has_fingerprint = true;
+                        }
+                        if (m_hashes[pos].fingerprint_matches(fingerprint) && eq(entry_at(pos).key(), key)) {
+                            return tuple<bool, size_type>(true, pos);
+                        }
+                    }
+                }
+                if (insert_pos == capacity()) {
+                    const uint32 available = g.match_available();
+                    if (available != 0) {
+                        insert_pos = group_no * group_size + bit::least_significant(available);
+                    }
+                }
+                if (g.match_empty() != 0) {
+                    // key would have been placed in this group
+                    break;
+                }
+                group_no = (group_no + num_probes) & m_group_mask;
+            }
+            return tuple<bool, size_type>(false, insert_pos);
+        }
+
+        /// @copydoc hash_table::prefetch()
+        void prefetch(const hash_type hash) const noexcept {
+            const size_type first_pos = desired_group(hash) * group_size;
+            prefetch_read(&m_tags[first_pos]);
+            prefetch_read(&m_hashes[first_pos]);
+            prefetch_read(&m_entries[first_pos]);
+        }
+
+        /// @copydoc hash_table::entry_with_hash()
+        const entry_type * entry_with_hash(const hash_type hash) const noexcept {
+            const tag_type tag = tag_of(hash);
+            size_type group_no = desired_group(hash);
+            for (size_type num_probes = 1; num_probes <= m_group_mask + 1; ++num_probes) {
+                const group g(&m_tags[group_no * group_size]);
+                for (uint32 matches = g.match(tag); matches != 0; matches &= matches - 1) {
+                    const size_type pos = group_no * group_size + bit::least_significant(matches);
+                    if (hash_at(pos) == hash) {
+                        return &entry_at(pos);
+                    }
+                }
+                if (g.match_empty() != 0) {
+                    break;
+                }
+                group_no = (group_no + num_probes) & m_group_mask;
+            }
+            return nullptr;
+        }
+
+        /// @copydoc hash_table::insert()
+        size_type insert(size_type pos, const key_type key, hash_type hash, mapped_type value) noexcept {
+            stored_hash_type stored;
+            stored.assign(hash, fingerprint_of(key));
+            entry_type entry(key, value);
+            return insert_stored(pos, stored, entry);
+        }
+
+        /**
+         * Move entry at `other_pos` of the `other` table into this one, return its new position
+         *
+         * Stored hash and fingerprint are copied and keys are not compared (the entry must not be in this table),
+         * so the entry is never dereferenced. It's used to move entries into the resized table
+         */
+        size_type move_from(group_hash_table & other, const size_type other_pos) noexcept {
+            debug_assert(not other.empty_at(other_pos));
+            // entry leaves the `other` table within its write, so readers never see the emptied one
+            entry_type entry;
+            other.begin_write(other_pos);
+            std::swap(entry, other.m_entries[other_pos]);
+            const stored_hash_type & stored = other.m_hashes[other_pos];
+            const size_type pos = insert_stored(available_pos(stored.hash), stored, entry);
+            other.erase_at(other_pos);
+            other.end_write(other_pos);
+            return pos;
+        }
+
+        /// @copydoc hash_table::remove()
+        void remove(const size_type pos) noexcept {
+            begin_write(pos);
+            erase_at(pos);
+            end_write(pos);
+        }
+
+        /// @copydoc hash_table::clear()
+        void clear() noexcept {
+            for (size_type pos = 0; pos < capacity(); ++pos) {
+                begin_write(pos);
+                m_tags[pos] = group::empty;
+                end_write(pos);
+            }
+            m_size = 0;
+            m_num_deleted = 0;
+        }
+
+        /// @copydoc hash_table::hash_at()
+        hash_type hash_at(const size_type pos) const noexcept {
+            debug_assert(pos < capacity());
+            return m_hashes[pos].hash;
+        }
+
+        /// @copydoc hash_table::entry_at()
+        entry_type & entry_at(const size_type pos) noexcept {
+            debug_assert(pos < capacity());
+            return m_entries[pos];
+        }
+
+        /// @copydoc hash_table::entry_at()
+        const entry_type & entry_at(const size_type pos) const noexcept {
+            debug_assert(pos < capacity());
+            return m_entries[pos];
+        }
+
+        /// @copydoc hash_table::empty_at()
+        bool empty_at(const size_type pos) const noexcept {
+            debug_assert(pos < capacity());
+            return (m_tags[pos] & ~group::tag_mask) != 0;
+        }
+
+        /// @copydoc hash_table::capacity()
+        constexpr size_type capacity() const noexcept { return m_capacity; }
+
+        /// @copydoc hash_table::size()
+        constexpr size_type size() const noexcept { return m_size; }
+
+        /// check whether number of stored and deleted elements equals max_size()
+        constexpr bool threshold_reached() const noexcept { return m_size + m_num_deleted >= max_size(); }
+
+        /// @copydoc hash_table::ok()
+        constexpr bool ok() const noexcept { return m_tags && m_hashes && m_entries; }
+
+        /// @copydoc hash_table::empty()
+        constexpr bool empty() const noexcept { return m_size == 0; }
+
+        /// @copydoc hash_table::max_size()
+        constexpr size_type max_size() const noexcept { return static_cast<size_type>(capacity() * max_load_factor_percent / 100); }
+
+    private:
+        /// place the `entry` with its `stored` hash at the insertion position `pos`
+        size_type insert_stored(const size_type pos, const stored_hash_type & stored, entry_type & entry) noexcept {
+            debug_assert(not threshold_reached());
+            debug_assert(pos < capacity() && empty_at(pos));
+            if (m_tags[pos] == group::deleted) {
+                m_num_deleted -= 1;
+            }
+            begin_write(pos);
+            m_tags[pos] = tag_of(stored.hash);
+            m_hashes[pos] = stored;
+            std::swap(m_entries[pos], entry);
+            end_write(pos);
+            m_size += 1;
+            return pos;
+        }
+
+        /// free the slot `pos`, must be called within the write of its group
+        void erase_at(const size_type pos) noexcept {
+            debug_assert(not empty_at(pos));
+            debug_assert(m_size > 0);
+            m_size -= 1;
+            // lookup never continues past the group with an empty slot,
+            // so slot may be emptied if there is one, otherwise it must stay marked to not break the probe chains
+            const group g(&m_tags[pos & ~(group_size - 1)]);
+            if (g.match_empty() != 0) {
+                m_tags[pos] = group::empty;
+            } else {
+                m_tags[pos] = group::deleted;
+                m_num_deleted += 1;
+            }
+        }
+
+        /// first slot available for insertion on the probe sequence of the `hash`
+        size_type available_pos(const hash_type hash) const noexcept {
+            size_type group_no = desired_group(hash);
+            for (size_type num_probes = 1; num_probes <= m_group_mask + 1; ++num_probes) {
+                const uint32 available = group(&m_tags[group_no * group_size]).match_available();
+                if (available != 0) {
+                    return group_no * group_size + bit::least_significant(available);
+                }
+                group_no = (group_no + num_probes) & m_group_mask;
+            }
+            debug_assert(false); // table is never full
+            return capacity();
+        }
+
+        /// make the group of `pos` odd, so the concurrent readers know it's being modified
+        void begin_write(const size_type pos) noexcept {
+            if (m_versions) {
+                std::atomic<uint32> & version = m_versions[pos / group_size];
+                version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                // the odd version must be visible before the modification
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+        }
+
+        /// publish the modification of the group of `pos`
+        void end_write(const size_type pos) noexcept {
+            if (m_versions) {
+                std::atomic<uint32> & version = m_versions[pos / group_size];
+                version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+        }
+
+        /// return the first group to probe for the given `hash`
+        constexpr size_type desired_group(const hash_type hash) const noexcept { return static_cast<size_type>(hash) & m_group_mask; }
+
+        /// 7 bits of the `hash` scrambled by the multiplicative mixing
+        /// (the least significant bits choose the group and the most significant may choose the cache shard)
+        static constexpr tag_type tag_of(const hash_type hash) noexcept {
+            return static_cast<tag_type>((static_cast<uint64>(hash) * 0x9E3779B97F4A7C15ull) >> 57) & group::tag_mask;
+        }
+
+        /// fingerprint of the `key` stored along with its hash (`0` if table doesn't keep fingerprints)
+        static uint32 fingerprint_of(const key_type & key) noexcept {
+            return fingerprint_of(key, std::integral_constant<bool, Options::key_fingerprints>());
+        }
+
+        static uint32 fingerprint_of(const key_type & key, std::true_type /*key_fingerprints*/) noexcept {
+            return Entry::fingerprint(key);
+        }
+
+        static uint32 fingerprint_of(const key_type &, std::false_type /*key_fingerprints*/) noexcept {
+            return 0;
+        }
+
+    private:
+        size_type m_size;
+        size_type m_num_deleted;
+        const size_type m_capacity;
+        const size_type m_group_mask;
+        tag_array_type m_tags;
+        hash_array_type m_hashes;
+        entry_array_type m_entries;
+        // group versions, `nullptr` unless concurrent reads are enabled
+        version_array_type m_versions;
+        const key_equal eq = KeyEqual();
+    };
+
+} // namespace cachelot
+
+
+#endif // CACHELOT_GROUP_HASH_TABLE_H_INCLUDED
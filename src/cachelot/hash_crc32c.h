@@ -0,0 +1,133 @@
+#ifndef CACHELOT_HASH_CRC32C_H_INCLUDED
+#define CACHELOT_HASH_CRC32C_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+
+#include <cachelot/slice.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  include <nmmintrin.h>
+#  define CACHELOT_HAS_CRC32C_INSTRUCTION 1
+#endif
+
+namespace cachelot {
+
+    namespace internal {
+
+        /// CRC-32C (Castagnoli) polynomial, reversed
+        constexpr uint32 crc32c_polynomial = 0x82F63B78;
+
+        /// table to calculate CRC-32C one byte at a time when there is no CPU support
+        struct crc32c_table {
+            crc32c_table() noexcept {
+                for (uint32 n = 0; n < 256; ++n) {
+                    uint32 crc = n;
+                    for (int bit = 0; bit < 8; ++bit) {
+                        crc = (crc & 1) ? (crc >> 1) ^ crc32c_polynomial : (crc >> 1);
+                    }
+                    entries[n] = crc;
+                }
+            }
+            uint32 entries[256];
+        };
+
+        inline uint32 crc32c_software(uint32 crc, const slice data) noexcept {
+            static const crc32c_table table;
+            for (uint8 one_byte : data) {
+                crc = table.entries[(crc ^ one_byte) & 0xFF] ^ (crc >> 8);
+            }
+            return crc;
+        }
+
+    #if defined(CACHELOT_HAS_CRC32C_INSTRUCTION)
+        /// SSE4.2 `crc32` instruction processes 8 bytes at a time
+        __attribute__((target("sse4.2")))
+        inline uint32 crc32c_hardware(uint32 crc, const slice data) noexcept {
+            const char * pos = data.begin();
+            size_t length = data.length();
+        #if defined(__x86_64__)
+            uint64 crc64 = crc;
+            while (length >= sizeof(uint64)) {
+                uint64 word; std::memcpy(&word, pos, sizeof(word));
+                crc64 = _mm_crc32_u64(crc64, word);
+                pos += sizeof(uint64); length -= sizeof(uint64);
+            }
+            crc = static_cast<uint32>(crc64);
+        #endif
+            while (length >= sizeof(uint32)) {
+                uint32 word; std::memcpy(&word, pos, sizeof(word));
+                crc = _mm_crc32_u32(crc, word);
+                pos += sizeof(uint32); length -= sizeof(uint32);
+            }
+            while (length > 0) {
+                crc = _mm_crc32_u8(crc, static_cast<uint8>(*pos));
+                pos += 1; length -= 1;
+            }
+            return crc;
+        }
+    #endif
+
+    } // namespace internal
+
+
+    /**
+     * Hash function based on CRC-32C checksum
+     *
+     * Uses the SSE4.2 `crc32` instruction if CPU supports it and table-driven calculation otherwise,
+     * both produce the same result.
+     * CRC is linear, so checksum is finalized with the bits mixer from the MurmurHash3
+     * @ingroup common
+     */
+    class crc32c_hasher {
+    public:
+        typedef uint32 hash_type;
+
+        /// @{ constructors
+        crc32c_hasher() = default;
+        crc32c_hasher(const crc32c_hasher &) = default;
+        /// @}
+
+        /// operator() produces hash value
+        hash_type operator()(const slice data) const noexcept {
+            uint32 crc = ~uint32(0);
+        #if defined(CACHELOT_HAS_CRC32C_INSTRUCTION)
+            if (hardware_supported()) {
+                crc = internal::crc32c_hardware(crc, data);
+            } else {
+                crc = internal::crc32c_software(crc, data);
+            }
+        #else
+            crc = internal::crc32c_software(crc, data);
+        #endif
+            return mix(~crc);
+        }
+
+        /// check whether CPU has the `crc32` instruction
+        static bool hardware_supported() noexcept {
+        #if defined(CACHELOT_HAS_CRC32C_INSTRUCTION)
+            static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+            return has_sse42;
+        #else
+            return false;
+        #endif
+        }
+
+    private:
+        static uint32 mix(uint32 h) noexcept {
+            h ^= h >> 16;
+            h *= 0x85ebca6b;
+            h ^= h >> 13;
+            h *= 0xc2b2ae35;
+            h ^= h >> 16;
+            return h;
+        }
+    };
+
+} // namespace cachelot
+
+#endif // CACHELOT_HASH_CRC32C_H_INCLUDED
@@ -0,0 +1,108 @@
+#ifndef CACHELOT_HASH_FUNCTION_H_INCLUDED
+#define CACHELOT_HASH_FUNCTION_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+
+#ifndef CACHELOT_HASH_FNV1A_H_INCLUDED
+#  include <cachelot/hash_fnv1a.h>
+#endif
+#ifndef CACHELOT_HASH_CRC32C_H_INCLUDED
+#  include <cachelot/hash_crc32c.h>
+#endif
+#ifndef CACHELOT_HASH_WYHASH_H_INCLUDED
+#  include <cachelot/hash_wyhash.h>
+#endif
+
+// Hash function used by default, configured by the `CACHELOT_HASH` CMake option
+#if !defined(CACHELOT_DEFAULT_HASH)
+#  define CACHELOT_DEFAULT_HASH wyhash
+#endif
+
+namespace cachelot {
+
+    /// Hash functions available to the cache
+    enum class hash_algorithm : uint8 {
+        fnv1a,      ///< byte-at-a-time FNV-1a
+        crc32c,     ///< CRC-32C (hardware accelerated when CPU supports SSE4.2)
+        wyhash      ///< 64-bit-at-a-time wyhash
+    };
+
+    /// human readable name of the hash `algorithm`
+    inline const char * hash_algorithm_name(const hash_algorithm algorithm) noexcept {
+        switch (algorithm) {
+        case hash_algorithm::fnv1a: return "fnv1a";
+        case hash_algorithm::crc32c: return "crc32c";
+        case hash_algorithm::wyhash: return "wyhash";
+        }
+        return "unknown";
+    }
+
+    /// find the hash algorithm by its `name`
+    /// @return `false` if there is no such algorithm
+    inline bool hash_algorithm_from_name(const slice name, hash_algorithm & algorithm) noexcept {
+        for (auto candidate : { hash_algorithm::fnv1a, hash_algorithm::crc32c, hash_algorithm::wyhash }) {
+            if (name == slice(hash_algorithm_name(candidate), std::strlen(hash_algorithm_name(candidate)))) {
+                algorithm = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    /**
+     * Hash function which algorithm is chosen at the program startup
+     *
+     * Default algorithm is set at compile time with the `CACHELOT_DEFAULT_HASH` definition.
+     * Hash values of different algorithms differ, so the algorithm must be chosen by select()
+     * before any hash value is calculated and stored (i.e. before the first cache is created)
+     * and must not change afterwards
+     *
+     * @tparam HashType - unsigned integral type of a hash (`uint32` or `uint64`)
+     * @ingroup common
+     */
+    template <typename HashType>
+    class selectable_hasher {
+    public:
+        typedef HashType hash_type;
+
+        /// @{ constructors
+        selectable_hasher() = default;
+        selectable_hasher(const selectable_hasher &) = default;
+        /// @}
+
+        /// operator() produces hash value
+        hash_type operator()(const slice data) const noexcept {
+            switch (current()) {
+            case hash_algorithm::crc32c:
+                return static_cast<hash_type>(crc32c_hasher()(data));
+            case hash_algorithm::wyhash:
+                return typename wyhash<hash_type>::hasher()(data);
+            case hash_algorithm::fnv1a:
+            default:
+                return typename fnv1a<hash_type>::hasher()(data);
+            }
+        }
+
+        /// choose hash algorithm (not thread safe, must be called before the first hash calculation)
+        static void select(const hash_algorithm algorithm) noexcept { current() = algorithm; }
+
+        /// currently used hash algorithm
+        static hash_algorithm selected() noexcept { return current(); }
+
+    private:
+        static hash_algorithm & current() noexcept {
+            static hash_algorithm algorithm = hash_algorithm::CACHELOT_DEFAULT_HASH;
+            return algorithm;
+        }
+    };
+
+
+} // namespace cachelot
+
+#endif // CACHELOT_HASH_FUNCTION_H_INCLUDED
@@ -49,6 +49,8 @@ namespace cachelot {
             typedef size_t size_type;
             typedef size_t hash_type;
             static constexpr size_type max_load_factor_percent = 93;
+            static constexpr bool group_probing = false;
+            static constexpr bool key_fingerprints = false;
         };
 
     } // namespace internal
@@ -186,6 +188,27 @@ namespace cachelot {
             return tuple<bool, size_type>(false, pos);
         }
 
+        /// hint CPU to load slots where entry with the given `hash` is expected to be
+        void prefetch(const hash_type hash) const noexcept {
+            const size_type pos = desired_position(hash);
+            prefetch_read(&m_hashes[pos]);
+            prefetch_read(&m_entries[pos]);
+        }
+
+        /// return the first entry with the given `hash` without comparing keys (if any), or nullptr
+        const entry_type * entry_with_hash(const hash_type hash) const noexcept {
+            size_type pos = desired_position(hash);
+            size_type distance = 0;
+            while (not empty_at(pos) && distance <= get_distance(pos, hash_at(pos))) {
+                if (hash_at(pos) == hash) {
+                    return &entry_at(pos);
+                }
+                pos = inc_pos(pos);
+                distance += 1;
+            }
+            return nullptr;
+        }
+
         /// insert entry starting from given pos that was returned by @ref hash_table::entry_for
         size_type insert(size_type pos, const key_type key, hash_type hash, mapped_type value) noexcept {
             debug_assert(not threshold_reached()); debug_assert(hash != 0);
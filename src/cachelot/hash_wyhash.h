@@ -0,0 +1,130 @@
+#ifndef CACHELOT_HASH_WYHASH_H_INCLUDED
+#define CACHELOT_HASH_WYHASH_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+
+#include <cachelot/slice.h>
+
+namespace cachelot {
+
+    namespace internal {
+
+        // default secret of the wyhash (final version 4)
+        constexpr uint64 wyhash_secret[4] = { 0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull };
+
+        /// 64x64 -> 128 bit multiplication, `a` receives low and `b` high half of the result
+        inline void wyhash_mum(uint64 & a, uint64 & b) noexcept {
+        #if defined(__SIZEOF_INT128__)
+            __uint128_t r = a;
+            r *= b;
+            a = static_cast<uint64>(r);
+            b = static_cast<uint64>(r >> 64);
+        #else
+            const uint64 ha = a >> 32, hb = b >> 32, la = static_cast<uint32>(a), lb = static_cast<uint32>(b);
+            const uint64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32);
+            uint64 c = t < rl;
+            const uint64 lo = t + (rm1 << 32);
+            c += lo < t;
+            const uint64 hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+            a = lo;
+            b = hi;
+        #endif
+        }
+
+        inline uint64 wyhash_mix(uint64 a, uint64 b) noexcept {
+            wyhash_mum(a, b);
+            return a ^ b;
+        }
+
+        inline uint64 wyhash_read8(const char * p) noexcept { uint64 v; std::memcpy(&v, p, sizeof(v)); return v; }
+        inline uint64 wyhash_read4(const char * p) noexcept { uint32 v; std::memcpy(&v, p, sizeof(v)); return v; }
+        inline uint64 wyhash_read3(const char * p, const size_t k) noexcept {
+            return (static_cast<uint64>(static_cast<uint8>(p[0])) << 16) | (static_cast<uint64>(static_cast<uint8>(p[k >> 1])) << 8) | static_cast<uint8>(p[k - 1]);
+        }
+
+        /// wyhash final version 4 (little-endian)
+        inline uint64 wyhash64(const slice data, uint64 seed) noexcept {
+            const uint64 * secret = wyhash_secret;
+            const char * p = data.begin();
+            const size_t len = data.length();
+            seed ^= wyhash_mix(seed ^ secret[0], secret[1]);
+            uint64 a, b;
+            if (len <= 16) {
+                if (len >= 4) {
+                    a = (wyhash_read4(p) << 32) | wyhash_read4(p + ((len >> 3) << 2));
+                    b = (wyhash_read4(p + len - 4) << 32) | wyhash_read4(p + len - 4 - ((len >> 3) << 2));
+                } else if (len > 0) {
+                    a = wyhash_read3(p, len);
+                    b = 0;
+                } else {
+                    a = b = 0;
+                }
+            } else {
+                size_t i = len;
+                if (i > 48) {
+                    uint64 see1 = seed, see2 = seed;
+                    do {
+                        seed = wyhash_mix(wyhash_read8(p) ^ secret[1], wyhash_read8(p + 8) ^ seed);
+                        see1 = wyhash_mix(wyhash_read8(p + 16) ^ secret[2], wyhash_read8(p + 24) ^ see1);
+                        see2 = wyhash_mix(wyhash_read8(p + 32) ^ secret[3], wyhash_read8(p + 40) ^ see2);
+                        p += 48; i -= 48;
+                    } while (i > 48);
+                    seed ^= see1 ^ see2;
+                }
+                while (i > 16) {
+                    seed = wyhash_mix(wyhash_read8(p) ^ secret[1], wyhash_read8(p + 8) ^ seed);
+                    i -= 16; p += 16;
+                }
+                a = wyhash_read8(p + i - 16);
+                b = wyhash_read8(p + i - 8);
+            }
+            a ^= secret[1];
+            b ^= seed;
+            wyhash_mum(a, b);
+            return wyhash_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+        }
+
+        template <typename HashType>
+        class wyhash_hasher {
+        public:
+            typedef HashType hash_type;
+
+            /// @{ constructors
+            wyhash_hasher() = default;
+            wyhash_hasher(const wyhash_hasher &) = default;
+            /// @}
+
+            /// operator() produces hash value
+            hash_type operator()(const slice data) const noexcept {
+                const uint64 h = wyhash64(data, 0);
+                // fold 64 bits to fit the hash type
+                return static_cast<hash_type>(sizeof(hash_type) < sizeof(uint64) ? h ^ (h >> 32) : h);
+            }
+        };
+    }
+
+    /**
+     * [wyhash](https://github.com/wangyi-fudan/wyhash) hash function, it processes 8 bytes at a time
+     *
+     * @tparam HashType - unsigned integral type of a hash (`uint32` or `uint64`)
+     * @par Example
+     * @code
+     * typedef wyhash<uint32>::hasher hasher_type;
+     * auto hash_function = hasher_type();
+     * uint32 hash = hash_function(some_data);
+     * @endcode
+     * @ingroup common
+     */
+    template <typename HashType,
+              class = typename std::enable_if<std::is_unsigned<HashType>::value>::type>
+    struct wyhash { typedef internal::wyhash_hasher<HashType> hasher; };
+
+
+} // namespace cachelot
+
+#endif // CACHELOT_HASH_WYHASH_H_INCLUDED
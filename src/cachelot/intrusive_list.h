@@ -111,6 +111,13 @@ namespace cachelot {
             return &item->link == dummy_link.prev;
         }
 
+        /// return item preceding `item` (closer to the head), `nullptr` if `item` is the head
+        pointer previous(pointer item) noexcept {
+            debug_assert(is_linked(item));
+            node_type * prev_link = (item->*LinkPonter).prev;
+            return prev_link != &dummy_link ? pointer_from_link(prev_link) : nullptr;
+        }
+
         /// move `item` to front
         void move_front(pointer item) noexcept {
             debug_assert(has(item));
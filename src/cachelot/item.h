@@ -17,6 +17,9 @@
 #ifndef CACHELOT_EXPIRATION_CLOCK_H_INCLUDED
 #  include <cachelot/expiration_clock.h> // expiration time
 #endif
+#ifndef CACHELOT_LZ4_H_INCLUDED
+#  include <cachelot/lz4.h> // value compression
+#endif
 
 
 namespace cachelot {
@@ -28,15 +31,21 @@ namespace cachelot {
          *
          * For the sake of memory economy, Item has tricky placement in memory
          * @code
-         * +---------+-------------------------+-------------------------------------?-------+----------?
-         * |  Item   |  key as a sequence      |  value as a sequence                |[align]|[optional]|
-         * |  struct |  of a[key_length] bytes |  of a [value_length] bytes          |[bytes]|[ CAS_val]|
-         * +---------+-------------------------+-------------------------------------?-------+----------?
+         * +--------+----------?------------?---------?--------------+--------------+----------------+
+         * |  Item  |[optional]|[ optional ]|[optional]| value_length |  key         |  value         |
+         * | struct |[ CAS_val]|[expiration]|[ flags  ]|  1..4 bytes  |  key_length  |  value_length  |
+         * +--------+----------?------------?---------?--------------+--------------+----------------+
          * @endcode
-         * Item structure is placed first after it
-         * the key is placed, it's `key_length` bytes long then
-         * item flags as ASCII string (the most of the time it will be '0')
-         * the value slice sequence
+         * Item structure holds only the hash, the key length and the bit set of fields present in the header.
+         * Optional fields follow it: CAS timestamp is stored unless the Item was created without it (CAS is disabled),
+         * expiration time is omitted for items that never expire and user flags are omitted when zero.
+         * Value length is stored in as few bytes as needed, then the key and the value sequences follow.
+         * Header fields are not aligned, so tiny items don't waste memory for the padding.
+         * Value may be stored compressed (see compress_value()), then it's the uncompressed length (4 bytes) followed by the LZ4 block.
+         *
+         * Value which doesn't fit the single memory page is stored in the chain of Chunks (see is_chained()),
+         * Item itself keeps the total value length and the pointer to the first Chunk in place of the value then.
+         * Every Chunk refers back to its Item, so eviction of any part of the chain can remove the whole Item.
          * @ingroup cache
          */
         class Item {
@@ -51,14 +60,21 @@ namespace cachelot {
             static constexpr uint8 max_key_length = 250; // ! key size is limited to uint8
             static constexpr uint32 max_value_length = std::numeric_limits<uint32>::max();
             static const seconds infinite_TTL;
+            class Chunk;
         private:
+            // bits of the `m_format`
+            static constexpr uint8 has_timestamp_bit = 1 << 0;
+            static constexpr uint8 has_expiration_bit = 1 << 1;
+            static constexpr uint8 has_flags_bit = 1 << 2;
+            static constexpr uint8 value_length_bytes_shift = 3; // 2 bits: number of value length bytes - 1
+            static constexpr uint8 value_length_bytes_mask = 3;
+            static constexpr uint8 is_compressed_bit = 1 << 5;
+            static constexpr uint8 is_chained_bit = 1 << 6;
+
             // Important! declaration order affects item size
-            const timestamp_type m_timestamp; // timestamp of this item
-            const hash_type m_hash; // hash value
-            uint32 m_value_length; // length of value [0..MAX_VALUE_LENGTH]
-            expiration_time_point m_expiration_time; // when it expires
-            opaque_flags_type m_opaque_flags; // user defined item flags
+            uint8 m_hash[sizeof(hash_type)]; // hash value (as bytes to keep Item unaligned)
             const uint8 m_key_length; // length of key [1..MAX_KEY_LENGTH]
+            uint8 m_format; // which optional fields are present, the size of value length and how value is stored
 
         private:
             /// private destructor
@@ -70,8 +86,15 @@ namespace cachelot {
             Item(Item &&) = delete;
             Item & operator= (Item &&) = delete;
         public:
-            /// constructor
-            explicit Item(slice the_key, hash_type the_hash, uint32 value_length, opaque_flags_type the_flags, seconds the_ttl, timestamp_type the_timestamp) noexcept;
+            /**
+             * constructor
+             *
+             * @param mutable_ttl - reserve expiration time even for the `infinite_TTL`, so set_ttl() can make it finite later
+             */
+            explicit Item(slice the_key, hash_type the_hash, uint32 value_length, opaque_flags_type the_flags, seconds the_ttl, timestamp_type the_timestamp, bool mutable_ttl = false) noexcept;
+
+            /// constructor of the Item without CAS timestamp
+            explicit Item(slice the_key, hash_type the_hash, uint32 value_length, opaque_flags_type the_flags, seconds the_ttl, bool mutable_ttl = false) noexcept;
 
             /// Destroy existing Item
             static void Destroy(Item * item) noexcept;
@@ -80,60 +103,241 @@ namespace cachelot {
             slice key() const noexcept;
 
             /// return hash value
-            hash_type hash() const noexcept { return m_hash; }
+            hash_type hash() const noexcept { return load<hash_type>(m_hash); }
 
             /// return slice sequence occupied by value
+            /// @note value of the chained Item isn't contiguous, see foreach_value_piece()
             slice value() const noexcept;
 
+            /// call `on_piece(slice)` for every consecutive piece of the value (there is only one unless Item is chained)
+            template <typename Callback>
+            void foreach_value_piece(Callback on_piece) const;
+
             /// assign value to the item
+            /// @note value of the chained Item can't be shrinked, `the_value` must be of the exact length
             void assign_value(slice the_value) noexcept;
 
             /// assign value from the two parts
             void assign_compose(slice left, slice right) noexcept;
 
+            /// writable memory of the value to fill it in place (e.g. receive it directly from the network)
+            /// @note not applicable to the chained Item
+            char * value_buffer() noexcept;
+
+            /// shrink value filled in place to its first `length` bytes
+            void truncate_value(uint32 length) noexcept;
+
+            /// check whether value is stored compressed, value() returns compressed data then
+            bool is_compressed() const noexcept { return (m_format & is_compressed_bit) != 0; }
+
+            /// length of the value as it was assigned (before compression)
+            uint32 uncompressed_length() const noexcept;
+
+            /// write uncompressed value to the `dest` of uncompressed_length() bytes (pieces of the chained value are gathered)
+            void uncompress_value(char * dest) const noexcept;
+
+            /// assign the value compressed by CompressValue() or taken from another compressed Item
+            void assign_compressed_value(slice compressed) noexcept;
+
+            /// check whether value is stored in the chain of Chunks
+            bool is_chained() const noexcept { return (m_format & is_chained_bit) != 0; }
+
+            /// first Chunk of the chained value
+            Chunk * first_chunk() const noexcept;
+
+            /// make Item chained, its value is stored in the `first` Chunk and the following ones
+            /// Item must be created with the size given by the CalcHeadSizeRequired()
+            void attach_chunks(Chunk * first) noexcept;
+
+            /// total number of bytes occupied by the Item (not including Chunks of the chained value)
+            size_t size() const noexcept { return ValueOffset(this) + (is_chained() ? sizeof(Chunk *) : value_length()); }
+
             /// user defined flags
-            opaque_flags_type opaque_flags() const noexcept { return m_opaque_flags; }
+            opaque_flags_type opaque_flags() const noexcept;
 
-            /// re-assign user defined flags
-            void set_opaque_flags(opaque_flags_type f) noexcept { m_opaque_flags = f; }
+            /// retrieve timestamp of this item, `0` if it was created without timestamp
+            timestamp_type timestamp() const noexcept;
 
-            /// retrieve timestamp of this item
-            timestamp_type timestamp() const noexcept { return m_timestamp; }
+            /// check whether Item has the CAS timestamp
+            bool has_timestamp() const noexcept { return (m_format & has_timestamp_bit) != 0; }
 
             /// retrieve expiration time of this item
-            expiration_time_point expiration_time() const noexcept { return m_expiration_time; }
+            expiration_time_point expiration_time() const noexcept;
 
             /// retrive number of seconds until expiration
             seconds ttl() const noexcept;
 
             /// set new time to live
-            void set_ttl(seconds secs) noexcept;
+            /// @return `false` if Item has no room for the expiration time (it was created with `infinite_TTL`)
+            bool set_ttl(seconds secs) noexcept;
 
             /// check whether Item is expired
-            bool is_expired() const noexcept { return m_expiration_time <= clock::now(); }
+            bool is_expired() const noexcept { return (m_format & has_expiration_bit) != 0 && expiration_time() <= clock::now(); }
+
+            /// Compress the `value` into `dest`, return length of the compressed value or `0` if it doesn't fit `dest_capacity`
+            static size_t CompressValue(const slice value, char * dest, const size_t dest_capacity) noexcept;
 
             /// Calculate total size in slice required to store provided fields
-            static size_t CalcSizeRequired(const slice the_key, const size_t value_length) noexcept;
+            static size_t CalcSizeRequired(const slice the_key, const size_t value_length, const opaque_flags_type the_flags, const seconds the_ttl,
+                                           const bool with_timestamp = true, const bool mutable_ttl = false) noexcept;
+
+            /// Calculate size required to store the Item which value is stored in the chain of Chunks
+            static size_t CalcHeadSizeRequired(const slice the_key, const size_t value_length, const opaque_flags_type the_flags, const seconds the_ttl,
+                                               const bool with_timestamp = true, const bool mutable_ttl = false) noexcept;
+
+            /// check whether `memory` allocated for the Item or the Chunk holds the Chunk
+            static bool IsChunk(const void * memory) noexcept;
 
         private:
+            /// build `m_format` out of the fields to store
+            static uint8 Format(const size_t value_length, const opaque_flags_type the_flags, const seconds the_ttl, const bool with_timestamp, const bool mutable_ttl) noexcept;
+            /// number of bytes to store the `value_length`
+            static uint8 ValueLengthBytes(const size_t value_length) noexcept;
+            /// size of the header described by the `format` (including Item struct)
+            static size_t HeaderSize(const uint8 format) noexcept;
+            /// copy `data` into the value starting from the `offset`
+            void write_value(size_t offset, slice data) noexcept;
+
+            // unaligned access to the header fields
+            template <typename T> static T load(const uint8 * at) noexcept { T v; std::memcpy(&v, at, sizeof(T)); return v; }
+            template <typename T> static void store(uint8 * at, const T v) noexcept { std::memcpy(at, &v, sizeof(T)); }
+
+            uint8 * bytes() noexcept { return reinterpret_cast<uint8 *>(this); }
+            const uint8 * bytes() const noexcept { return reinterpret_cast<const uint8 *>(this); }
+
             // Item must be properly initialized to call following functions
+            size_t expiration_offset() const noexcept { return sizeof(Item) + (has_timestamp() ? sizeof(timestamp_type) : 0); }
+            size_t flags_offset() const noexcept { return expiration_offset() + ((m_format & has_expiration_bit) ? sizeof(expiration_time_point) : 0); }
+            size_t value_length_offset() const noexcept { return flags_offset() + ((m_format & has_flags_bit) ? sizeof(opaque_flags_type) : 0); }
+            uint8 value_length_bytes() const noexcept { return static_cast<uint8>(((m_format >> value_length_bytes_shift) & value_length_bytes_mask) + 1); }
+            uint32 value_length() const noexcept;
+            void set_value_length(uint32 length) noexcept;
             static size_t KeyOffset(const Item * i) noexcept;
             static size_t ValueOffset(const Item * i) noexcept;
         };
 
+        static_assert(sizeof(Item) == sizeof(Item::hash_type) + 2, "Item header must not be padded");
+
+
+        /**
+         * Piece of the value of the chained Item
+         *
+         * Chunk starts with the hash of its Item followed by zero byte at the place of the Item key length (which is never zero),
+         * so the allocated memory could be told apart (see Item::IsChunk()) and the eviction admission treats Chunk as a part of the Item.
+         * @ingroup cache
+         */
+        class Item::Chunk {
+            hash_type m_hash; // hash of the owner Item
+            const uint8 m_marker; // zero
+            uint32 m_length; // length of the data
+            Item * m_owner;
+            Chunk * m_next;
+        public:
+            /// constructor
+            explicit Chunk(Item * the_owner, uint32 the_length) noexcept
+                : m_hash(the_owner->hash())
+                , m_marker(0)
+                , m_length(the_length)
+                , m_owner(the_owner)
+                , m_next(nullptr) {
+            }
+
+            /// Item which value the Chunk holds
+            Item * owner() const noexcept { return m_owner; }
+
+            /// next Chunk of the value, `nullptr` for the last one
+            Chunk * next() const noexcept { return m_next; }
+
+            /// link the `next` Chunk
+            void set_next(Chunk * the_next) noexcept { m_next = the_next; }
+
+            /// the piece of value
+            slice data() const noexcept { return slice(reinterpret_cast<const char *>(this + 1), m_length); }
+
+            /// writable memory of the piece of value
+            char * buffer() noexcept { return reinterpret_cast<char *>(this + 1); }
+
+            /// Calculate size required to store `length` bytes of the value
+            static size_t CalcSizeRequired(const size_t length) noexcept { return sizeof(Chunk) + length; }
+
+            friend class Item;
+        };
+
 
-        inline Item::Item(slice the_key, hash_type the_hash, uint32 value_length, opaque_flags_type the_flags, seconds the_ttl, timestamp_type the_timestamp) noexcept
-                : m_timestamp(the_timestamp)
-                , m_hash(the_hash)
-                , m_value_length(value_length)
-                , m_opaque_flags(the_flags)
-                , m_key_length(the_key.length()) {
+        inline Item::Item(slice the_key, hash_type the_hash, uint32 value_length, opaque_flags_type the_flags, seconds the_ttl, timestamp_type the_timestamp, bool mutable_ttl) noexcept
+                : m_key_length(the_key.length())
+                , m_format(Format(value_length, the_flags, the_ttl, true, mutable_ttl)) {
+            debug_assert(the_key.length() <= max_key_length);
+            debug_assert(value_length <= max_value_length);
+            store<hash_type>(m_hash, the_hash);
+            store<timestamp_type>(bytes() + sizeof(Item), the_timestamp);
             set_ttl(the_ttl);
-            debug_assert(unaligned_bytes(this, alignof(Item) == 0));
+            if (m_format & has_flags_bit) {
+                store<opaque_flags_type>(bytes() + flags_offset(), the_flags);
+            }
+            set_value_length(value_length);
+            std::memcpy(bytes() + KeyOffset(this), the_key.begin(), the_key.length());
+        }
+
+
+        inline Item::Item(slice the_key, hash_type the_hash, uint32 value_length, opaque_flags_type the_flags, seconds the_ttl, bool mutable_ttl) noexcept
+                : m_key_length(the_key.length())
+                , m_format(Format(value_length, the_flags, the_ttl, false, mutable_ttl)) {
             debug_assert(the_key.length() <= max_key_length);
             debug_assert(value_length <= max_value_length);
-            auto this_ = reinterpret_cast<uint8 *>(this);
-            std::memcpy(this_ + KeyOffset(this), the_key.begin(), the_key.length());
+            store<hash_type>(m_hash, the_hash);
+            set_ttl(the_ttl);
+            if (m_format & has_flags_bit) {
+                store<opaque_flags_type>(bytes() + flags_offset(), the_flags);
+            }
+            set_value_length(value_length);
+            std::memcpy(bytes() + KeyOffset(this), the_key.begin(), the_key.length());
+        }
+
+
+        inline Item::timestamp_type Item::timestamp() const noexcept {
+            if (not has_timestamp()) {
+                return 0;
+            }
+            return load<timestamp_type>(bytes() + sizeof(Item));
+        }
+
+
+        inline Item::opaque_flags_type Item::opaque_flags() const noexcept {
+            if (not (m_format & has_flags_bit)) {
+                return 0;
+            }
+            return load<opaque_flags_type>(bytes() + flags_offset());
+        }
+
+
+        inline Item::expiration_time_point Item::expiration_time() const noexcept {
+            if (not (m_format & has_expiration_bit)) {
+                return expiration_time_point::max();
+            }
+            return load<expiration_time_point>(bytes() + expiration_offset());
+        }
+
+
+        inline uint32 Item::value_length() const noexcept {
+            // little-endian number of `value_length_bytes()` bytes
+            const uint8 * at = bytes() + value_length_offset();
+            uint32 length = 0;
+            for (uint8 n = value_length_bytes(); n > 0; --n) {
+                length = (length << 8) | at[n - 1];
+            }
+            return length;
+        }
+
+
+        inline void Item::set_value_length(uint32 length) noexcept {
+            // width is fixed at construction, value may only shrink
+            debug_assert(ValueLengthBytes(length) <= value_length_bytes());
+            uint8 * at = bytes() + value_length_offset();
+            for (uint8 n = 0; n < value_length_bytes(); ++n) {
+                at[n] = static_cast<uint8>(length & 0xFF);
+                length >>= 8;
+            }
         }
 
 
@@ -146,50 +350,189 @@ namespace cachelot {
 
 
         inline slice Item::value() const noexcept {
+            debug_assert(not is_chained());
             auto value_begin = reinterpret_cast<const char *>(this) + ValueOffset(this);
-            slice v(value_begin, value_begin + m_value_length);
+            slice v(value_begin, value_begin + value_length());
             return v;
         }
 
 
+        template <typename Callback>
+        inline void Item::foreach_value_piece(Callback on_piece) const {
+            if (not is_chained()) {
+                on_piece(value());
+                return;
+            }
+            for (auto chunk = first_chunk(); chunk != nullptr; chunk = chunk->next()) {
+                on_piece(chunk->data());
+            }
+        }
+
+
+        inline void Item::write_value(size_t offset, slice data) noexcept {
+            if (not is_chained()) {
+                std::memcpy(bytes() + ValueOffset(this) + offset, data.begin(), data.length());
+                return;
+            }
+            for (auto chunk = first_chunk(); chunk != nullptr && not data.empty(); chunk = chunk->next()) {
+                if (offset >= chunk->m_length) {
+                    offset -= chunk->m_length;
+                    continue;
+                }
+                const size_t piece_length = std::min<size_t>(chunk->m_length - offset, data.length());
+                std::memcpy(chunk->buffer() + offset, data.begin(), piece_length);
+                data = slice(data.begin() + piece_length, data.end());
+                offset = 0;
+            }
+            debug_assert(data.empty());
+        }
+
+
         inline void Item::assign_value(slice the_value) noexcept {
-            debug_assert(the_value.length() <= m_value_length);
-            auto this_ = reinterpret_cast<uint8 *>(this);
-            std::memcpy(this_ + ValueOffset(this), the_value.begin(), the_value.length());
-            m_value_length = static_cast<decltype(m_value_length)>(the_value.length());
+            debug_assert(the_value.length() <= value_length());
+            debug_assert(not is_chained() || the_value.length() == value_length());
+            write_value(0, the_value);
+            set_value_length(static_cast<uint32>(the_value.length()));
         }
 
 
         inline void Item::assign_compose(slice left, slice right) noexcept {
-            debug_assert(left.length() + right.length() <= m_value_length);
-            auto this_ = reinterpret_cast<uint8 *>(this);
-            std::memcpy(this_ + ValueOffset(this), left.begin(), left.length());
-            std::memcpy(this_ + ValueOffset(this) + left.length(), right.begin(), right.length());
-            m_value_length = static_cast<decltype(m_value_length)>(left.length() + right.length());
+            debug_assert(left.length() + right.length() <= value_length());
+            debug_assert(not is_chained() || left.length() + right.length() == value_length());
+            write_value(0, left);
+            write_value(left.length(), right);
+            set_value_length(static_cast<uint32>(left.length() + right.length()));
+        }
+
+
+
+        inline char * Item::value_buffer() noexcept {
+            debug_assert(not is_chained());
+            return reinterpret_cast<char *>(this) + ValueOffset(this);
+        }
+
+
+        inline Item::Chunk * Item::first_chunk() const noexcept {
+            debug_assert(is_chained());
+            return load<Chunk *>(bytes() + ValueOffset(this));
+        }
+
+
+        inline void Item::attach_chunks(Chunk * first) noexcept {
+            debug_assert(not is_compressed());
+            store<Chunk *>(bytes() + ValueOffset(this), first);
+            m_format |= is_chained_bit;
+        }
+
+
+        inline void Item::truncate_value(uint32 length) noexcept {
+            debug_assert(length <= value_length());
+            set_value_length(length);
+        }
+
+
+        inline uint32 Item::uncompressed_length() const noexcept {
+            if (not is_compressed()) {
+                return value_length();
+            }
+            return load<uint32>(bytes() + ValueOffset(this));
+        }
+
+
+        inline size_t Item::CompressValue(const slice value, char * dest, const size_t dest_capacity) noexcept {
+            debug_assert(value.length() <= max_value_length);
+            if (dest_capacity <= sizeof(uint32)) {
+                return 0;
+            }
+            const size_t compressed_length = lz4::compress(value.begin(), value.length(), dest + sizeof(uint32), dest_capacity - sizeof(uint32));
+            if (compressed_length == 0) {
+                return 0;
+            }
+            store<uint32>(reinterpret_cast<uint8 *>(dest), static_cast<uint32>(value.length()));
+            return compressed_length + sizeof(uint32);
+        }
+
+
+        inline void Item::uncompress_value(char * dest) const noexcept {
+            if (not is_compressed()) {
+                foreach_value_piece([&dest](const slice piece) noexcept {
+                    std::memcpy(dest, piece.begin(), piece.length());
+                    dest += piece.length();
+                });
+                return;
+            }
+            auto compressed = value();
+            debug_only(const bool ok = ) lz4::decompress(compressed.begin() + sizeof(uint32), compressed.length() - sizeof(uint32), dest, uncompressed_length());
+            debug_assert(ok);
         }
 
 
+        inline void Item::assign_compressed_value(slice compressed) noexcept {
+            debug_assert(not is_chained());
+            debug_assert(compressed.length() > sizeof(uint32));
+            assign_value(compressed);
+            m_format |= is_compressed_bit;
+        }
+
 
         inline seconds Item::ttl() const noexcept {
-            if (m_expiration_time == expiration_time_point::max()) {
+            const auto expiration = expiration_time();
+            if (expiration == expiration_time_point::max()) {
                 return infinite_TTL;
             } else {
-                return std::chrono::duration_cast<seconds>(m_expiration_time - clock::now());
+                return std::chrono::duration_cast<seconds>(expiration - clock::now());
             }
         }
 
 
-        inline void Item::set_ttl(seconds s) noexcept {
+        inline bool Item::set_ttl(seconds s) noexcept {
+            if (not (m_format & has_expiration_bit)) {
+                return s == infinite_TTL;
+            }
             if (s == infinite_TTL) {
-                m_expiration_time = expiration_time_point::max();
+                store<expiration_time_point>(bytes() + expiration_offset(), expiration_time_point::max());
+            } else {
+                store<expiration_time_point>(bytes() + expiration_offset(), clock::now() + s);
+            }
+            return true;
+        }
+
+
+        inline uint8 Item::ValueLengthBytes(const size_t value_length) noexcept {
+            debug_assert(value_length <= max_value_length);
+            if (value_length <= 0xFF) {
+                return 1;
+            } else if (value_length <= 0xFFFF) {
+                return 2;
+            } else if (value_length <= 0xFFFFFF) {
+                return 3;
             } else {
-                m_expiration_time = clock::now() + s;
+                return 4;
             }
         }
 
 
-        inline size_t Item::KeyOffset(const Item *) noexcept {
-            return sizeof(Item);
+        inline uint8 Item::Format(const size_t value_length, const opaque_flags_type the_flags, const seconds the_ttl, const bool with_timestamp, const bool mutable_ttl) noexcept {
+            uint8 format = static_cast<uint8>((ValueLengthBytes(value_length) - 1) << value_length_bytes_shift);
+            format |= with_timestamp ? has_timestamp_bit : 0;
+            format |= (the_ttl != infinite_TTL || mutable_ttl) ? has_expiration_bit : 0;
+            format |= the_flags != 0 ? has_flags_bit : 0;
+            return format;
+        }
+
+
+        inline size_t Item::HeaderSize(const uint8 format) noexcept {
+            size_t header_size = sizeof(Item);
+            header_size += (format & has_timestamp_bit) ? sizeof(timestamp_type) : 0;
+            header_size += (format & has_expiration_bit) ? sizeof(expiration_time_point) : 0;
+            header_size += (format & has_flags_bit) ? sizeof(opaque_flags_type) : 0;
+            header_size += ((format >> value_length_bytes_shift) & value_length_bytes_mask) + 1;
+            return header_size;
+        }
+
+
+        inline size_t Item::KeyOffset(const Item * i) noexcept {
+            return HeaderSize(i->m_format);
         }
 
 
@@ -199,16 +542,34 @@ namespace cachelot {
         }
 
 
-        inline size_t Item::CalcSizeRequired(const slice the_key, const size_t value_length) noexcept {
+        inline size_t Item::CalcSizeRequired(const slice the_key, const size_t value_length, const opaque_flags_type the_flags, const seconds the_ttl, const bool with_timestamp, const bool mutable_ttl) noexcept {
             debug_assert(the_key.length() > 0);
             debug_assert(the_key.length() <= max_key_length);
             debug_assert(value_length <= std::numeric_limits<uint32>::max());
-            size_t item_size = sizeof(Item);
+            size_t item_size = HeaderSize(Format(value_length, the_flags, the_ttl, with_timestamp, mutable_ttl));
             item_size += the_key.length();
             item_size += value_length;
             return item_size;
         }
 
+
+        inline size_t Item::CalcHeadSizeRequired(const slice the_key, const size_t value_length, const opaque_flags_type the_flags, const seconds the_ttl, const bool with_timestamp, const bool mutable_ttl) noexcept {
+            debug_assert(the_key.length() > 0);
+            debug_assert(the_key.length() <= max_key_length);
+            debug_assert(value_length <= std::numeric_limits<uint32>::max());
+            size_t item_size = HeaderSize(Format(value_length, the_flags, the_ttl, with_timestamp, mutable_ttl));
+            item_size += the_key.length();
+            item_size += sizeof(Chunk *);
+            return item_size;
+        }
+
+
+        inline bool Item::IsChunk(const void * memory) noexcept {
+            // Chunk has zero at the place of the key length
+            static_assert(offsetof(Chunk, m_marker) == offsetof(Item, m_key_length), "Chunk marker must overlap the Item key length");
+            return reinterpret_cast<const uint8 *>(memory)[sizeof(hash_type)] == 0;
+        }
+
     } // namepsace cache
 
 } // namespace cachelot
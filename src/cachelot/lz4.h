@@ -0,0 +1,212 @@
+#ifndef CACHELOT_LZ4_H_INCLUDED
+#define CACHELOT_LZ4_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+#ifndef CACHELOT_COMMON_H_INCLUDED
+#  include <cachelot/common.h>
+#endif
+
+#include <cstring> // memcpy
+
+namespace cachelot {
+
+    /**
+     * Fast compression in the LZ4 block format
+     *
+     * Compressed block is a sequence of `[token][literals length][literals][match offset][match length]`,
+     * the last sequence has literals only. Matches are found by the single-entry hash table of 4-byte sequences (greedy parsing),
+     * that is a speed / ratio trade-off of the reference `LZ4_compress_fast()`.
+     * Output is compatible with the reference LZ4 decoder and vice versa.
+     * @ingroup common
+     */
+    namespace lz4 {
+
+        namespace internal {
+            constexpr size_t min_match = 4;
+            constexpr size_t last_literals = 5;  // last bytes of the block are always literals
+            constexpr size_t match_find_limit = 12;  // last match must start at least this far from the end
+            constexpr size_t max_offset = 65535;
+            constexpr unsigned hash_log = 12;
+            constexpr uint8 run_mask = 15;
+
+            inline uint32 read32(const uint8 * p) noexcept {
+                uint32 v; std::memcpy(&v, p, sizeof(v)); return v;
+            }
+
+            inline uint32 hash_sequence(const uint32 sequence) noexcept {
+                return (sequence * 2654435761u) >> (32 - hash_log);
+            }
+
+            /// write the remainder of the length which didn't fit the token, return `nullptr` on overflow
+            inline uint8 * write_length(uint8 * op, const uint8 * const oend, size_t length) noexcept {
+                while (length >= 255) {
+                    if (op >= oend) { return nullptr; }
+                    *op++ = 255;
+                    length -= 255;
+                }
+                if (op >= oend) { return nullptr; }
+                *op++ = static_cast<uint8>(length);
+                return op;
+            }
+
+            /// read the remainder of the length which didn't fit the token, return `false` on malformed input
+            inline bool read_length(const uint8 * & ip, const uint8 * const iend, size_t & length) noexcept {
+                uint8 b;
+                do {
+                    if (ip >= iend) { return false; }
+                    b = *ip++;
+                    length += b;
+                } while (b == 255);
+                return true;
+            }
+
+            /// write the sequence of `literals` followed by the match (if `match_length` is non-zero)
+            inline uint8 * write_sequence(uint8 * op, const uint8 * const oend, const uint8 * literals, const size_t literals_length, const size_t offset, const size_t match_length) noexcept {
+                if (op >= oend) { return nullptr; }
+                uint8 * token = op++;
+                *token = static_cast<uint8>(std::min<size_t>(literals_length, run_mask) << 4);
+                if (literals_length >= run_mask) {
+                    op = write_length(op, oend, literals_length - run_mask);
+                    if (op == nullptr) { return nullptr; }
+                }
+                if (static_cast<size_t>(oend - op) < literals_length) { return nullptr; }
+                std::memcpy(op, literals, literals_length);
+                op += literals_length;
+                if (match_length == 0) {
+                    return op;
+                }
+                if (oend - op < 2) { return nullptr; }
+                *op++ = static_cast<uint8>(offset & 0xFF);
+                *op++ = static_cast<uint8>(offset >> 8);
+                const size_t match_code = match_length - min_match;
+                *token |= static_cast<uint8>(std::min<size_t>(match_code, run_mask));
+                if (match_code >= run_mask) {
+                    op = write_length(op, oend, match_code - run_mask);
+                }
+                return op;
+            }
+        } // namespace internal
+
+
+        /// maximal size of the compressed data (for incompressible input)
+        constexpr size_t compress_bound(const size_t length) noexcept {
+            return length + length / 255 + 16;
+        }
+
+
+        /**
+         * Compress `src_length` bytes of `src` into the `dst` of `dst_capacity` bytes
+         *
+         * @return size of the compressed data or `0` if it doesn't fit the `dst_capacity`
+         */
+        inline size_t compress(const char * src, const size_t src_length, char * dst, const size_t dst_capacity) noexcept {
+            using namespace internal;
+            const uint8 * const ibegin = reinterpret_cast<const uint8 *>(src);
+            const uint8 * const iend = ibegin + src_length;
+            uint8 * op = reinterpret_cast<uint8 *>(dst);
+            uint8 * const oend = op + dst_capacity;
+            const uint8 * anchor = ibegin;
+            if (src_length > match_find_limit) {
+                // positions of recently seen 4-byte sequences
+                uint32 table[1u << hash_log] = {};
+                const uint8 * const match_limit = iend - last_literals;
+                const uint8 * const find_limit = iend - match_find_limit;
+                const uint8 * ip = ibegin + 1;
+                while (ip < find_limit) {
+                    const uint32 sequence = read32(ip);
+                    const uint32 h = hash_sequence(sequence);
+                    const uint8 * ref = ibegin + table[h];
+                    table[h] = static_cast<uint32>(ip - ibegin);
+                    if (ref >= ip || static_cast<size_t>(ip - ref) > max_offset || read32(ref) != sequence) {
+                        ++ip;
+                        continue;
+                    }
+                    // extend the match backwards over the pending literals
+                    while (ip > anchor && ref > ibegin && ip[-1] == ref[-1]) {
+                        --ip; --ref;
+                    }
+                    const uint8 * match_end = ip + min_match;
+                    const uint8 * ref_end = ref + min_match;
+                    while (match_end < match_limit && *match_end == *ref_end) {
+                        ++match_end; ++ref_end;
+                    }
+                    op = write_sequence(op, oend, anchor, static_cast<size_t>(ip - anchor), static_cast<size_t>(ip - ref), static_cast<size_t>(match_end - ip));
+                    if (op == nullptr) {
+                        return 0;
+                    }
+                    ip = anchor = match_end;
+                }
+            }
+            // the rest are literals
+            op = write_sequence(op, oend, anchor, static_cast<size_t>(iend - anchor), 0, 0);
+            if (op == nullptr) {
+                return 0;
+            }
+            return static_cast<size_t>(op - reinterpret_cast<uint8 *>(dst));
+        }
+
+
+        /**
+         * Decompress `src_length` bytes of `src` into the `dst` of exactly `dst_length` bytes
+         *
+         * @return `false` if the `src` is malformed or its decompressed size differs from `dst_length`
+         */
+        inline bool decompress(const char * src, const size_t src_length, char * dst, const size_t dst_length) noexcept {
+            using namespace internal;
+            const uint8 * ip = reinterpret_cast<const uint8 *>(src);
+            const uint8 * const iend = ip + src_length;
+            uint8 * const obegin = reinterpret_cast<uint8 *>(dst);
+            uint8 * op = obegin;
+            uint8 * const oend = op + dst_length;
+            while (ip < iend) {
+                const uint8 token = *ip++;
+                size_t literals_length = token >> 4;
+                if (literals_length == run_mask && not read_length(ip, iend, literals_length)) {
+                    return false;
+                }
+                if (static_cast<size_t>(iend - ip) < literals_length || static_cast<size_t>(oend - op) < literals_length) {
+                    return false;
+                }
+                std::memcpy(op, ip, literals_length);
+                ip += literals_length; op += literals_length;
+                if (ip == iend) {
+                    // the last sequence has no match
+                    break;
+                }
+                if (iend - ip < 2) {
+                    return false;
+                }
+                const size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+                ip += 2;
+                size_t match_length = token & run_mask;
+                if (match_length == run_mask && not read_length(ip, iend, match_length)) {
+                    return false;
+                }
+                match_length += min_match;
+                if (offset == 0 || offset > static_cast<size_t>(op - obegin) || static_cast<size_t>(oend - op) < match_length) {
+                    return false;
+                }
+                const uint8 * match = op - offset;
+                if (offset >= match_length) {
+                    std::memcpy(op, match, match_length);
+                    op += match_length;
+                } else {
+                    // overlapping copy repeats the pattern
+                    for (size_t n = 0; n < match_length; ++n) {
+                        *op++ = *match++;
+                    }
+                }
+            }
+            return op == oend;
+        }
+
+    } // namespace lz4
+
+} // namespace cachelot
+
+#endif // CACHELOT_LZ4_H_INCLUDED
@@ -64,6 +64,20 @@ namespace cachelot {
             intrusive_list_node lru_link;
             uint64 num_hits = 0;
             uint64 num_evictions = 0;
+            // hits since the page was reused last time
+            uint64 recent_hits = 0;
+            // value of the access counter on the last touch
+            uint64 last_access = 0;
+            // amount of memory occupied by the used blocks, including their headers
+            uint32 used_bytes = 0;
+            // pinned pages are excluded from the LRU list and can't be evicted
+            uint32 num_pins = 0;
+            // page was accessed since the last pass of the CLOCK hand (eviction_policy::page_clock)
+            bool referenced = false;
+            // page is in the protected segment (eviction_policy::page_slru)
+            bool is_protected = false;
+            // memory freed while the page was pinned, it's released by the last unpin
+            std::vector<void *> deferred_free;
         };
     public:
         /// Size of the page
@@ -75,14 +89,26 @@ namespace cachelot {
         /// Pointer to the arena end
         uint8 * const arena_end;
 
+        /// Strategy to choose the page to evict
+        const eviction_policy policy;
+        /// position of the CLOCK hand, always points to the beginning of a block (eviction_policy::item_clock)
+        uint8 * clock_hand;
+
         /// constructor
-        pages(const size_t the_page_size, uint8 * const the_arena_begin, uint8 * const the_arena_end)
+        pages(const size_t the_page_size, uint8 * const the_arena_begin, uint8 * const the_arena_end, const eviction_policy the_policy = eviction_policy::page_lru)
             : page_size(the_page_size)
             , num_pages((the_arena_end - the_arena_begin) / the_page_size)
             , arena_begin(the_arena_begin)
             , arena_end(the_arena_end)
+            , policy(the_policy)
+            , clock_hand(the_arena_begin)
             , log2_page_size(log2u(the_page_size))
-            , all_pages(num_pages) {
+            , all_pages(num_pages)
+            , max_protected_pages(num_pages * slru_protected_percent / 100)
+            , num_protected_pages(0)
+            , access_counter(0)
+            , num_marked(0)
+            , num_applied(0) {
             debug_assert(page_size > 0); debug_assert(ispow2(page_size));
             debug_assert(num_pages >= 4); debug_assert(ispow2(num_pages));
             // base_addr must be properly aligned
@@ -101,6 +127,12 @@ namespace cachelot {
             return &all_pages[page_no];
         }
 
+        /// retrieve metadata of the page containing address specified
+        const page_info * page_info_from_addr(const void * const ptr) const noexcept {
+            const auto page_no = page_no_from_addr(ptr);
+            return &all_pages[page_no];
+        }
+
         /// retrieve boundaries of the page containing address specified
         tuple<const uint8 * const, const uint8 * const> page_boundaries_from_addr(const void * const ptr) const noexcept {
             const auto page_no = page_no_from_addr(ptr);
@@ -113,27 +145,134 @@ namespace cachelot {
         void touch(const void * const ptr) noexcept {
             const auto page = page_info_from_addr(ptr);
             page->num_hits += 1;
-            // move closer to front
-            lru_pages.move_front(page);
+            page->recent_hits += 1;
+            page->last_access = ++access_counter;
+            if (page->num_pins == 0) {
+                on_access(page);
+            }
         }
 
-        /// retrieve the best candidate for eviction and reuse
-        tuple<uint8 *, uint8 *> page_to_reuse() noexcept {
-            page_info * least_used = lru_pages.back();
-            least_used->num_evictions += 1;
-            // make it first to prolong its life
-            lru_pages.remove(least_used);
-            lru_pages.push_front(least_used);
-            // get
+        /// protect the page containing address specified from eviction
+        void pin(const void * const ptr) noexcept {
+            const auto page = page_info_from_addr(ptr);
+            if (page->num_pins == 0) {
+                unlink(page);
+            }
+            page->num_pins += 1;
+        }
+
+        /// remove one pin from the page containing address specified, return `true` if page is no longer pinned
+        bool unpin(const void * const ptr) noexcept {
+            const auto page = page_info_from_addr(ptr);
+            debug_assert(page->num_pins > 0);
+            page->num_pins -= 1;
+            if (page->num_pins == 0) {
+                // pinned page was in use, place it at the front of its segment
+                link_front(page);
+                return true;
+            }
+            return false;
+        }
+
+        /// check whether page containing address specified is pinned
+        bool is_pinned(const void * const ptr) const noexcept {
+            return page_info_from_addr(ptr)->num_pins > 0;
+        }
+
+        /// start tracking pages read by the lock-free readers
+        void enable_read_marks() {
+            read_marks.reset(new std::atomic<bool>[num_pages]);
+            marked_pages.reset(new std::atomic<size_t>[num_pages]);
             for (size_t page_no = 0; page_no < num_pages; ++page_no) {
-                if (least_used == &all_pages[page_no]) {
-                    uint8 * page_begin = arena_begin + (page_no * page_size);
-                    uint8 * page_end = page_begin + page_size;
-                    return make_tuple(page_begin, page_end);
+                read_marks[page_no].store(false, std::memory_order_relaxed);
+                marked_pages[page_no].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        /// remember that page containing address specified was read, called by the lock-free reader
+        void mark_read(const void * const ptr) noexcept {
+            debug_assert(read_marks);
+            const size_t page_no = page_no_from_addr(ptr);
+            std::atomic<bool> & mark = read_marks[page_no];
+            // don't write the shared cache line if it's marked already
+            if (not mark.load(std::memory_order_relaxed) && not mark.exchange(true)) {
+                // the only reader which has set the mark queues the page;
+                // page is queued at most once until its mark is applied, so the queue of `num_pages` never overflows
+                const size_t slot = num_marked.fetch_add(1) & (num_pages - 1);
+                marked_pages[slot].store(page_no + 1);
+            }
+        }
+
+        /// touch pages read by the lock-free readers since the last call, takes the time proportional to their number
+        void apply_read_marks() noexcept {
+            if (not read_marks) {
+                return;
+            }
+            while (num_applied != num_marked.load()) {
+                std::atomic<size_t> & slot = marked_pages[num_applied & (num_pages - 1)];
+                const size_t marked = slot.load();
+                if (marked == 0) {
+                    // reader is queueing the page right now, it will be applied next time
+                    break;
                 }
+                slot.store(0);
+                num_applied += 1;
+                const size_t page_no = marked - 1;
+                read_marks[page_no].store(false);
+                touch(arena_begin + page_no * page_size);
+            }
+        }
+
+        /// retrieve the best candidate for eviction leaving it in place, `nullptr` if every page is pinned
+        /// (the CLOCK hand moves to the candidate, so the repeated calls don't scan the referenced pages again)
+        page_info * page_to_evict() noexcept {
+            if (lru_pages.empty()) {
+                // probationary segment is empty, evict the protected page
+                return protected_pages.empty() ? nullptr : protected_pages.back();
             }
-            debug_assert(false);
-            return tuple<uint8 *, uint8 *>(nullptr, nullptr);
+            switch (policy) {
+            case eviction_policy::value_aware:
+                return least_valuable();
+            case eviction_policy::page_clock:
+                advance_page_clock();
+                return lru_pages.back();
+            default:
+                return lru_pages.back();
+            }
+        }
+
+        /// retrieve boundaries of the `page`
+        tuple<uint8 *, uint8 *> page_boundaries(const page_info * page) const noexcept {
+            // page metadata is stored in the array, so its position is the page number
+            const size_t page_no = static_cast<size_t>(page - all_pages.data());
+            debug_assert(page_no < num_pages);
+            uint8 * page_begin = arena_begin + (page_no * page_size);
+            uint8 * page_end = page_begin + page_size;
+            return make_tuple(page_begin, page_end);
+        }
+
+        /// retrieve the best candidate for eviction and reuse, (`nullptr`, `nullptr`) if every page is pinned
+        tuple<uint8 *, uint8 *> page_to_reuse() noexcept {
+            page_info * least_used = page_to_evict();
+            if (least_used == nullptr) {
+                return tuple<uint8 *, uint8 *>(nullptr, nullptr);
+            }
+            least_used->num_evictions += 1;
+            least_used->recent_hits = 0;
+            least_used->used_bytes = 0;
+            least_used->last_access = access_counter;
+            // make it first to prolong its life, reused page has to prove its value again
+            unlink(least_used);
+            least_used->referenced = false;
+            least_used->is_protected = false;
+            link_front(least_used);
+            uint8 * page_begin, * page_end;
+            tie(page_begin, page_end) = page_boundaries(least_used);
+            // whole page becomes a single block
+            if (clock_hand >= page_begin && clock_hand < page_end) {
+                clock_hand = page_begin;
+            }
+            return make_tuple(page_begin, page_end);
         }
 
         /// check that address is within arena range
@@ -141,11 +280,135 @@ namespace cachelot {
             auto u8_ptr = reinterpret_cast<const uint8 * const>(ptr);
             return u8_ptr >= arena_begin && u8_ptr < arena_end;
         }
+
+        /// block at `absorbed` was merged into the `merged` one
+        void forget_block(const void * const absorbed, void * const merged) noexcept {
+            if (clock_hand == absorbed) {
+                clock_hand = reinterpret_cast<uint8 *>(merged);
+            }
+        }
+
+        /// move CLOCK hand to the `next` block, wrapping around the arena end
+        void advance_clock_hand(void * const next) noexcept {
+            clock_hand = reinterpret_cast<uint8 *>(next);
+            debug_assert(clock_hand <= arena_end);
+            if (clock_hand == arena_end) {
+                clock_hand = arena_begin;
+            }
+        }
+
+        /// account block of `size` bytes allocated at `ptr`
+        void add_used(const void * const ptr, const uint32 size) noexcept {
+            auto page = page_info_from_addr(ptr);
+            page->used_bytes += size;
+            debug_assert(page->used_bytes <= page_size);
+        }
+
+        /// account block of `size` bytes freed at `ptr`
+        void remove_used(const void * const ptr, const uint32 size) noexcept {
+            auto page = page_info_from_addr(ptr);
+            debug_assert(page->used_bytes >= size);
+            page->used_bytes -= size;
+        }
+
     private:
-        unsigned page_no_from_addr(const void * const ptr) const noexcept {
+        /// move the hand of the eviction_policy::page_clock to the first page without the reference bit,
+        /// referenced pages on its way get the second chance (every page loses its bit after the full turn)
+        void advance_page_clock() noexcept {
+            while (lru_pages.back()->referenced) {
+                page_info * page = lru_pages.back();
+                page->referenced = false;
+                lru_pages.remove(page);
+                lru_pages.push_front(page);
+            }
+        }
+
+        /// reorder accessed `page` according to the eviction policy
+        void on_access(page_info * page) noexcept {
+            switch (policy) {
+            case eviction_policy::page_fifo:
+                // pages are evicted in the order they were reused
+                break;
+            case eviction_policy::page_clock:
+                page->referenced = true;
+                break;
+            case eviction_policy::page_slru:
+                if (page->is_protected) {
+                    // move closer to front
+                    protected_pages.move_front(page);
+                } else {
+                    // promote page accessed once again to the protected segment
+                    unlink(page);
+                    page->is_protected = true;
+                    link_front(page);
+                    if (num_protected_pages > max_protected_pages) {
+                        // demote the least recently used protected page to give it the last chance
+                        page_info * demoted = protected_pages.back();
+                        unlink(demoted);
+                        demoted->is_protected = false;
+                        link_front(demoted);
+                    }
+                }
+                break;
+            default:
+                // move closer to front
+                lru_pages.move_front(page);
+                break;
+            }
+        }
+
+        /// place `page` at the front of its segment
+        void link_front(page_info * page) noexcept {
+            if (page->is_protected) {
+                protected_pages.push_front(page);
+                num_protected_pages += 1;
+            } else {
+                lru_pages.push_front(page);
+            }
+        }
+
+        /// remove `page` from its segment
+        void unlink(page_info * page) noexcept {
+            if (page->is_protected) {
+                protected_pages.remove(page);
+                num_protected_pages -= 1;
+            } else {
+                lru_pages.remove(page);
+            }
+        }
+
+        /**
+         * choose the page whose eviction loses the least among the `eviction_sample_size` pages at the LRU tail
+         *
+         * Loss is estimated as `(recent_hits + 1) * used_bytes / (age + 1)`, where age is
+         * the number of accesses since the page was touched last time. So, the hot and recently used pages survive,
+         * while the cold and sparsely filled ones are evicted first. Ties are resolved in the LRU order.
+         */
+        page_info * least_valuable() noexcept {
+            page_info * victim = lru_pages.back();
+            double victim_loss = eviction_loss(victim);
+            page_info * candidate = lru_pages.previous(victim);
+            for (size_t n = 1; n < eviction_sample_size && candidate != nullptr && victim_loss > 0; ++n) {
+                const double candidate_loss = eviction_loss(candidate);
+                if (candidate_loss < victim_loss) {
+                    victim = candidate;
+                    victim_loss = candidate_loss;
+                }
+                candidate = lru_pages.previous(candidate);
+            }
+            return victim;
+        }
+
+        /// estimated hit value lost by evicting the `page`
+        double eviction_loss(const page_info * page) const noexcept {
+            const uint64 age = access_counter - page->last_access;
+            return static_cast<double>(page->recent_hits + 1) * page->used_bytes / static_cast<double>(age + 1);
+        }
+
+        size_t page_no_from_addr(const void * const ptr) const noexcept {
             debug_assert(valid_addr(ptr));
             auto ui8_ptr = reinterpret_cast<const uint8 * const>(ptr);
-            auto page_no = static_cast<unsigned>(ui8_ptr - arena_begin) >> log2_page_size;
+            auto page_no = static_cast<size_t>(ui8_ptr - arena_begin) >> log2_page_size;
             debug_assert(page_no < num_pages);
             return page_no;
         }
@@ -153,7 +416,20 @@ namespace cachelot {
     private:
         const size_t log2_page_size;
         std::vector<page_info> all_pages;
+        // all pages in the LRU (FIFO, CLOCK) order, only the probationary segment for the eviction_policy::page_slru
         intrusive_list<page_info, &page_info::lru_link> lru_pages;
+        // pages accessed at least once since they were reused (eviction_policy::page_slru)
+        intrusive_list<page_info, &page_info::lru_link> protected_pages;
+        const size_t max_protected_pages;
+        size_t num_protected_pages;
+        // incremented on every touch, serves as a logical clock to calculate age of a page
+        uint64 access_counter;
+        // pages read by the lock-free readers since the last eviction, `nullptr` unless they're enabled
+        std::unique_ptr<std::atomic<bool>[]> read_marks;
+        // queue of the marked pages (`page_no + 1`, 0 is the slot being written) to apply the marks without scanning all of them
+        std::unique_ptr<std::atomic<size_t>[]> marked_pages;
+        std::atomic<size_t> num_marked;
+        size_t num_applied;
     private:
         friend struct test_memalloc::test_pages;
     };
@@ -168,7 +444,8 @@ namespace cachelot {
         struct {
             uint32 size : 31;   /// amount of memory available to user
             bool used : 1;      /// indicate whether block is used
-            uint32 left_adjacent_offset;  /// offset of previous block in continuous arena
+            uint32 left_adjacent_offset : 31;  /// offset of previous block in continuous arena
+            bool referenced : 1;  /// block was accessed since the CLOCK hand passed it (eviction_policy::item_clock)
             /// debug marker to identify corrupted memory
             debug_only(uint32 dbg_marker1;)
             debug_only(uint32 dbg_marker2;)
@@ -206,6 +483,7 @@ namespace cachelot {
             meta.size = the_size;
             meta.used = false;
             meta.left_adjacent_offset = left_adjacent_block_offset;
+            meta.referenced = false;
         }
 
         ~block(); // Must not be called
@@ -231,6 +509,12 @@ namespace cachelot {
         /// mark block as free
         void set_free() noexcept { debug_assert(meta.used == true); meta.used = false; }
 
+        /// check whether block was accessed since the CLOCK hand passed it
+        bool is_referenced() const noexcept { return meta.referenced; }
+
+        /// mark block as accessed / give it the second chance
+        void set_referenced(const bool referenced) noexcept { meta.referenced = referenced; }
+
         /// return pointer to memory available to user
         void * memory() noexcept { return memory_; }
 
@@ -294,6 +578,8 @@ namespace cachelot {
             // Only free blocks may be merged, user data must left untouched
             debug_assert(left_block->is_free()); debug_assert(right_block->is_free());
             memalloc::block * block_after_right = right_block->right_adjacent();
+            // right block no longer exists, CLOCK hand must not point to it
+            pgs->forget_block(right_block, left_block);
             left_block->set_size(left_block->size() + right_block->size_with_header());
             if (reinterpret_cast<uint8 *>(block_after_right) < pgs->arena_end) {
                 block_after_right->meta.left_adjacent_offset = left_block->size_with_header();
@@ -560,6 +846,22 @@ namespace cachelot {
             return nullptr;
         }
 
+        /// check whether there is a block of at least `size` bytes, unlike try_get_block() block stays in the table
+        bool has_block(const uint32 size) noexcept {
+            position pos = position_from_size(size);
+            bool has_bigger_block;
+            do {
+                if (bit_index_probe(pos)) {
+                    auto & size_class = size_classes_table[pos.absolute()];
+                    if (not size_class.empty() && size_class.front()->size() >= size) {
+                        return true;
+                    }
+                }
+                tie(has_bigger_block, pos) = next_non_empty(pos);
+            } while (has_bigger_block);
+            return false;
+        }
+
         /// store block `blk` at position corresponding to its size
         void put_block(block * blk) {
             debug_assert(blk->is_free());
@@ -598,10 +900,11 @@ namespace cachelot {
 
 ////////////////////////////////// memalloc //////////////////////////////////////
 
-    inline memalloc::memalloc(const size_t memory_limit, const uint32 the_page_size)
+    inline memalloc::memalloc(const size_t memory_limit, const uint32 the_page_size, const eviction_policy policy, const arena_options & options, const bool concurrent_reads)
         : arena_size(memory_limit)
         , page_size(the_page_size)
-        , m_arena(nullptr, &std::free) {
+        , m_arena()
+        , m_epochs(concurrent_reads ? new epoch_domain() : nullptr) {
         debug_assert(ispow2(memory_limit));
         debug_assert(page_size > 0);
         debug_assert(ispow2(page_size));
@@ -610,13 +913,13 @@ namespace cachelot {
         debug_assert(memory_limit % page_size == 0);
         STAT_SET(mem.limit_maxbytes, memory_limit);
         STAT_SET(mem.page_size, page_size);
-        m_arena.reset(aligned_alloc(page_size, arena_size));
-        if (m_arena == nullptr) {
-            throw std::bad_alloc();
-        }
+        m_arena = allocate_arena(arena_size, page_size, options);
         auto arena_begin = reinterpret_cast<uint8 *>(m_arena.get());
-        m_pages.reset(new pages(page_size, arena_begin, arena_begin + memory_limit));
+        m_pages.reset(new pages(page_size, arena_begin, arena_begin + memory_limit, policy));
         m_free_blocks.reset(new free_blocks_by_size(page_size));
+        if (concurrent_reads) {
+            m_pages->enable_read_marks();
+        }
         // pointer to currently non-used memory
         uint8 * available = arena_begin;
         // End-Of-Memory marker
@@ -696,11 +999,25 @@ namespace cachelot {
             m_free_blocks->put_block(leftover);
         }
         blk->set_used();
+        blk->set_referenced(false);
+        m_pages->add_used(blk, blk->size_with_header());
         STAT_INCR(mem.used_memory, blk->size_with_header());
         return blk->memory();
     }
 
 
+    inline void * memalloc::alloc_free_block(const uint32 size) noexcept {
+        block * found_blk = m_free_blocks->try_get_block(size);
+        if (found_blk != nullptr) {
+            m_pages->touch(found_blk);
+            auto mem = checkout(found_blk, size);
+            STAT_INCR(mem.total_served, reveal_actual_size(mem));
+            return mem;
+        }
+        return nullptr;
+    }
+
+
     inline bool memalloc::valid_addr(void * ptr) const noexcept {
         if (m_pages->valid_addr(ptr)) {
             block::from_user_ptr(ptr);
@@ -718,11 +1035,92 @@ namespace cachelot {
         debug_assert(block::from_user_ptr(ptr)->is_used());
         // additional sanity check
         debug_only(block::from_user_ptr(ptr)->__debug_sanity_check(m_pages));
+        // give the block second chance against the CLOCK hand
+        block::from_user_ptr(ptr)->set_referenced(true);
         // touch corresponding page
         m_pages->touch(ptr);
     }
 
 
+    inline void memalloc::pin(const void * ptr) noexcept {
+        #if defined(ADDRESS_SANITIZER)
+        return;
+        #endif
+        debug_assert(m_pages->valid_addr(ptr));
+        m_pages->pin(ptr);
+    }
+
+    inline bool memalloc::unpin(const void * ptr) noexcept {
+        #if defined(ADDRESS_SANITIZER)
+        return true;
+        #endif
+        debug_assert(m_pages->valid_addr(ptr));
+        if (m_pages->unpin(ptr)) {
+            free_deferred(ptr);
+            return true;
+        }
+        return false;
+    }
+
+    inline bool memalloc::is_pinned(const void * ptr) const noexcept {
+        #if defined(ADDRESS_SANITIZER)
+        return false;
+        #endif
+        debug_assert(m_pages->valid_addr(ptr));
+        return m_pages->is_pinned(ptr);
+    }
+
+
+    inline bool memalloc::free_when_unpinned(void * ptr) noexcept {
+        if (is_pinned(ptr)) {
+            m_pages->page_info_from_addr(ptr)->deferred_free.push_back(ptr);
+            return false;
+        }
+        free(ptr);
+        return true;
+    }
+
+    inline void memalloc::free_deferred(const void * ptr) noexcept {
+        // only the memory of this page is visited
+        auto & deferred = m_pages->page_info_from_addr(ptr)->deferred_free;
+        for (void * garbage : deferred) {
+            free(garbage);
+        }
+        deferred.clear();
+    }
+
+
+    inline void memalloc::retire(void * ptr) {
+        debug_assert(m_epochs);
+        // readers may still use the block, it must not be evicted
+        pin(ptr);
+        m_epochs->retire(ptr);
+    }
+
+    inline size_t memalloc::reclaim() noexcept {
+        if (not m_epochs) {
+            return 0;
+        }
+        size_t num_freed = 0;
+        m_epochs->reclaim([&](void * ptr) -> void {
+            // drop the pin placed by `retire()`, memory waits for the remaining pins of its page
+            unpin(ptr);
+            if (free_when_unpinned(ptr)) {
+                num_freed += 1;
+            }
+        });
+        return num_freed;
+    }
+
+    inline void memalloc::touch_concurrent(const void * ptr) const noexcept {
+        #if defined(ADDRESS_SANITIZER)
+        return;
+        #endif
+        debug_assert(m_pages->valid_addr(ptr));
+        m_pages->mark_read(ptr);
+    }
+
+
     template <typename ForeachFreed>
     inline void * memalloc::alloc_or_evict(const size_t requested_size, bool evict_if_necessary, ForeachFreed on_free_block) {
         debug_assert(requested_size > 0); debug_assert(requested_size <= page_size);
@@ -734,20 +1132,45 @@ namespace cachelot {
 
         STAT_INCR(mem.num_malloc, 1);
         STAT_INCR(mem.total_requested, size);
+        if (m_epochs && m_epochs->num_retired() >= reclaim_batch_size) {
+            reclaim();
+        }
         // 1. Search among the free blocks
         {
-            block * found_blk = m_free_blocks->try_get_block(size);
-            if (found_blk != nullptr) {
-                m_pages->touch(found_blk);
-                auto mem = checkout(found_blk, size);
+            auto mem = alloc_free_block(size);
+            if (mem != nullptr) {
+                return mem;
+            }
+        }
+        // 2. Reuse retired blocks the readers have left before evicting anything
+        if (m_epochs && reclaim() > 0) {
+            auto mem = alloc_free_block(size);
+            if (mem != nullptr) {
+                return mem;
+            }
+        }
+        // pages read by the lock-free readers compete for survival too
+        if (evict_if_necessary) {
+            m_pages->apply_read_marks();
+        }
+        // 3. Try to evict existing block to free some space
+        if (evict_if_necessary && m_pages->policy == eviction_policy::item_clock) {
+            auto mem = evict_items(size, on_free_block);
+            if (mem != nullptr) {
                 STAT_INCR(mem.total_served, reveal_actual_size(mem));
                 return mem;
             }
+            // there are not enough cold blocks in a row, fallback to the page eviction
         }
-        // 2. Try to evict existing block to free some space
         if (evict_if_necessary) {
             uint8 * page_begin, * page_end;
             tie(page_begin, page_end) = m_pages->page_to_reuse();
+            if (page_begin == nullptr) {
+                // every page is pinned
+                STAT_INCR(mem.num_alloc_errors, 1);
+                STAT_INCR(mem.total_unserved, size);
+                return nullptr;
+            }
             // clean the page, evict used blocks, remove free blocks from the free_blocks list
             auto blk = reinterpret_cast<block *>(page_begin); // every page starts with the block
             debug_only(blk->assert_dbg_marker());
@@ -765,11 +1188,16 @@ namespace cachelot {
                 blk = blk->right_adjacent();
             } while (reinterpret_cast<uint8 *>(blk) < page_end);
             debug_assert(reinterpret_cast<uint8 *>(blk) == page_end);
+            if (m_epochs) {
+                // page is overwritten below, readers of evicted items must leave it first
+                m_epochs->synchronize();
+            }
 
             // adjust the fist block in the next page
             if (page_end < reinterpret_cast<uint8 *>(m_arena.get()) + arena_size) {
                 reinterpret_cast<block *>(page_end)->meta.left_adjacent_offset = page_size;
             }
+            STAT_INCR(mem.evicted_pages, 1);
             auto whole_page_block = new (page_begin) block(page_size - block::header_size, left_adjacent_block_offset);
             auto mem = checkout(whole_page_block, size);
             STAT_INCR(mem.total_served, reveal_actual_size(mem));
@@ -782,6 +1210,129 @@ namespace cachelot {
     }
 
 
+    template <typename ForeachVictim>
+    inline void memalloc::foreach_eviction_victim(const size_t requested_size, ForeachVictim on_victim) noexcept {
+        debug_assert(requested_size > 0); debug_assert(requested_size <= page_size);
+        const auto size = static_cast<uint32>(requested_size);
+
+        #if defined(ADDRESS_SANITIZER)
+        return;
+        #endif
+
+        if (m_free_blocks->has_block(size)) {
+            // allocation won't evict anything
+            return;
+        }
+        if (m_pages->policy == eviction_policy::item_clock) {
+            // follow the CLOCK hand looking for the run of cold blocks big enough
+            // (the actual sweep may also merge free blocks left to the hand, so it's a pessimistic guess);
+            // only the sweep clears the reference bits, so search is limited to not walk the whole arena of hot blocks every time
+            const size_t max_bytes_swept = std::min<size_t>(arena_size, victim_search_pages * page_size);
+            uint8 * run_begin = m_pages->clock_hand;
+            size_t run_bytes = 0;
+            uint8 * pos = m_pages->clock_hand;
+            for (size_t bytes_swept = 0; bytes_swept < max_bytes_swept; ) {
+                auto blk = reinterpret_cast<block *>(pos);
+                const uint8 * page_begin; const uint8 * page_end;
+                tie(page_begin, page_end) = m_pages->page_boundaries_from_addr(blk);
+                if (pos == page_begin || m_pages->is_pinned(blk)) {
+                    // run can't cross the page boundary
+                    run_begin = pos; run_bytes = 0;
+                }
+                if (m_pages->is_pinned(blk)) {
+                    bytes_swept += page_end - pos;
+                    pos = const_cast<uint8 *>(page_end);
+                } else {
+                    bytes_swept += blk->size_with_header();
+                    pos = reinterpret_cast<uint8 *>(blk->right_adjacent());
+                    if (blk->is_used() && blk->is_referenced()) {
+                        run_begin = pos; run_bytes = 0;
+                    } else {
+                        run_bytes += blk->size_with_header();
+                        if (run_bytes - block::header_size >= size) {
+                            for (auto victim = reinterpret_cast<block *>(run_begin); victim != blk->right_adjacent(); victim = victim->right_adjacent()) {
+                                if (victim->is_used()) {
+                                    on_victim(victim->memory());
+                                }
+                            }
+                            return;
+                        }
+                    }
+                }
+                if (pos == m_pages->arena_end) {
+                    pos = m_pages->arena_begin;
+                    run_begin = pos; run_bytes = 0;
+                }
+            }
+            // estimate by the page the sweep would fallback to
+        }
+        auto victim_page = m_pages->page_to_evict();
+        if (victim_page == nullptr) {
+            // every page is pinned
+            return;
+        }
+        uint8 * page_begin, * page_end;
+        tie(page_begin, page_end) = m_pages->page_boundaries(victim_page);
+        auto blk = reinterpret_cast<block *>(page_begin); // every page starts with the block
+        do {
+            if (blk->is_used()) {
+                on_victim(blk->memory());
+            }
+            blk = blk->right_adjacent();
+        } while (reinterpret_cast<uint8 *>(blk) < page_end);
+    }
+
+
+    template <typename ForeachFreed>
+    inline void * memalloc::evict_items(const uint32 size, ForeachFreed on_free_block) {
+        // every block gets at most two visits: first one clears the reference bit, second one evicts
+        size_t bytes_to_sweep = arena_size * 2;
+        while (bytes_to_sweep > 0) {
+            auto blk = reinterpret_cast<block *>(m_pages->clock_hand);
+            debug_only(blk->assert_dbg_marker());
+            if (m_pages->is_pinned(blk)) {
+                // skip the whole page, its blocks can't be evicted
+                const uint8 * page_begin; const uint8 * page_end;
+                tie(page_begin, page_end) = m_pages->page_boundaries_from_addr(blk);
+                bytes_to_sweep -= std::min<size_t>(bytes_to_sweep, page_end - m_pages->clock_hand);
+                m_pages->advance_clock_hand(const_cast<uint8 *>(page_end));
+                continue;
+            }
+            bytes_to_sweep -= std::min<size_t>(bytes_to_sweep, blk->size_with_header());
+            if (blk->is_used()) {
+                if (blk->is_referenced()) {
+                    blk->set_referenced(false);
+                    m_pages->advance_clock_hand(blk->right_adjacent());
+                    continue;
+                }
+                // cold block, evict it
+                on_free_block(blk->memory());
+                if (m_epochs) {
+                    // block may be reused below, readers of the evicted item must leave it first
+                    m_epochs->synchronize();
+                }
+                STAT_INCR(mem.evictions, 1);
+                blk->set_free();
+                m_pages->remove_used(blk, blk->size_with_header());
+                STAT_DECR(mem.used_memory, blk->size_with_header());
+            } else {
+                m_free_blocks->remove_block(blk);
+            }
+            // coalesce with the free neighbours, hand moves to the resulting block
+            blk = merge_free(blk);
+            if (blk->size() >= size) {
+                m_pages->touch(blk);
+                auto mem = checkout(blk, size);
+                m_pages->advance_clock_hand(blk->right_adjacent());
+                return mem;
+            }
+            m_free_blocks->put_block(blk);
+            m_pages->advance_clock_hand(blk->right_adjacent());
+        }
+        return nullptr;
+    }
+
+
     inline void * memalloc::realloc_inplace(void * ptr, const size_t new_size) noexcept {
         #if defined(ADDRESS_SANITIZER)
         return nullptr;
@@ -792,15 +1343,20 @@ namespace cachelot {
         STAT_INCR(mem.num_realloc, 1);
         block * blk = block::from_user_ptr(ptr);
         debug_only(blk->__debug_sanity_check(m_pages));
+        // block keeps its content, so it keeps the reference bit too
+        const bool referenced = blk->is_referenced();
 
         blk->set_free();
+        m_pages->remove_used(blk, blk->size_with_header());
         STAT_DECR(mem.used_memory, blk->size_with_header());
 
         const auto size = static_cast<uint32>(new_size);
 
         // 1. shrink the block
         if (new_size <= blk->size()) {
-            return checkout(blk, size);
+            auto mem = checkout(blk, size);
+            blk->set_referenced(referenced);
+            return mem;
         }
 
         // 2. try to expand the block to the right
@@ -809,6 +1365,7 @@ namespace cachelot {
         blk = merge_free_right(blk);
         if (blk->size() >= new_size) {
             auto mem = checkout(blk, size);
+            blk->set_referenced(referenced);
             STAT_INCR(mem.total_realloc_served, reveal_actual_size(mem) - old_block_size - block::header_size);
             return mem;
         } else {
@@ -816,6 +1373,7 @@ namespace cachelot {
             STAT_INCR(mem.total_realloc_unserved, new_size - old_block_size);
             // return block to its original state
             checkout(blk, old_block_size);
+            blk->set_referenced(referenced);
             STAT_INCR(mem.num_realloc_errors, 1);
             return nullptr;
         }
@@ -833,6 +1391,7 @@ namespace cachelot {
         block * blk = block::from_user_ptr(ptr);
         debug_only(blk->__debug_sanity_check(m_pages));
         blk->set_free();
+        m_pages->remove_used(blk, blk->size_with_header());
         STAT_DECR(mem.used_memory, blk->size_with_header());
         // merge with neighbours
         blk = merge_free(blk);
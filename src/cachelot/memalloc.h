@@ -19,6 +19,12 @@
 #ifndef CACHELOT_INTRUSIVE_LIST_H_INCLUDED
 #  include <cachelot/intrusive_list.h> // pages LRU and free blocks list
 #endif
+#ifndef CACHELOT_ARENA_H_INCLUDED
+#  include <cachelot/arena.h> // huge pages / NUMA
+#endif
+#ifndef CACHELOT_EPOCH_H_INCLUDED
+#  include <cachelot/epoch.h> // lock-free readers
+#endif
 
 // forward declaration to make friends with the unit test cases
 namespace { namespace test_memalloc {
@@ -43,11 +49,11 @@ namespace cachelot {
     *  - has small overhead (8 bytes of metadata per allocation + alignment bytes)
     *
     * Limitations:
-    *  - memalloc is single threaded by design
+    *  - memalloc is single threaded by design (memory may be read concurrently, see `concurrent_reads`)
     *  - maximal single allocation size is limited to `allocation_limit`
     *  - does not distinguish virtual and physical memory (treat whole given memory as commited) and
     *  - does not give unused memory back to OS (actually it doesn't call malloc / free or equivalents at all,
-    *    initial contiguous memory volume 'arena' must be pre-allocated by user)
+    *    initial contiguous memory volume 'arena' is allocated at once, see arena_options)
     *  - contrary to standard malloc implementations allocated memory is aligned to sizeof(void *) bytes boundary (not 16)
     *
     * @see @ref memalloc (memalloc-inl.h) for implementation details
@@ -57,12 +63,40 @@ namespace cachelot {
         class block;
         class free_blocks_by_size;
     public:
+        /// Strategy to choose the page to evict when allocator ran out of free memory
+        enum class eviction_policy : uint8 {
+            page_lru,       ///< least recently used page (pages move closer to the head on access)
+            value_aware,    ///< page losing the least hit value among the several least recently used ones
+            item_clock,     ///< individual blocks which were not touched since the last CLOCK sweep (page_lru as a fallback)
+            page_slru,      ///< segmented LRU: pages accessed after reuse are protected, the least recently used probationary page is evicted
+            page_clock,     ///< pages are reused in the round robin order, page accessed since the last turn gets the second chance
+            page_fifo       ///< pages are reused in the round robin order, regardless of access
+        };
+
+        /// number of pages at the LRU tail considered by the eviction_policy::value_aware
+        static constexpr size_t eviction_sample_size = 8;
+
+        /// share of pages in the protected segment of the eviction_policy::page_slru
+        static constexpr size_t slru_protected_percent = 80;
+
+        /// number of pages `foreach_eviction_victim()` looks through for the cold blocks of the eviction_policy::item_clock,
+        /// before it falls back to the page victim
+        static constexpr size_t victim_search_pages = 4;
+
+        /// number of retired blocks which makes the allocation reclaim them (see `concurrent_reads`)
+        static constexpr size_t reclaim_batch_size = 64;
+
         /// constructor
         /// @p arena_size - amount of memory in bytes to work with
         /// @p page_size - size of internal allocator page.
         ///                Page size limits single allocation size.
         ///                The less page is, the less items would be evicted when allocator ran out of free memory
-        explicit memalloc(const size_t memory_limit, const uint32 page_size);
+        /// @p policy - how to choose the page to evict
+        /// @p options - huge pages and NUMA placement of the arena
+        /// @p concurrent_reads - allocated memory is read by the lock-free readers, it's reused only when they can't access it
+        ///                       (freed memory must be retire()-d and eviction waits for the readers, see epoch_domain)
+        explicit memalloc(const size_t memory_limit, const uint32 page_size, const eviction_policy policy = eviction_policy::page_lru,
+                          const arena_options & options = arena_options(), const bool concurrent_reads = false);
 
 
         /// move contructor
@@ -86,6 +120,12 @@ namespace cachelot {
         void * alloc_or_evict(size_t size, bool evict_if_necessary = false,
                               ForeachFreed on_free_block = [](void *) -> void {});
 
+        /// visit previously allocated blocks which would be evicted by the `alloc_or_evict(size, true)` call
+        /// none is visited when there is enough free memory
+        /// @tparam ForeachVictim - `void on_victim(void * ptr)`
+        template <typename ForeachVictim>
+        void foreach_eviction_victim(size_t size, ForeachVictim on_victim) noexcept;
+
         /// try to extend previously allocated memory up to `new_size`, return `nullptr` on fail
         void * realloc_inplace(void * ptr, const size_t new_size) noexcept;
 
@@ -95,6 +135,35 @@ namespace cachelot {
         /// touch previously allocated item to increase it's chance to avoid eviction
         void touch(void * ptr) noexcept;
 
+        /// protect the page of previously allocated `ptr` from eviction until the matching `unpin()`
+        /// @note pins are counted, pinned memory still may be freed, it's up to user to defer `free()`
+        void pin(const void * ptr) noexcept;
+
+        /// remove one pin placed by the `pin()`, return `true` if page of `ptr` is no longer pinned
+        /// memory of the page passed to the `free_when_unpinned()` is freed by the last unpin
+        bool unpin(const void * ptr) noexcept;
+
+        /// check whether page of previously allocated `ptr` is pinned
+        bool is_pinned(const void * ptr) const noexcept;
+
+        /// free previously allocated `ptr` now or, if its page is pinned, once the page is unpinned
+        /// @return `true` if memory was freed right away
+        bool free_when_unpinned(void * ptr) noexcept;
+
+        /// epochs of the lock-free readers, `nullptr` unless allocator is created with `concurrent_reads`
+        epoch_domain * epochs() const noexcept { return m_epochs.get(); }
+
+        /// free previously allocated `ptr` once no lock-free reader may access it, page is protected from eviction meanwhile
+        /// @note `ptr` must be unreachable for the readers entering from now on (memory is never reclaimed within this call)
+        void retire(void * ptr);
+
+        /// free retired memory which is no longer accessed by the lock-free readers, return number of freed blocks
+        size_t reclaim() noexcept;
+
+        /// increase the chance of the page of `ptr` to avoid eviction, unlike `touch()` it's safe to call from the lock-free reader
+        /// @note recency is tracked per page, it's taken into account on the next eviction
+        void touch_concurrent(const void * ptr) const noexcept;
+
         /// return size of previously allocate memory including alignment bytes
         size_t reveal_actual_size(void * ptr) const noexcept;
 
@@ -111,12 +180,23 @@ namespace cachelot {
         /// coalesce adjacent free blocks up to the page size and return resulting block
         block * merge_free(block * block) noexcept;
 
+        /// free memory deferred by the `free_when_unpinned()` until the page of `ptr` is unpinned
+        void free_deferred(const void * ptr) noexcept;
+
         /// mark block as non-used and coalesce it with adjacent unused blocks
         void unuse(block * & blk) noexcept;
 
         /// mark block as used and give requested memory to user
         void * checkout(block * blk, const uint32 requested_size) noexcept;
 
+        /// allocate memory from the free blocks, return `nullptr` if none fits
+        void * alloc_free_block(const uint32 size) noexcept;
+
+        /// sweep the CLOCK hand over the arena and evict cold blocks until adjacent free space fits `size`
+        /// @return memory of the requested size or `nullptr` if sweep failed
+        template <typename ForeachFreed>
+        void * evict_items(const uint32 size, ForeachFreed on_free_block);
+
         // disallow copying
         memalloc(const memalloc &) = delete;
         memalloc & operator=(const memalloc &) = delete;
@@ -132,11 +212,13 @@ namespace cachelot {
         const uint32 page_size;
     private:
         // pointer to the memory arena
-        std::unique_ptr<void, decltype(&std::free)> m_arena;
+        arena_ptr m_arena;
         // logical pages
         std::unique_ptr<pages> m_pages;
         // free memory blocks are placed in the table, grouped by block size
         std::unique_ptr<free_blocks_by_size> m_free_blocks;
+        // readers of the memory (`concurrent_reads` only)
+        std::unique_ptr<epoch_domain> m_epochs;
 
         // Test cases
         friend struct test_memalloc::test_free_blocks_by_size;
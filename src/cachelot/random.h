@@ -9,6 +9,8 @@
 
 
 #include <random>
+#include <cmath>
+#include <algorithm>
 
 
 namespace cachelot {
@@ -39,6 +41,36 @@ namespace cachelot {
     template <typename IntType>
     typename random_int<IntType>::random_engine_type random_int<IntType>::random_engine;
 
+    /// generate random integer in [0, n) range with Zipf distribution, `0` is the most frequent one
+    class random_zipf {
+    public:
+        /// @p n - number of distinct values
+        /// @p skew - Zipf exponent, the greater it is, the more frequent are the top values
+        explicit random_zipf(size_t n, double skew)
+            : m_cdf(n)
+            , m_uniform(0.0, 1.0) {
+            debug_assert(n > 0);
+            double sum = 0.0;
+            for (size_t rank = 0; rank < n; ++rank) {
+                sum += 1.0 / std::pow(static_cast<double>(rank + 1), skew);
+                m_cdf[rank] = sum;
+            }
+            for (auto & cumulative : m_cdf) {
+                cumulative /= sum;
+            }
+        }
+
+        size_t operator() () {
+            const double u = m_uniform(m_random_engine);
+            const auto found = std::lower_bound(m_cdf.begin(), m_cdf.end(), u);
+            return found != m_cdf.end() ? static_cast<size_t>(found - m_cdf.begin()) : m_cdf.size() - 1;
+        }
+    private:
+        std::vector<double> m_cdf;
+        std::uniform_real_distribution<double> m_uniform;
+        std::minstd_rand m_random_engine;
+    };
+
     /// generate random string of `length` chars from pre-defined alphabet
     inline string random_string(size_t minlen, size_t maxlen) {
         static const char charset[] =
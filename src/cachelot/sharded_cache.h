@@ -0,0 +1,315 @@
+#ifndef CACHELOT_SHARDED_CACHE_H_INCLUDED
+#define CACHELOT_SHARDED_CACHE_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+
+#ifndef CACHELOT_CACHE_H_INCLUDED
+#  include <cachelot/cache.h>
+#endif
+
+#include <mutex>
+
+namespace cachelot {
+
+    /// @addtogroup cache
+    /// @{
+
+    namespace cache {
+
+        /**
+         * Cache partitioned into the number of independent shards
+         *
+         * Every shard is a separate Cache instance with its own memory arena, dictionary, stats and lock.
+         * Items are distributed among the shards by the most significant bits of their hash,
+         * the least significant bits are left to the hash table of the shard.
+         * Cache, memalloc and dict stay single threaded: a shard is modified by one thread at a time,
+         * though with `concurrent_reads` it may be read by the other threads without the lock (see do_get())
+         *
+         * @ingroup cache
+         */
+        class ShardedCache {
+            struct Shard {
+                explicit Shard(size_t memory_limit, size_t mem_page_size, size_t initial_dict_size, bool enable_evictions, EvictionPolicy eviction_policy, bool enable_admission_filter, bool enable_cas, size_t compression_threshold, const ArenaOptions & arena, bool concurrent_reads, bool background_rehash);
+                ~Shard();
+
+                std::mutex lock;
+                stats shard_stats;
+                std::unique_ptr<Cache> cache;
+            };
+        public:
+            /**
+             * Exclusive access to the single shard
+             *
+             * Shard remains locked and receives stats of the current thread until `locked_shard` goes out of scope
+             */
+            class locked_shard {
+            public:
+                explicit locked_shard(Shard & shard)
+                    : m_lock(shard.lock)
+                    , m_stats(shard.shard_stats)
+                    , m_cache(shard.cache.get()) {
+                }
+
+                locked_shard(locked_shard &&) = default;
+
+                Cache * operator->() const noexcept { return m_cache; }
+                Cache & operator*() const noexcept { return *m_cache; }
+
+            private:
+                std::unique_lock<std::mutex> m_lock;
+                stats_scope m_stats;
+                Cache * m_cache;
+            };
+
+            /**
+             * Exclusive access to the several shards at once
+             *
+             * Shards are locked in ascending order (to avoid deadlocks) and remain locked until `locked_shards` goes out of scope
+             */
+            class locked_shards {
+            public:
+                locked_shards(locked_shards &&) = default;
+
+                /// Cache responsible for the given `hash`, its shard must be one of the locked
+                Cache & cache_for(const hash_type hash) const noexcept {
+                    const size_t n = m_owner->shard_no(hash);
+                    debug_assert(std::any_of(m_locks.begin(), m_locks.end(), [=](const std::unique_lock<std::mutex> & l) { return l.mutex() == &m_owner->m_shards[n]->lock; }));
+                    return *m_owner->m_shards[n]->cache;
+                }
+
+            private:
+                friend class ShardedCache;
+                explicit locked_shards(ShardedCache & owner) : m_owner(&owner), m_locks() {}
+
+                ShardedCache * m_owner;
+                std::vector<std::unique_lock<std::mutex>> m_locks;
+            };
+
+        public:
+            /**
+             * constructor
+             *
+             * @param num_shards - number of independent Cache instances (must be power of 2)
+             * @param memory_limit - total amount of memory, it is equally divided among the shards
+             * @param mem_page_size - size of the allocator memory page
+             * @param initial_dict_size - total number of reserved items in dictionaries
+             * @param enable_evictions - evict existing items in order to store new ones
+             * @param eviction_policy - how to choose the memory page to evict
+             * @param enable_admission_filter - store new item only if it's accessed more often than the items it would evict
+             * @param enable_cas - keep the CAS timestamp in every item
+             * @param compression_threshold - compress values of this length or longer (`0` - never compress)
+             * @param arena - back the storage of every shard by huge pages and / or bind it to the NUMA node
+             * @param concurrent_reads - allow do_get() to read shards without taking their locks
+             * @param background_rehash - hash tables are expanded by do_background_work() instead of the requests
+             * @note may throw exception
+             */
+            static ShardedCache Create(size_t num_shards, size_t memory_limit, size_t mem_page_size, size_t initial_dict_size, bool enable_evictions,
+                                       EvictionPolicy eviction_policy = EvictionPolicy::page_lru, bool enable_admission_filter = false,
+                                       bool enable_cas = true, size_t compression_threshold = 0, const ArenaOptions & arena = ArenaOptions(),
+                                       bool concurrent_reads = false, bool background_rehash = false);
+
+            /// move constructor
+            ShardedCache(ShardedCache &&) = default;
+
+            /// number of shards
+            size_t num_shards() const noexcept { return m_shards.size(); }
+
+            /// number of the shard responsible for the given `hash`
+            size_t shard_no(const hash_type hash) const noexcept {
+                return static_cast<size_t>(static_cast<uint64>(hash) >> m_shard_shift);
+            }
+
+            /// acquire shard by its number
+            locked_shard lock_shard(const size_t shard_no) {
+                debug_assert(shard_no < m_shards.size());
+                return locked_shard(*m_shards[shard_no]);
+            }
+
+            /// acquire shard responsible for the given `hash`
+            locked_shard lock_shard_for(const hash_type hash) {
+                return lock_shard(shard_no(hash));
+            }
+
+            /**
+             * `get` - pass the item to the `reader(ConstItemPtr item)` which must copy whatever it needs
+             *
+             * With `concurrent_reads` shard is locked only if the lock-free lookup conflicts with its writer (see Cache::do_get_concurrent())
+             * @return `true` if item was found and passed to the `reader`
+             */
+            template <typename Reader>
+            bool do_get(const slice key, const hash_type hash, Reader reader);
+
+            /**
+             * `get` of several items at once, result for the `keys[n]` is stored in the `out[n]`
+             *
+             * Keys of each shard are looked up with the Cache::do_get_batch()
+             * @return lock of every involved shard, found items are valid while it's held
+             */
+            locked_shards do_get_batch(const slice keys[], const hash_type hashes[], const size_t count, ConstItemPtr out[]);
+
+            /// `flush_all` - invalidate every item in every shard
+            void do_flush_all() noexcept;
+
+            /**
+             * Background work of the shard, see Cache::do_background_work()
+             *
+             * Shard busy with the request is skipped, background work must not delay requests
+             * @return `true` if there is more work to do (or shard was busy)
+             */
+            bool do_background_work(const size_t shard_no, const std::chrono::microseconds time_budget);
+
+            /// publish dynamic stats of the every shard and return their sum
+            stats collect_stats() noexcept;
+
+        private:
+            explicit ShardedCache(size_t num_shards, size_t memory_limit, size_t mem_page_size, size_t initial_dict_size, bool enable_evictions, EvictionPolicy eviction_policy, bool enable_admission_filter, bool enable_cas, size_t compression_threshold, const ArenaOptions & arena, bool concurrent_reads, bool background_rehash);
+
+        private:
+            std::vector<std::unique_ptr<Shard>> m_shards;
+            unsigned m_shard_shift;
+        };
+
+
+        inline ShardedCache::Shard::Shard(size_t memory_limit, size_t mem_page_size, size_t initial_dict_size, bool enable_evictions, EvictionPolicy eviction_policy, bool enable_admission_filter, bool enable_cas, size_t compression_threshold, const ArenaOptions & arena, bool concurrent_reads, bool background_rehash)
+            : lock()
+            , shard_stats()
+            , cache() {
+            // allocator and dictionary report to the shard stats from the very beginning
+            stats_scope _(shard_stats);
+            cache.reset(new Cache(Cache::Create(memory_limit, mem_page_size, initial_dict_size, enable_evictions, eviction_policy, enable_admission_filter, enable_cas, compression_threshold, arena, concurrent_reads, background_rehash)));
+        }
+
+
+        inline ShardedCache::Shard::~Shard() {
+            stats_scope _(shard_stats);
+            cache.reset();
+        }
+
+
+        inline ShardedCache ShardedCache::Create(size_t num_shards, size_t memory_limit, size_t mem_page_size, size_t initial_dict_size, bool enable_evictions, EvictionPolicy eviction_policy, bool enable_admission_filter, bool enable_cas, size_t compression_threshold, const ArenaOptions & arena, bool concurrent_reads, bool background_rehash) {
+            if (num_shards == 0 || not ispow2(num_shards)) {
+                throw std::invalid_argument("num_shards must be power of 2");
+            }
+            if (memory_limit / num_shards < mem_page_size * 4) {
+                throw std::invalid_argument("memory_limit should be enough for at least 4 pages per shard");
+            }
+            return ShardedCache(num_shards, memory_limit, mem_page_size, initial_dict_size, enable_evictions, eviction_policy, enable_admission_filter, enable_cas, compression_threshold, arena, concurrent_reads, background_rehash);
+        }
+
+
+        inline ShardedCache::ShardedCache(size_t num_shards, size_t memory_limit, size_t mem_page_size, size_t initial_dict_size, bool enable_evictions, EvictionPolicy eviction_policy, bool enable_admission_filter, bool enable_cas, size_t compression_threshold, const ArenaOptions & arena, bool concurrent_reads, bool background_rehash)
+            : m_shards()
+            , m_shard_shift(sizeof(hash_type) * 8 - log2u(num_shards)) {
+            const size_t shard_dict_size = std::max<size_t>(initial_dict_size / num_shards, 1);
+            m_shards.reserve(num_shards);
+            for (size_t n = 0; n < num_shards; ++n) {
+                m_shards.emplace_back(new Shard(memory_limit / num_shards, mem_page_size, shard_dict_size, enable_evictions, eviction_policy, enable_admission_filter, enable_cas, compression_threshold, arena, concurrent_reads, background_rehash));
+            }
+        }
+
+
+        template <typename Reader>
+        inline bool ShardedCache::do_get(const slice key, const hash_type hash, Reader reader) {
+            Shard & shard = *m_shards[shard_no(hash)];
+            if (shard.cache->concurrent_reads_enabled()) {
+                bool completed, found;
+                tie(completed, found) = shard.cache->do_get_concurrent(key, hash, reader);
+                if (completed) {
+                    return found;
+                }
+            }
+            locked_shard locked(shard);
+            ConstItemPtr item = locked->do_get(key, hash);
+            if (item != nullptr) {
+                reader(item);
+            }
+            return item != nullptr;
+        }
+
+
+        inline ShardedCache::locked_shards ShardedCache::do_get_batch(const slice keys[], const hash_type hashes[], const size_t count, ConstItemPtr out[]) {
+            locked_shards result(*this);
+            if (m_shards.size() == 1) {
+                Shard & shard = *m_shards.front();
+                result.m_locks.emplace_back(shard.lock);
+                stats_scope _(shard.shard_stats);
+                shard.cache->do_get_batch(keys, hashes, count, out);
+                return result;
+            }
+            // group keys by their shards preserving the order of keys within a shard
+            std::vector<size_t> order(count);
+            for (size_t n = 0; n < count; ++n) {
+                order[n] = n;
+            }
+            std::stable_sort(order.begin(), order.end(), [=](size_t left, size_t right) { return shard_no(hashes[left]) < shard_no(hashes[right]); });
+            std::vector<slice> shard_keys; std::vector<hash_type> shard_hashes; std::vector<ConstItemPtr> shard_out;
+            shard_keys.reserve(count); shard_hashes.reserve(count); shard_out.reserve(count);
+            size_t first = 0;
+            while (first < count) {
+                const size_t no = shard_no(hashes[order[first]]);
+                shard_keys.clear(); shard_hashes.clear();
+                size_t last = first;
+                while (last < count && shard_no(hashes[order[last]]) == no) {
+                    shard_keys.push_back(keys[order[last]]);
+                    shard_hashes.push_back(hashes[order[last]]);
+                    last += 1;
+                }
+                Shard & shard = *m_shards[no];
+                result.m_locks.emplace_back(shard.lock);
+                shard_out.resize(shard_keys.size());
+                {
+                    stats_scope _(shard.shard_stats);
+                    shard.cache->do_get_batch(shard_keys.data(), shard_hashes.data(), shard_keys.size(), shard_out.data());
+                }
+                for (size_t n = first; n < last; ++n) {
+                    out[order[n]] = shard_out[n - first];
+                }
+                first = last;
+            }
+            return result;
+        }
+
+
+        inline void ShardedCache::do_flush_all() noexcept {
+            for (size_t n = 0; n < m_shards.size(); ++n) {
+                lock_shard(n)->do_flush_all();
+            }
+        }
+
+
+        inline bool ShardedCache::do_background_work(const size_t shard_no, const std::chrono::microseconds time_budget) {
+            debug_assert(shard_no < m_shards.size());
+            Shard & shard = *m_shards[shard_no];
+            std::unique_lock<std::mutex> lock(shard.lock, std::try_to_lock);
+            if (not lock.owns_lock()) {
+                return true;
+            }
+            stats_scope _(shard.shard_stats);
+            return shard.cache->do_background_work(time_budget);
+        }
+
+
+        inline stats ShardedCache::collect_stats() noexcept {
+            stats total;
+            for (size_t n = 0; n < m_shards.size(); ++n) {
+                auto shard = lock_shard(n);
+                shard->publish_stats();
+                AggregateStats(total, m_shards[n]->shard_stats);
+            }
+            // page size is the same for every shard
+            total.mem.page_size = m_shards.front()->shard_stats.mem.page_size;
+            return total;
+        }
+
+    } // namespace cache
+
+    /// @}
+
+} // namespace cachelot
+
+#endif // CACHELOT_SHARDED_CACHE_H_INCLUDED
@@ -14,10 +14,16 @@ namespace cachelot {
 
     struct stats __stats__;
 
+    thread_local struct stats * __current_stats__ = &__stats__;
+
     #define PRINT_STAT(stat_group, stat_type, stat_name, stat_description) \
-    std::cout << CACHELOT_PP_STR(stat_group) << ':' << std::setfill('.') << std::setw(40) << std::left << CACHELOT_PP_STR(stat_name) << std::setfill(' ')  << ' ' << std::setw(14) << STAT_GET(stat_group, stat_name) << stat_description << '\n';
+    std::cout << CACHELOT_PP_STR(stat_group) << ':' << std::setfill('.') << std::setw(40) << std::left << CACHELOT_PP_STR(stat_name) << std::setfill(' ')  << ' ' << std::setw(14) << s.stat_group.stat_name << stat_description << '\n';
 
     void PrintStats() noexcept {
+        PrintStats(*__current_stats__);
+    }
+
+    void PrintStats(const stats & s) noexcept {
     // variable tracking size limit exceeded in ASAN build
     #ifndef ADDRESS_SANITIZER
         try {
@@ -39,7 +45,27 @@ namespace cachelot {
     #undef PRINT_STAT
 
     void ResetStats() noexcept {
-        new (&__stats__) stats();
+        new (__current_stats__) stats();
+    }
+
+
+    namespace {
+        inline uint64 aggregate_stat(const uint64 to, const uint64 from) noexcept { return to + from; }
+        inline bool aggregate_stat(const bool to, const bool from) noexcept { return to || from; }
+    }
+
+    void AggregateStats(stats & to, const stats & from) noexcept {
+        #define AGGREGATE_STAT(stat_group, stat_name) to.stat_group.stat_name = aggregate_stat(to.stat_group.stat_name, from.stat_group.stat_name);
+
+        #define AGGREGATE_CACHE_STAT(stat_type, stat_name, stat_description) AGGREGATE_STAT(cache, stat_name)
+        CACHE_STATS(AGGREGATE_CACHE_STAT)
+        #undef AGGREGATE_CACHE_STAT
+
+        #define AGGREGATE_MEM_STAT(stat_type, stat_name, stat_description) AGGREGATE_STAT(mem, stat_name)
+        MEMORY_STATS(AGGREGATE_MEM_STAT)
+        #undef AGGREGATE_MEM_STAT
+
+        #undef AGGREGATE_STAT
     }
 
 } // namespace cachelot
@@ -30,12 +30,18 @@ namespace cachelot {
         X(uint64, num_free_table_weak_hits, "Number of times when memory allocated from the bigger cell of free blocks table") \
         X(uint64, limit_maxbytes,           "Maximum amount of memory to use for the storage") \
         X(uint64, page_size,                "Size of allocator page (max allocation size)") \
-        X(uint64, evictions,                "Number of evicted items")
+        X(uint64, evictions,                "Number of evicted items") \
+        X(uint64, evicted_pages,            "Number of pages reused by eviction") \
+        X(uint64, hugetlb_bytes,            "Amount of memory backed by explicit huge pages (MAP_HUGETLB)") \
+        X(uint64, thp_advised_bytes,        "Amount of memory advised to be backed by transparent huge pages (MADV_HUGEPAGE)") \
+        X(bool, numa_bound,                 "Memory is bound to the NUMA node")
 
     #define CACHE_STATS(X) \
         X(uint64, cmd_get,                  "'get' commands") \
         X(uint64, get_hits,                 "'get' cache hits") \
         X(uint64, get_misses,               "'get' cache misses") \
+        X(uint64, concurrent_get_hits,      "'get' cache hits served without the lock") \
+        X(uint64, concurrent_get_misses,    "'get' cache misses served without the lock") \
         X(uint64, cmd_set,                  "'set' commands") \
         X(uint64, set_new,                  "'set' inserts ") \
         X(uint64, set_existing,             "'set' updates") \
@@ -68,6 +74,12 @@ namespace cachelot {
         X(uint64, prepend_stored,           "'prepend' updates") \
         X(uint64, prepend_misses,           "'prepend' cache misses") \
         X(uint64, cmd_flush,                "'flush_all' commands") \
+        X(uint64, admission_accepted,       "new items admitted by the TinyLFU filter at the cost of eviction") \
+        X(uint64, admission_rejected,       "new items rejected by the TinyLFU filter to preserve more frequent ones") \
+        X(uint64, compressed_values,        "values compressed on store") \
+        X(uint64, incompressible_values,    "values not compressed as it wouldn't save enough memory") \
+        X(uint64, compression_saved_bytes,  "memory saved by the value compression") \
+        X(uint64, chained_items,            "items larger than the page stored in the chain of chunks") \
         X(uint64, hash_capacity,            "capacity of the hash table") \
         X(uint64, curr_items,               "number of items in the cache") \
         X(bool, hash_is_expanding,          "hash table is expanding")
@@ -90,14 +102,24 @@ namespace cachelot {
     /// Print current stat values into stdout
     void PrintStats() noexcept;
 
+    /// Print given stat values into stdout
+    void PrintStats(const stats & s) noexcept;
+
     /// Reset all stats to their default values
     void ResetStats() noexcept;
 
+    /// Accumulate stats `from` into the `to` (counters and amounts are summed up, flags are or-ed)
+    void AggregateStats(stats & to, const stats & from) noexcept;
+
+    /// Default stats storage
     extern struct stats __stats__;
 
-    #define __STAT2(name) __stats__.name
+    /// Stats storage of the current thread (`__stats__` unless redirected by the `stats_scope`)
+    extern thread_local struct stats * __current_stats__;
+
+    #define __STAT2(name) __current_stats__->name
     #define __STAT(name) __STAT2(name)
-    #define __STATGROUP2(group, name) __stats__.group.name
+    #define __STATGROUP2(group, name) __current_stats__->group.name
     #define __STATGROUP(group, name) __STATGROUP2(group, name)
 
     #define STAT_GET(stat_group, stat_name) __STATGROUP(stat_group, stat_name)
@@ -125,6 +147,39 @@ namespace cachelot {
         }
     }
 
+    /**
+     * Redirect stats of the current thread into the given storage until the end of the scope
+     *
+     * Allows independent Cache instances (shards) to maintain their own stats,
+     * scopes must be destroyed in the reverse order of their creation
+     */
+    class stats_scope {
+    public:
+        /// constructor
+        explicit stats_scope(stats & target) noexcept
+            : m_previous(__current_stats__) {
+            __current_stats__ = &target;
+        }
+
+        /// move constructor
+        stats_scope(stats_scope && other) noexcept
+            : m_previous(other.m_previous) {
+            other.m_previous = nullptr;
+        }
+
+        /// destructor
+        ~stats_scope() {
+            if (m_previous != nullptr) {
+                __current_stats__ = m_previous;
+            }
+        }
+
+        stats_scope(const stats_scope &) = delete;
+        stats_scope & operator=(const stats_scope &) = delete;
+    private:
+        stats * m_previous;
+    };
+
     /// @}
 
 } // namespace cachelot
@@ -0,0 +1,78 @@
+#ifndef CACHELOT_NET_BACKGROUND_WORKER_H_INCLUDED
+#define CACHELOT_NET_BACKGROUND_WORKER_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+#ifndef CACHELOT_NETWORK_H_INCLUDED
+#  include <server/network.h>
+#endif
+#ifndef CACHELOT_SHARDED_CACHE_H_INCLUDED
+#  include <cachelot/sharded_cache.h>
+#endif
+
+
+namespace cachelot { namespace net {
+
+    /// time the background work may take at once, requests arrived meanwhile wait no longer than this
+    constexpr std::chrono::microseconds background_work_budget = std::chrono::microseconds(100);
+
+    /// interval between checks whether there is background work to do
+    constexpr std::chrono::milliseconds background_work_interval = std::chrono::milliseconds(10);
+
+    /**
+     * background_worker does the background work of the cache shard (see cache::ShardedCache::do_background_work())
+     *
+     * Work is done in short steps of the `background_work_budget`, while there is more work the next step is scheduled
+     * right away, so it's interleaved with the requests handled by the same reactor
+     * @ingroup net
+     */
+    class background_worker {
+    public:
+        /// constructor
+        explicit background_worker(io_service & ios, cache::ShardedCache & the_cache, const size_t shard_no)
+            : m_timer(ios)
+            , m_cache(the_cache)
+            , m_shard_no(shard_no) {
+            schedule(background_work_interval);
+        }
+
+        /// destructor
+        ~background_worker() {
+            error_code ignored;
+            m_timer.cancel(ignored);
+        }
+
+        background_worker(const background_worker &) = delete;
+        background_worker & operator= (const background_worker &) = delete;
+
+    private:
+        void schedule(const std::chrono::steady_clock::duration delay) {
+            m_timer.expires_from_now(delay);
+            m_timer.async_wait([this](const error_code error) {
+                if (not error) {
+                    bool more_work;
+                    try {
+                        more_work = m_cache.do_background_work(m_shard_no, background_work_budget);
+                    } catch (const std::bad_alloc &) {
+                        // there is no memory for the new hash table now, requests will try to expand it themselves
+                        more_work = false;
+                    }
+                    this->schedule(more_work ? std::chrono::steady_clock::duration::zero() : background_work_interval);
+                }
+            });
+        }
+
+    private:
+        asio::steady_timer m_timer;
+        cache::ShardedCache & m_cache;
+        const size_t m_shard_no;
+    };
+
+}} // namespace cachelot::net
+
+
+#endif // CACHELOT_NET_BACKGROUND_WORKER_H_INCLUDED
@@ -0,0 +1,66 @@
+#ifndef CACHELOT_NET_CLOCK_TICKER_H_INCLUDED
+#define CACHELOT_NET_CLOCK_TICKER_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+#ifndef CACHELOT_NETWORK_H_INCLUDED
+#  include <server/network.h>
+#endif
+#ifndef CACHELOT_EXPIRATION_CLOCK_H_INCLUDED
+#  include <cachelot/expiration_clock.h>
+#endif
+
+
+namespace cachelot { namespace net {
+
+    /// interval between clock updates, cached time lags behind the real one at most by this interval
+    constexpr std::chrono::milliseconds clock_tick_interval = std::chrono::milliseconds(100);
+
+    /**
+     * clock_ticker switches the cache::ExpirationClock into the cached mode and updates it by the reactor timer
+     *
+     * Clock is back in the precise mode when ticker is destroyed
+     * @ingroup net
+     */
+    class clock_ticker {
+    public:
+        /// constructor
+        explicit clock_ticker(io_service & ios)
+            : m_timer(ios) {
+            cache::ExpirationClock::set_cached(true);
+            schedule();
+        }
+
+        /// destructor
+        ~clock_ticker() {
+            cache::ExpirationClock::set_cached(false);
+            error_code ignored;
+            m_timer.cancel(ignored);
+        }
+
+        clock_ticker(const clock_ticker &) = delete;
+        clock_ticker & operator= (const clock_ticker &) = delete;
+
+    private:
+        void schedule() {
+            m_timer.expires_from_now(clock_tick_interval);
+            m_timer.async_wait([this](const error_code error) {
+                if (not error) {
+                    cache::ExpirationClock::tick();
+                    this->schedule();
+                }
+            });
+        }
+
+    private:
+        asio::steady_timer m_timer;
+    };
+
+}} // namespace cachelot::net
+
+
+#endif // CACHELOT_NET_CLOCK_TICKER_H_INCLUDED
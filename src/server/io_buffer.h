@@ -12,6 +12,8 @@
 #  include <cachelot/slice.h>
 #endif
 
+#include <functional>
+
 namespace cachelot {
 
     /// @defgroup io IO
@@ -37,10 +39,34 @@ namespace cachelot {
      * write:
      *  - get write pointer in buffer by calling begin_write() and
      *  - mark N slice as filled by calling confirm_write()
+     *
+     * external data (gather IO):
+     *  - if enabled by the buffer owner, large pieces of data may be referenced with write_external() instead of being copied
+     *  - owner sends non-read data piece by piece with for_each_non_read() and must read all of it at once
+     *  - external data is released when buffer is compacted after reading, reset or on rollback
+     *
+     * external receive (scatter IO):
+     *  - if enabled, reader may ask to place the next N bytes of the stream into its own memory with receive_external()
+     *  - owner receives them directly into the requested memory bypassing the buffer, and calls complete_external_receive()
+     *  - if the data will never come (buffer is reset or destroyed) completion is called with `false`
      */
     class io_buffer {
-        enum class internal_write_savepoint_type : size_t { __DUMMY__ };
+        struct internal_write_savepoint_type { size_t write_pos; size_t num_external; };
         enum class internal_read_savepoint_type : size_t { __DUMMY__ };
+
+        /// piece of memory outside of the buffer referenced at the `position`
+        struct external_data {
+            size_t position;
+            slice data;
+            std::function<void ()> release;
+        };
+
+        /// memory outside of the buffer to receive data into
+        struct external_receive_request {
+            char * dest;
+            size_t length;
+            std::function<void (bool)> on_received;
+        };
     public:
         typedef internal_write_savepoint_type write_savepoint_type;
         typedef internal_read_savepoint_type read_savepoint_type;
@@ -56,6 +82,8 @@ namespace cachelot {
 
         // dtor
         ~io_buffer() {
+            release_external(0);
+            cancel_external_receive();
             std::free(m_data);
         }
         // disallowed copy and aasignment
@@ -133,21 +161,85 @@ namespace cachelot {
 
         /// get the write position to be able to discard one or more writes in the future
         write_savepoint_type write_savepoint() noexcept {
-            return static_cast<write_savepoint_type>(m_write_pos);
+            return write_savepoint_type { m_write_pos, m_external.size() };
         }
 
         /// forget written data above the `savepoint`
         void rollback_write_transaction(const write_savepoint_type savepoint) noexcept {
-            debug_assert(static_cast<size_t>(savepoint) <= m_write_pos);
-            m_write_pos = static_cast<size_t>(savepoint);
+            debug_assert(savepoint.write_pos <= m_write_pos);
+            release_external(savepoint.num_external);
+            m_write_pos = savepoint.write_pos;
             debug_assert(m_write_pos >= m_read_pos);
         }
 
+        /// allow to reference external data with `write_external()`
+        void enable_external() noexcept { m_external_enabled = true; }
+
+        /// check whether external data may be referenced instead of copying
+        bool external_enabled() const noexcept { return m_external_enabled; }
+
+        /// reference `data` at the current write position instead of copying it, `release` is called when data is no longer needed
+        void write_external(const slice data, std::function<void ()> release) {
+            debug_assert(m_external_enabled);
+            m_external.push_back(external_data { m_write_pos, data, std::move(release) });
+            m_external_size += data.length();
+        }
+
+        /// request the next `length` bytes of the stream to be received directly into the `dest` memory
+        /// `on_received(true)` is called when data is there, `on_received(false)` if it will never come
+        void receive_external(char * dest, const size_t length, std::function<void (bool)> on_received) {
+            debug_assert(m_external_enabled);
+            debug_assert(non_read() == 0);
+            debug_assert(not external_receive_pending());
+            m_external_receive = external_receive_request { dest, length, std::move(on_received) };
+        }
+
+        /// check whether reader waits for the data to be received into its memory
+        bool external_receive_pending() const noexcept { return static_cast<bool>(m_external_receive.on_received); }
+
+        /// memory to receive pending external data into
+        char * external_receive_dest() const noexcept { return m_external_receive.dest; }
+
+        /// length of pending external data
+        size_t external_receive_length() const noexcept { return m_external_receive.length; }
+
+        /// notify the reader that requested data was received
+        void complete_external_receive() {
+            debug_assert(external_receive_pending());
+            auto on_received = std::move(m_external_receive.on_received);
+            m_external_receive = external_receive_request { nullptr, 0, nullptr };
+            on_received(true);
+        }
+
+        /// nuber of non-read bytes including external data
+        size_t non_read_with_external() const noexcept {
+            return non_read() + m_external_size;
+        }
+
+        /// call `fun(slice)` for every consecutive piece of non-read data including external data
+        template <typename Function>
+        void for_each_non_read(Function fun) const {
+            size_t pos = m_read_pos;
+            for (const auto & external : m_external) {
+                debug_assert(external.position >= pos);
+                if (external.position > pos) {
+                    fun(slice(m_data + pos, external.position - pos));
+                    pos = external.position;
+                }
+                fun(external.data);
+            }
+            if (m_write_pos > pos) {
+                fun(slice(m_data + pos, m_write_pos - pos));
+            }
+        }
+
         /// number of unfilled slice in buffer
         size_t available() const noexcept { return m_capacity - m_write_pos; }
 
         /// forgert reading and writing pos
         void reset() noexcept {
+            release_external(0);
+            cancel_external_receive();
             m_read_pos = 0u;
             m_write_pos = 0u;
         }
@@ -175,10 +267,13 @@ namespace cachelot {
         // discard all data that was read
         void compact() noexcept {
             if (m_read_pos == m_write_pos) {
+                // external data is read along with the buffer
+                release_external(0);
                 m_read_pos = 0u;
                 m_write_pos = 0u;
             } else {
                 debug_assert(m_read_pos < m_write_pos);
+                debug_assert(m_external.empty());
                 size_t left_unread = m_write_pos - m_read_pos;
                 std::memmove(m_data, m_data + m_read_pos, left_unread);
                 m_read_pos = 0u;
@@ -187,6 +282,24 @@ namespace cachelot {
         }
 
     private:
+        /// release external data starting from the `first`
+        void release_external(const size_t first) noexcept {
+            for (size_t n = first; n < m_external.size(); ++n) {
+                m_external_size -= m_external[n].data.length();
+                m_external[n].release();
+            }
+            m_external.erase(m_external.begin() + static_cast<std::ptrdiff_t>(std::min(first, m_external.size())), m_external.end());
+        }
+
+        /// notify the reader that requested data won't come
+        void cancel_external_receive() noexcept {
+            if (external_receive_pending()) {
+                auto on_received = std::move(m_external_receive.on_received);
+                m_external_receive = external_receive_request { nullptr, 0, nullptr };
+                on_received(false);
+            }
+        }
+
         size_t capacity_advice(size_t at_least) const noexcept {
             const size_t grow_factor = std::max(at_least, std::max(capacity() * 2 - available(), default_min_buffer_size));
             return std::min(capacity() + grow_factor, m_max_size);
@@ -198,6 +311,10 @@ namespace cachelot {
         size_t m_capacity = 0;
         size_t m_read_pos = 0;
         size_t m_write_pos = 0;
+        bool m_external_enabled = false;
+        std::vector<external_data> m_external;
+        size_t m_external_size = 0;
+        external_receive_request m_external_receive = external_receive_request { nullptr, 0, nullptr };
     };
 
     /// @}
@@ -5,13 +5,16 @@
 //  see LICENSE file
 
 #include <cachelot/common.h>
-#include <cachelot/cache.h>
+#include <cachelot/sharded_cache.h>
 #include <cachelot/stats.h>
 #include <server/settings.h>
+#include <server/clock_ticker.h>
+#include <server/background_worker.h>
 #include <server/memcached/conversation.h>
 
 #include <iostream>
 #include <boost/program_options.hpp>
+#include <boost/preprocessor/stringize.hpp>
 #include <signal.h>
 
 using std::cerr;
@@ -82,14 +85,39 @@ namespace  {
                                                     "You may specify multiple addresses separated by comma or by using -l multiple times")
             ("daemon,d",    po::bool_switch(),      "Run as a daemon")
             ("oum-error,M", po::bool_switch(),      "Return error when out of memory (rather than removing items)")
+            ("eviction",    po::value<string>(),    "How to choose memory page to evict (default: lru)\n"
+                                                    "lru - least recently used page\n"
+                                                    "value - page losing the least hits among the least recently used ones\n"
+                                                    "clock - individual items not accessed since the last CLOCK sweep\n"
+                                                    "slru - least recently used page of the probationary segment (segmented LRU)\n"
+                                                    "page-clock - next page in the round robin order, unless it was accessed since the last turn\n"
+                                                    "fifo - next page in the round robin order")
+            ("admission",   po::bool_switch(),      "Store new item only if it's requested more often than the items it would evict (TinyLFU)\n"
+                                                    "Protects frequent items from being evicted by the one-time scans")
             ("no-cas,C",    po::bool_switch(),      "Disable use of CAS (memory economy)")
+            ("compress",    po::value<size_t>(),    "Compress values of the given length in bytes or longer (LZ4, min 64)\n"
+                                                    "Lower threshold saves more memory at the cost of CPU (default: disabled)")
             ("memory,m",    po::value<po_memory>(), "Max memory to use for items storage in megabytes (must be power of 2)"
                                                     "You may specify one of the suffixes (K,M,G) to use different units"
                                                     "For instance, -m 8G means 8 Gigabytes of RAM")
             ("page,P",      po::value<po_memory>(), "Page size in megabytes (must be power of 2)"
                                                     "You may specify one of the suffixes (K,M,G) to use different units"
-                                                    "Lesser pages leads to more accurate evictions, although page size affects maximal item size")
+                                                    "Lesser pages leads to more accurate evictions, items larger than the page are stored in several pages")
+            ("max-item-size,I", po::value<po_memory>(), "Maximal item size (default: 1M or the page size if it's larger, must be power of 2)\n"
+                                                    "You may specify one of the suffixes (K,M,G) to use different units")
+            ("huge-pages",  po::bool_switch(),      "Back the items storage by huge pages (fewer TLB misses on large memory)\n"
+                                                    "Reserved huge pages are used if there are enough of them, transparent ones otherwise")
+            ("numa-node",   po::value<unsigned>(),  "Bind the items storage to the given NUMA node")
             ("hashtable,H", po::value<size_t>(),    "Initial hash table size (default 64K)")
+            ("background-rehash", po::bool_switch(), "Expand hash table ahead of time by the idle-time task of every thread\n"
+                                                    "Requests don't pay for the expansion, it takes a bit more memory")
+            ("concurrent-reads", po::bool_switch(), "Look up the keys of `get` without locking the cache shard\n"
+                                                    "Threads read hot keys in parallel, values are always copied (not compatible with --admission)")
+            ("hash",        po::value<string>(),    "Hash function of keys: fnv1a, crc32c or wyhash (default: " BOOST_PP_STRINGIZE(CACHELOT_DEFAULT_HASH) ")")
+            ("threads,t",   po::value<size_t>(),    "Number of threads to use (default: 4, must be power of 2)\n"
+                                                    "Every thread runs its own reactor, the cache is split into the same number of shards")
+            ("reuseport,R", po::bool_switch(),      "Every thread accepts TCP connections on its own SO_REUSEPORT socket and is pinned to a CPU\n"
+                                                    "Kernel spreads connections across threads, a connection stays on one thread for its whole life")
         ;
 
         po::variables_map varmap;
@@ -119,7 +147,32 @@ namespace  {
         }
         settings.net.has_unix_socket = not settings.net.unix_socket.empty();
         settings.cache.has_evictions = not varmap["oum-error"].as<bool>();
+        settings.cache.has_admission_filter = varmap["admission"].as<bool>();
+        if (varmap.count("eviction")) {
+            const string policy = varmap["eviction"].as<string>();
+            if (policy == "lru") {
+                settings.cache.eviction_policy = memalloc::eviction_policy::page_lru;
+            } else if (policy == "value") {
+                settings.cache.eviction_policy = memalloc::eviction_policy::value_aware;
+            } else if (policy == "clock") {
+                settings.cache.eviction_policy = memalloc::eviction_policy::item_clock;
+            } else if (policy == "slru") {
+                settings.cache.eviction_policy = memalloc::eviction_policy::page_slru;
+            } else if (policy == "page-clock") {
+                settings.cache.eviction_policy = memalloc::eviction_policy::page_clock;
+            } else if (policy == "fifo") {
+                settings.cache.eviction_policy = memalloc::eviction_policy::page_fifo;
+            } else {
+                throw invalid_configuration("unknown eviction policy '" + policy + "'");
+            }
+        }
         settings.cache.has_CAS = not varmap["no-cas"].as<bool>();
+        if (varmap.count("compress")) {
+            settings.cache.compression_threshold = varmap["compress"].as<size_t>();
+            if (settings.cache.compression_threshold < cache::Cache::min_compression_threshold) {
+                throw invalid_configuration("the argument for option '--compress' must be at least 64 bytes");
+            }
+        }
         if (varmap.count("memory")) {
             settings.cache.memory_limit = varmap["memory"].as<po_memory>().n;
         }
@@ -129,15 +182,58 @@ namespace  {
         if (settings.cache.memory_limit < (settings.cache.page_size * 4)) {
             throw invalid_configuration("There must be at least 4 pages");
         }
-        if (settings.cache.page_size > 2*Gigabyte) {
-            throw invalid_configuration("Maximal page size is 2Gb");
+        if (settings.cache.page_size > 1*Gigabyte) {
+            throw invalid_configuration("Maximal page size is 1Gb");
+        }
+        if (varmap.count("max-item-size")) {
+            settings.cache.max_item_size = varmap["max-item-size"].as<po_memory>().n;
+        } else {
+            settings.cache.max_item_size = std::max(settings.cache.max_item_size, settings.cache.page_size);
+        }
+        if (settings.cache.max_item_size > settings.net.max_rcv_buffer_size) {
+            throw invalid_configuration("Maximal item size is 32Mb");
+        }
+        settings.cache.has_huge_pages = varmap["huge-pages"].as<bool>();
+        if (varmap.count("numa-node")) {
+            const unsigned numa_node = varmap["numa-node"].as<unsigned>();
+            if (numa_node > static_cast<unsigned>(std::numeric_limits<int>::max())) {
+                throw invalid_configuration("the argument for option '--numa-node' is too big");
+            }
+            settings.cache.numa_node = static_cast<int>(numa_node);
         }
         if (varmap.count("hashtable")) {
             settings.cache.initial_hash_table_size = varmap["hashtable"].as<size_t>();
         }
+        settings.cache.has_background_rehash = varmap["background-rehash"].as<bool>();
+        settings.cache.has_concurrent_reads = varmap["concurrent-reads"].as<bool>();
+        if (settings.cache.has_concurrent_reads && settings.cache.has_admission_filter) {
+            throw invalid_configuration("--concurrent-reads can't be used along with --admission");
+        }
         if (not ispow2(settings.cache.initial_hash_table_size)) {
             throw invalid_configuration("the argument for option '--hashtable' must be power of 2");
         }
+        if (varmap.count("hash")) {
+            const string hash_name = varmap["hash"].as<string>();
+            if (not hash_algorithm_from_name(slice(hash_name.c_str(), hash_name.size()), settings.cache.hash_function)) {
+                throw invalid_configuration("unknown hash function '" + hash_name + "'");
+            }
+        }
+        if (varmap.count("threads")) {
+            settings.net.number_of_threads = varmap["threads"].as<size_t>();
+        }
+        if (settings.net.number_of_threads == 0 || not ispow2(settings.net.number_of_threads)) {
+            throw invalid_configuration("the argument for option '--threads' must be power of 2");
+        }
+        if (settings.cache.memory_limit / settings.net.number_of_threads < (settings.cache.page_size * 4)) {
+            throw invalid_configuration("There must be at least 4 pages per thread");
+        }
+        if (settings.cache.max_item_size > settings.cache.memory_limit / settings.net.number_of_threads / 2) {
+            throw invalid_configuration("Maximal item size must not exceed half of the memory per thread");
+        }
+        settings.net.has_reuse_port = varmap["reuseport"].as<bool>();
+        if (settings.net.has_reuse_port && not net::has_reuse_port) {
+            throw invalid_configuration("SO_REUSEPORT is not supported on this platform");
+        }
         return EXIT_SUCCESS;
     }
 }
@@ -148,26 +244,59 @@ int main(int argc, char * argv[]) {
         if (parse_cmdline(argc, argv) != 0) {
             return EXIT_FAILURE;
         }
-        // Cache Service
-        auto the_cache = cache::Cache::Create(settings.cache.memory_limit,
-                                              settings.cache.page_size,
-                                              settings.cache.initial_hash_table_size,
-                                              settings.cache.has_evictions);
-        // Reactor service
-        net::io_service reactor;
+        // hash function must be chosen before any key is hashed
+        cache::HashFunction::select(settings.cache.hash_function);
+        // Cache Service (one shard per thread)
+        cache::ArenaOptions arena;
+        arena.huge_pages = settings.cache.has_huge_pages;
+        arena.numa_node = settings.cache.numa_node;
+        auto the_cache = cache::ShardedCache::Create(settings.net.number_of_threads,
+                                                     settings.cache.memory_limit,
+                                                     settings.cache.page_size,
+                                                     settings.cache.initial_hash_table_size,
+                                                     settings.cache.has_evictions,
+                                                     settings.cache.eviction_policy,
+                                                     settings.cache.has_admission_filter,
+                                                     settings.cache.has_CAS,
+                                                     settings.cache.compression_threshold,
+                                                     arena,
+                                                     settings.cache.has_concurrent_reads,
+                                                     settings.cache.has_background_rehash);
+        // Reactor service (one reactor per thread)
+        net::reactor_pool reactors(settings.net.number_of_threads, settings.net.has_reuse_port);
+        auto & reactor = reactors.main();
+
+        // expiration time is read from the clock updated by the main reactor
+        net::clock_ticker expiration_clock(reactor);
+
+        // every reactor expands the hash table of its shard when it's idle
+        std::vector<std::unique_ptr<net::background_worker>> background_workers;
+        if (settings.cache.has_background_rehash) {
+            for (size_t n = 0; n < reactors.size(); ++n) {
+                background_workers.emplace_back(new net::background_worker(reactors.at(n), the_cache, n));
+            }
+        }
 
         // TCP
-        std::unique_ptr<memcached::TcpServer> memcached_tcp = nullptr;
+        std::vector<std::unique_ptr<memcached::TcpServer>> memcached_tcp;
         if (settings.net.has_TCP) {
-            memcached_tcp.reset(new memcached::TcpServer(the_cache, reactor));
             net::tcp::endpoint bind_addr(net::ip::address_v4::any(), settings.net.TCP_port);
-            memcached_tcp->start(bind_addr);
+            if (settings.net.has_reuse_port) {
+                // acceptor per reactor
+                for (size_t n = 0; n < reactors.size(); ++n) {
+                    memcached_tcp.emplace_back(new memcached::TcpServer(the_cache, reactors.at(n)));
+                    memcached_tcp.back()->start(bind_addr, settings.net.has_reuse_port);
+                }
+            } else {
+                memcached_tcp.emplace_back(new memcached::TcpServer(the_cache, reactors));
+                memcached_tcp.back()->start(bind_addr);
+            }
         }
 
         // Unix local socket
         std::unique_ptr<memcached::UnixSocketServer> memcached_unix_socket = nullptr;
         if (settings.net.has_unix_socket) {
-            memcached_unix_socket.reset(new memcached::UnixSocketServer(the_cache, reactor));
+            memcached_unix_socket.reset(new memcached::UnixSocketServer(the_cache, reactors));
             memcached_unix_socket->start(settings.net.unix_socket);
         }
 
@@ -185,21 +314,19 @@ int main(int argc, char * argv[]) {
         signals.add(SIGINT);
         signals.add(SIGQUIT);
         signals.add(SIGUSR1);
-        signals.async_wait([&reactor](const error_code& error, int signal_number) {
+        signals.async_wait([&reactors, &the_cache](const error_code& error, int signal_number) {
             if (error) { return; }
             switch (signal_number) {
             case SIGUSR1:
-                PrintStats();
+                PrintStats(the_cache.collect_stats());
                 break;
             default:
-                reactor.stop();
+                reactors.stop();
             }
         });
 
-        // Run reactor loop
-        do {
-            reactor.run();
-        } while (not reactor.stopped());
+        // Run reactor loops
+        reactors.run();
 
 
         return EXIT_SUCCESS;
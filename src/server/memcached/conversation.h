@@ -12,6 +12,7 @@
 #include <server/memcached/memcached.h>
 #include <server/socket_stream.h>
 #include <server/socket_datagram.h>
+#include <server/reactor_pool.h>
 
 namespace cachelot {
 
@@ -26,7 +27,7 @@ namespace cachelot {
             typedef net::stream_connection<SocketType, StreamSocketConversation<SocketType>> super;
         public:
             /// constructor
-            explicit StreamSocketConversation(cache::Cache & the_cache, net::io_service & io_svc, const size_t rcvbuf_max, const size_t sndbuf_max)
+            explicit StreamSocketConversation(cache::ShardedCache & the_cache, net::io_service & io_svc, const size_t rcvbuf_max, const size_t sndbuf_max)
                 : super(io_svc, rcvbuf_max, sndbuf_max)
                 , cache_api(the_cache) {
             }
@@ -42,7 +43,7 @@ namespace cachelot {
                 }
             }
         private:
-            cache::Cache & cache_api;
+            cache::ShardedCache & cache_api;
         };
 
 
@@ -52,18 +53,29 @@ namespace cachelot {
             typedef net::stream_server<StreamSocketType, StreamServer<StreamSocketType>> super;
             typedef StreamSocketConversation<StreamSocketType> ConversationType;
         public:
-            explicit StreamServer(cache::Cache & the_cache, net::io_service & io_svc)
-                : super(io_svc)
-                , cache_api(the_cache) {
+            /// Connections are accepted by the main reactor and distributed among all reactors of the pool
+            explicit StreamServer(cache::ShardedCache & the_cache, net::reactor_pool & reactors)
+                : super(reactors.main())
+                , cache_api(the_cache)
+                , m_reactors(&reactors) {
+            }
+
+            /// Connections are accepted and served by the single given reactor
+            explicit StreamServer(cache::ShardedCache & the_cache, net::io_service & reactor)
+                : super(reactor)
+                , cache_api(the_cache)
+                , m_reactors(nullptr) {
             }
 
             std::shared_ptr<ConversationType> new_conversation() {
-                auto new_conv = new ConversationType(cache_api, super::get_io_service(), settings.net.max_rcv_buffer_size, settings.net.max_snd_buffer_size);
+                auto & reactor = m_reactors != nullptr ? m_reactors->next() : super::get_io_service();
+                auto new_conv = new ConversationType(cache_api, reactor, settings.net.max_rcv_buffer_size, settings.net.max_snd_buffer_size);
                 return std::shared_ptr<ConversationType>(new_conv);
             }
 
         private:
-            cache::Cache & cache_api;
+            cache::ShardedCache & cache_api;
+            net::reactor_pool * m_reactors;
         };
 
 
@@ -75,7 +87,7 @@ namespace cachelot {
         class UdpServer : public net::datagram_server<net::udp::socket> {
             typedef net::datagram_server<net::udp::socket> super;
         public:
-            explicit UdpServer(cache::Cache & the_cache, net::io_service & io_svc)
+            explicit UdpServer(cache::ShardedCache & the_cache, net::io_service & io_svc)
                 : super(io_svc)
                 , cache_api(the_cache) {
             }
@@ -124,7 +136,7 @@ namespace cachelot {
             }
 
         private:
-            cache::Cache & cache_api;
+            cache::ShardedCache & cache_api;
         };
 
     } // namespace memcached
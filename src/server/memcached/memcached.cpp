@@ -7,16 +7,34 @@ namespace cachelot {
 
     namespace memcached {
 
-        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api) {
-            if (recv_buf.non_read() > 0) {
+        /// Replies to the pipelined requests are flushed when they exceed this size, remaining requests are processed after the send
+        constexpr size_t max_pending_reply_size = 1 * Megabyte;
+
+
+        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::ShardedCache & cache_api) {
+            auto reply = net::READ_MORE;
+            // process every complete request in the buffer, replies are accumulated to be sent at once
+            while (recv_buf.non_read() > 0 && send_buf.non_read_with_external() < max_pending_reply_size) {
+                const size_t non_read_before = recv_buf.non_read();
+                net::ConversationReply request_reply;
                 if (static_cast<decltype(binary::MAGIC)>(*recv_buf.begin_read()) == binary::MAGIC) {
-                    return binary::handle_received_data(recv_buf, send_buf, cache_api);
+                    request_reply = binary::handle_received_data(recv_buf, send_buf, cache_api);
                 } else {
-                    return ascii::handle_received_data(recv_buf, send_buf, cache_api);
+                    request_reply = ascii::handle_received_data(recv_buf, send_buf, cache_api);
+                }
+                if (request_reply == net::CLOSE_IMMEDIATELY || request_reply == net::SEND_REPLY_AND_CLOSE) {
+                    // replies to the preceding pipelined requests must reach the client before the connection is closed
+                    return send_buf.non_read_with_external() > 0 ? net::SEND_REPLY_AND_CLOSE : net::CLOSE_IMMEDIATELY;
+                }
+                if (request_reply == net::SEND_REPLY_AND_READ) {
+                    reply = net::SEND_REPLY_AND_READ;
+                }
+                if (recv_buf.non_read() == non_read_before) {
+                    // incomplete request, wait for more data
+                    break;
                 }
-            } else {
-                return net::ConversationReply::READ_MORE;
             }
+            return reply;
         }
 
     } // namespace memcached
@@ -17,8 +17,8 @@
 #ifndef CACHELOT_IO_BUFFER_H_INCLUDED
 #  include <server/io_buffer.h>
 #endif
-#ifndef CACHELOT_CACHE_H_INCLUDED
-#  include <cachelot/cache.h>
+#ifndef CACHELOT_SHARDED_CACHE_H_INCLUDED
+#  include <cachelot/sharded_cache.h>
 #endif
 #ifndef CACHELOT_SETTINGS_H_INCLUDED
 #  include <server/settings.h>
@@ -38,8 +38,54 @@ namespace cachelot {
     /// @{
     namespace memcached {
 
+        /// Values of this size or bigger are sent directly from the cache memory instead of being copied into the send buffer
+        constexpr size_t zero_copy_min_value_length = 4 * Kilobyte;
+
+        /// Values of this size or bigger are received directly into the new item instead of being buffered (when not received at once)
+        constexpr size_t direct_receive_min_value_length = 64 * Kilobyte;
+
         /// Process every received packet
-        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api);
+        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::ShardedCache & cache_api);
+
+        /// Copy value of the `item` into the `send_buf`
+        /// It's the only option for the lock-free reader (see ShardedCache::do_get()), item can't be pinned without the shard lock
+        inline void copy_value(io_buffer & send_buf, cache::ConstItemPtr item) {
+            if (item->is_compressed()) {
+                // clients are unaware of compression
+                auto dest = send_buf.begin_write(item->uncompressed_length());
+                item->uncompress_value(dest);
+                send_buf.confirm_write(item->uncompressed_length());
+                return;
+            }
+            item->foreach_value_piece([&send_buf](const slice piece) {
+                auto dest = send_buf.begin_write(piece.length());
+                std::memcpy(dest, piece.begin(), piece.length());
+                send_buf.confirm_write(piece.length());
+            });
+        }
+
+        /// Write value of the retrieved `item` into the `send_buf`
+        /// Large values are not copied if the `send_buf` allows it, instead the item is pinned in its (locked) `shard` until the value is sent
+        /// (chunks of the chained value are referenced one by one and sent at once by the gather IO)
+        inline void write_value(io_buffer & send_buf, cache::ConstItemPtr item, cache::Cache & shard, cache::ShardedCache & cache_api) {
+            if (not item->is_compressed() && send_buf.external_enabled() && item->uncompressed_length() >= zero_copy_min_value_length) {
+                const char * last_piece = nullptr;
+                item->foreach_value_piece([&last_piece](const slice piece) { last_piece = piece.begin(); });
+                item->foreach_value_piece([&](const slice piece) {
+                    // external data is released all at once, so the last piece unpins the whole item
+                    if (piece.begin() != last_piece) {
+                        send_buf.write_external(piece, []() {});
+                    } else {
+                        send_buf.write_external(piece, [&cache_api, item]() {
+                            cache_api.lock_shard_for(item->hash())->unpin_item(item);
+                        });
+                    }
+                });
+                shard.pin_item(item);
+            } else {
+                copy_value(send_buf, item);
+            }
+        }
 
         /// validate the Item key
         inline void validate_key(const slice key) {
@@ -21,28 +21,34 @@ namespace cachelot {
         constexpr slice SERVER_ERROR = slice::from_literal("SERVER_ERROR"); ///< internal server error
 
         /// Handle on of the `get` `gets` commands
-        net::ConversationReply handle_retrieval_command(Command cmd, slice args, io_buffer & send_buf, cache::Cache & cache_api);
+        net::ConversationReply handle_retrieval_command(Command cmd, slice args, io_buffer & send_buf, cache::ShardedCache & cache_api);
 
         /// Handle on of the: `add`, `set`, `replace`, `cas`, `append`, `prepend` commands
-        net::ConversationReply handle_storage_command(Command cmd, slice args, io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api);
+        net::ConversationReply handle_storage_command(Command cmd, slice args, io_buffer & recv_buf, io_buffer & send_buf, cache::ShardedCache & cache_api);
+
+        /// Receive the rest of large value directly into the `new_item` memory and then execute the storage command
+        net::ConversationReply receive_value_directly(Command cmd, cache::ItemPtr new_item, cache::timestamp_type cas_unique, bool noreply, io_buffer & recv_buf, io_buffer & send_buf, cache::ShardedCache & cache_api);
+
+        /// Store the `new_item` with one of the: `set`, `add`, `replace`, `cas`, `append`, `prepend` commands
+        net::ConversationReply execute_storage_command(Command cmd, cache::ItemPtr new_item, cache::timestamp_type cas_unique, bool noreply, io_buffer & send_buf, cache::ShardedCache::locked_shard & shard);
 
         /// Handle the `delete` command
-        net::ConversationReply handle_delete_command(Command cmd, slice args, io_buffer & send_buf, cache::Cache & cache_api);
+        net::ConversationReply handle_delete_command(Command cmd, slice args, io_buffer & send_buf, cache::ShardedCache & cache_api);
 
         /// Handle on of the: `incr` `decr` commands
-        net::ConversationReply handle_arithmetic_command(Command cmd, slice args, io_buffer & send_buf, cache::Cache & cache_api);
+        net::ConversationReply handle_arithmetic_command(Command cmd, slice args, io_buffer & send_buf, cache::ShardedCache & cache_api);
 
         /// Handle the `touch` command
-        net::ConversationReply handle_touch_command(Command cmd, slice args, io_buffer & send_buf, cache::Cache & cache_api);
+        net::ConversationReply handle_touch_command(Command cmd, slice args, io_buffer & send_buf, cache::ShardedCache & cache_api);
 
         /// Handle the `stats` command
-        net::ConversationReply handle_statistics_command(Command cmd, slice args, io_buffer & send_buf, cache::Cache & cache_api);
+        net::ConversationReply handle_statistics_command(Command cmd, slice args, io_buffer & send_buf, cache::ShardedCache & cache_api);
 
         /// Handle the `version` command
-        net::ConversationReply handle_version_command(Command cmd, slice args, io_buffer & send_buf, cache::Cache & cache_api);
+        net::ConversationReply handle_version_command(Command cmd, slice args, io_buffer & send_buf, cache::ShardedCache & cache_api);
 
         /// Handle the `flush` command
-        net::ConversationReply handle_flush_all_command(Command cmd, slice args, io_buffer & send_buf, cache::Cache & cache_api);
+        net::ConversationReply handle_flush_all_command(Command cmd, slice args, io_buffer & send_buf, cache::ShardedCache & cache_api);
 
         /// Write one of the cache responses if `noreply` is not specified, none otherwise
         net::ConversationReply reply_with_response(io_buffer & send_buf, Response response, bool noreply);
@@ -121,7 +127,7 @@ namespace cachelot {
         #undef __DO_SERIALIZE_INTEGER_ASCII
 
 
-        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api) noexcept {
+        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::ShardedCache & cache_api) noexcept {
             auto r_savepoint = recv_buf.read_savepoint();
             auto w_savepoint = send_buf.write_savepoint();
             try {
@@ -247,24 +253,54 @@ namespace cachelot {
         }
 
 
-        inline net::ConversationReply handle_retrieval_command(Command cmd, slice args, io_buffer & send_buf, cache::Cache & cache_api) {
+        inline net::ConversationReply handle_retrieval_command(Command cmd, slice args, io_buffer & send_buf, cache::ShardedCache & cache_api) {
+            // items have no CAS timestamp to report
+            if (cmd == Command::GETS && not settings.cache.has_CAS) {
+                throw system_error(error::not_implemented);
+            }
+            // keys are looked up all at once to overlap their memory latency
+            static thread_local std::vector<slice> keys;
+            static thread_local std::vector<cache::hash_type> hashes;
+            static thread_local std::vector<cache::ConstItemPtr> items;
+            keys.clear(); hashes.clear();
             do {
                 slice key; tie(key, args) = parse_key(args);
-                auto i = cache_api.do_get(key, calc_hash(key));
-                if (i) {
-                    send_buf << VALUE << SPACE << i->key() << SPACE << i->opaque_flags() << SPACE << static_cast<uint32>(i->value().length());
-                    if (cmd == Command::GETS) {
-                        send_buf << SPACE << i->timestamp();
+                keys.push_back(key);
+                hashes.push_back(calc_hash(key));
+            } while (not args.empty());
+            const auto write_value_header = [cmd, &send_buf](cache::ConstItemPtr i) {
+                send_buf << VALUE << SPACE << i->key() << SPACE << i->opaque_flags() << SPACE << i->uncompressed_length();
+                if (cmd == Command::GETS) {
+                    send_buf << SPACE << i->timestamp();
+                }
+                send_buf << CRLF;
+            };
+            if (settings.cache.has_concurrent_reads) {
+                // shards aren't locked, item may be removed right after the lookup, so its value is copied
+                for (size_t n = 0; n < keys.size(); ++n) {
+                    cache_api.do_get(keys[n], hashes[n], [&](cache::ConstItemPtr i) {
+                        write_value_header(i);
+                        copy_value(send_buf, i);
+                        send_buf << CRLF;
+                    });
+                }
+            } else {
+                items.resize(keys.size());
+                auto shards = cache_api.do_get_batch(keys.data(), hashes.data(), keys.size(), items.data());
+                for (const auto i : items) {
+                    if (i) {
+                        write_value_header(i);
+                        write_value(send_buf, i, shards.cache_for(i->hash()), cache_api);
+                        send_buf << CRLF;
                     }
-                    send_buf << CRLF << i->value() << CRLF;
                 }
-            } while (not args.empty());
+            }
             send_buf << END << CRLF;
             return net::SEND_REPLY_AND_READ;
         }
 
 
-        inline net::ConversationReply handle_storage_command(Command cmd, slice args, io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api) {
+        inline net::ConversationReply handle_storage_command(Command cmd, slice args, io_buffer & recv_buf, io_buffer & send_buf, cache::ShardedCache & cache_api) {
             slice key; tie(key, args) = parse_key(args);
             slice parsed;
             tie(parsed, args) = args.split(SPACE);
@@ -273,7 +309,7 @@ namespace cachelot {
             auto keep_alive_duration = cache::seconds(str_to_int<cache::seconds::rep>(parsed.begin(), parsed.end()));
             tie(parsed, args) = args.split(SPACE);
             uint32 datalen = str_to_int<uint32>(parsed.begin(), parsed.end());
-            if (datalen > settings.cache.page_size) {
+            if (datalen > settings.cache.max_item_size) {
                 throw system_error(error::value_length);
             }
             cache::timestamp_type cas_unique = 0;
@@ -282,8 +318,30 @@ namespace cachelot {
                 cas_unique = str_to_int<cache::timestamp_type>(parsed.begin(), parsed.end());
             }
             bool noreply = maybe_noreply(args);
+            const auto hash = calc_hash(key);
+            // rejected command must consume its value too, it's done by the buffered path
+            const bool supported = cmd != Command::CAS || settings.cache.has_CAS;
             // read <value>\r\n
             if (recv_buf.non_read() < datalen + CRLF.length()) {
+                if (supported && recv_buf.external_enabled() && datalen >= direct_receive_min_value_length) {
+                    // don't buffer large value, receive it directly into the new item
+                    cache::ItemPtr new_item = nullptr;
+                    try {
+                        auto shard = cache_api.lock_shard_for(hash);
+                        // chained item has no contiguous memory to receive into
+                        if (not shard->is_chained_item(key, datalen + CRLF.length(), flags, keep_alive_duration)) {
+                            // item holds trailing \r\n until the value is received
+                            // it's not in the cache meanwhile, so it's pinned to survive eviction
+                            new_item = shard->create_item(key, hash, datalen + CRLF.length(), flags, keep_alive_duration);
+                            shard->pin_item(new_item);
+                        }
+                    } catch (const system_error &) {
+                        // let the buffered path report an error when whole value is there
+                    }
+                    if (new_item != nullptr) {
+                        return receive_value_directly(cmd, new_item, cas_unique, noreply, recv_buf, send_buf, cache_api);
+                    }
+                }
                 // help buffer to grow up to the necessary size
                 recv_buf.ensure_capacity(datalen + CRLF.length() - recv_buf.non_read());
                 throw system_error(error::incomplete_request);
@@ -295,72 +353,126 @@ namespace cachelot {
             } else {
                 throw system_error(error::value_crlf_expected);
             }
+            // value is consumed, so the next command is parsed correctly after the error
+            if (not supported) {
+                throw system_error(error::not_implemented);
+            }
             // create new item and execute the cache API
-            auto new_item = cache_api.create_item(key, calc_hash(key), value.length(), flags, keep_alive_duration);
-            new_item->assign_value(value);
+            auto shard = cache_api.lock_shard_for(hash);
+            cache::ItemPtr new_item = nullptr;
             try {
-                auto response = Response::NOT_A_RESPONSE;
-                bool found = false; bool stored = false;
-                switch (cmd) {
-                case Command::SET:
-                    cache_api.do_set(new_item);
-                    response = Response::STORED;
-                    break;
-                case Command::ADD:
-                    found = cache_api.do_add(new_item);
-                    response = found ? Response::STORED : Response::NOT_STORED;
-                    break;
-                case Command::REPLACE:
-                    found = cache_api.do_replace(new_item);
-                    response = found ? Response::STORED : Response::NOT_STORED;
-                    break;
-                case Command::CAS:
-                    tie(found, stored) = cache_api.do_cas(new_item, cas_unique);
-                    if (found) {
-                        response = stored ? Response::STORED : Response::EXISTS;
+                new_item = shard->create_item(key, hash, value, flags, keep_alive_duration);
+            } catch (const system_error & syserr) {
+                if (syserr.code() != error::not_admitted) {
+                    throw;
+                }
+                // key is not in the cache, reply as if the item was stored and evicted right away
+                const bool stores_new_key = cmd == Command::SET || cmd == Command::ADD;
+                const auto response = stores_new_key ? Response::STORED : (cmd == Command::CAS ? Response::NOT_FOUND : Response::NOT_STORED);
+                return reply_with_response(send_buf, response, noreply);
+            }
+            return execute_storage_command(cmd, new_item, cas_unique, noreply, send_buf, shard);
+        }
+
+
+        inline net::ConversationReply receive_value_directly(Command cmd, cache::ItemPtr new_item, cache::timestamp_type cas_unique, bool noreply, io_buffer & recv_buf, io_buffer & send_buf, cache::ShardedCache & cache_api) {
+            // beginning of the value is already received
+            const slice received = recv_buf.read_all();
+            std::memcpy(new_item->value_buffer(), received.begin(), received.length());
+            const size_t value_length = new_item->value().length();
+            recv_buf.receive_external(new_item->value_buffer() + received.length(), value_length - received.length(),
+                [=, &send_buf, &cache_api](const bool value_received) {
+                    auto shard = cache_api.lock_shard_for(new_item->hash());
+                    if (value_received) {
+                        auto w_savepoint = send_buf.write_savepoint();
+                        try {
+                            if (not new_item->value().endswith(CRLF)) {
+                                shard->destroy_item(new_item);
+                                throw system_error(error::value_crlf_expected);
+                            }
+                            new_item->truncate_value(static_cast<uint32>(value_length - CRLF.length()));
+                            execute_storage_command(cmd, new_item, cas_unique, noreply, send_buf, shard);
+                        } catch (const system_error & syserr) {
+                            send_buf.rollback_write_transaction(w_savepoint);
+                            const bool client_fault = syserr.code().category() == get_protocol_error_category();
+                            send_buf << (client_fault ? CLIENT_ERROR : SERVER_ERROR) << SPACE << syserr.code().message() << CRLF;
+                        } catch (const std::exception & exc) {
+                            send_buf.rollback_write_transaction(w_savepoint);
+                            send_buf << SERVER_ERROR << SPACE << exc.what() << CRLF;
+                        }
                     } else {
-                        response = Response::NOT_FOUND;
+                        // connection is gone
+                        shard->destroy_item(new_item);
                     }
-                    break;
-                case Command::APPEND:
-                    found = cache_api.do_append(new_item);
-                    response = found ? Response::STORED : Response::NOT_STORED;
-                    break;
-                case Command::PREPEND:
-                    found = cache_api.do_prepend(new_item);
-                    response = found ? Response::STORED : Response::NOT_STORED;
-                    break;
-                default:
-                    debug_assert(false);
-                    throw system_error(error::unknown_error);
+                    // item is either in the cache or destroyed, free it in the latter case
+                    shard->unpin_item(new_item);
+                });
+            return net::READ_MORE;
+        }
+
+
+        inline net::ConversationReply execute_storage_command(Command cmd, cache::ItemPtr new_item, cache::timestamp_type cas_unique, bool noreply, io_buffer & send_buf, cache::ShardedCache::locked_shard & shard) {
+            auto response = Response::NOT_A_RESPONSE;
+            bool found = false; bool stored = false;
+            switch (cmd) {
+            case Command::SET:
+                shard->do_set(new_item);
+                response = Response::STORED;
+                break;
+            case Command::ADD:
+                found = shard->do_add(new_item);
+                response = found ? Response::STORED : Response::NOT_STORED;
+                break;
+            case Command::REPLACE:
+                found = shard->do_replace(new_item);
+                response = found ? Response::STORED : Response::NOT_STORED;
+                break;
+            case Command::CAS:
+                tie(found, stored) = shard->do_cas(new_item, cas_unique);
+                if (found) {
+                    response = stored ? Response::STORED : Response::EXISTS;
+                } else {
+                    response = Response::NOT_FOUND;
                 }
-                return reply_with_response(send_buf, response, noreply);
-            } catch (...) {
-                throw;
+                break;
+            case Command::APPEND:
+                found = shard->do_append(new_item);
+                response = found ? Response::STORED : Response::NOT_STORED;
+                break;
+            case Command::PREPEND:
+                found = shard->do_prepend(new_item);
+                response = found ? Response::STORED : Response::NOT_STORED;
+                break;
+            default:
+                debug_assert(false);
+                throw system_error(error::unknown_error);
             }
+            return reply_with_response(send_buf, response, noreply);
         }
 
 
-        inline net::ConversationReply handle_delete_command(Command, slice args, io_buffer & send_buf, cache::Cache & cache_api) {
+        inline net::ConversationReply handle_delete_command(Command, slice args, io_buffer & send_buf, cache::ShardedCache & cache_api) {
             slice key; tie(key, args) = parse_key(args);
             bool noreply = maybe_noreply(args);
-            bool found = cache_api.do_delete(key, calc_hash(key));
+            const auto hash = calc_hash(key);
+            bool found = cache_api.lock_shard_for(hash)->do_delete(key, hash);
             auto response = found ? Response::DELETED : Response::NOT_FOUND;
             return reply_with_response(send_buf, response, noreply);
         }
 
 
-        inline net::ConversationReply handle_arithmetic_command(Command cmd, slice args, io_buffer & send_buf, cache::Cache & cache_api) {
+        inline net::ConversationReply handle_arithmetic_command(Command cmd, slice args, io_buffer & send_buf, cache::ShardedCache & cache_api) {
             slice key; tie(key, args) = parse_key(args);
             slice parsed;
             tie(parsed, args) = args.split(SPACE);
             auto delta = str_to_int<uint64>(parsed.begin(), parsed.end());
             bool noreply = maybe_noreply(args);
             bool found; uint64 new_value;
+            const auto hash = calc_hash(key);
             if (cmd == Command::INCR) {
-                tie(found, new_value) = cache_api.do_incr(key, calc_hash(key), delta);
+                tie(found, new_value) = cache_api.lock_shard_for(hash)->do_incr(key, hash, delta);
             } else {
-                tie(found, new_value) = cache_api.do_decr(key, calc_hash(key), delta);
+                tie(found, new_value) = cache_api.lock_shard_for(hash)->do_decr(key, hash, delta);
             }
             if (noreply) {
                 return net::READ_MORE;
@@ -374,25 +486,26 @@ namespace cachelot {
         }
 
 
-        inline net::ConversationReply handle_touch_command(Command, slice args, io_buffer & send_buf, cache::Cache & cache_api) {
+        inline net::ConversationReply handle_touch_command(Command, slice args, io_buffer & send_buf, cache::ShardedCache & cache_api) {
             slice key; tie(key, args) = parse_key(args);
             slice parsed;
             tie(parsed, args) = args.split(SPACE);
             cache::seconds keep_alive_duration(str_to_int<cache::seconds::rep>(parsed.begin(), parsed.end()));
             bool noreply = maybe_noreply(args);
-            bool found = cache_api.do_touch(key, calc_hash(key), keep_alive_duration);
+            const auto hash = calc_hash(key);
+            bool found = cache_api.lock_shard_for(hash)->do_touch(key, hash, keep_alive_duration);
             auto response = found ? Response::TOUCHED : Response::NOT_FOUND;
             return reply_with_response(send_buf, response, noreply);
         }
 
 
-        inline net::ConversationReply handle_statistics_command(Command, slice args, io_buffer & send_buf, cache::Cache & cache_api) {
+        inline net::ConversationReply handle_statistics_command(Command, slice args, io_buffer & send_buf, cache::ShardedCache & cache_api) {
             if (not args.empty()) {
                 throw system_error(error::not_implemented);
             }
-            cache_api.publish_stats();
+            const auto totals = cache_api.collect_stats();
             #define SERIALIZE_STAT(stat_group, stat_type, stat_name, stat_description) \
-                send_buf << STAT << SPACE << slice::from_literal(CACHELOT_PP_STR(stat_name)) << SPACE << STAT_GET(stat_group, stat_name) << CRLF;
+                send_buf << STAT << SPACE << slice::from_literal(CACHELOT_PP_STR(stat_name)) << SPACE << totals.stat_group.stat_name << CRLF;
 
             #define SERIALIZE_CACHE_STAT(typ, name, desc) SERIALIZE_STAT(cache, typ, name, desc)
             CACHE_STATS(SERIALIZE_CACHE_STAT)
@@ -408,7 +521,7 @@ namespace cachelot {
         }
 
 
-        inline net::ConversationReply handle_version_command(Command, slice args, io_buffer & send_buf, cache::Cache &) {
+        inline net::ConversationReply handle_version_command(Command, slice args, io_buffer & send_buf, cache::ShardedCache &) {
             if (not args.empty()) {
                 throw system_error(error::crlf_expected);
             }
@@ -417,7 +530,7 @@ namespace cachelot {
         }
 
 
-        inline net::ConversationReply handle_flush_all_command(Command, slice args, io_buffer & send_buf, cache::Cache & cache_api) {
+        inline net::ConversationReply handle_flush_all_command(Command, slice args, io_buffer & send_buf, cache::ShardedCache & cache_api) {
             bool noreply = maybe_noreply(args);
             cache_api.do_flush_all();
             if (noreply) {
@@ -18,7 +18,7 @@ namespace cachelot { namespace memcached {
     namespace ascii {
 
         /// Main function that process ascii protocol packets
-        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api) noexcept;
+        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::ShardedCache & cache_api) noexcept;
 
     } // namespace ascii
 
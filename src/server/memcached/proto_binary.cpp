@@ -8,15 +8,549 @@ namespace cachelot {
 
         const uint8 MAGIC = PROTOCOL_BINARY_REQ;
 
+        /// Size of the request / response packet header
+        constexpr size_t HEADER_LENGTH = sizeof(protocol_binary_request_header);
 
-        /// Main function that process binary protocol packets
-        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api) {
-            // suppress warning about the unused wariables in Release builds
-            (void)recv_buf; (void)send_buf; (void)cache_api;
-            throw system_error(cachelot::error::not_implemented);
+        /// `incr` / `decr` expiration value that prohibits creation of the missing counter
+        constexpr uint32 DONT_CREATE_COUNTER = 0xFFFFFFFF;
+
+        /// Request packet with the header converted to the host byte order
+        struct Request {
+            uint8 opcode;
+            uint32 opaque;
+            uint64 cas;
+            slice extras;
+            slice key;
+            slice value;
+        };
+
+        /// Read unsigned integer stored in the network byte order
+        template <typename UIntType>
+        inline UIntType read_uint(const char * at) noexcept {
+            UIntType result = 0;
+            for (size_t i = 0; i < sizeof(UIntType); ++i) {
+                result = static_cast<UIntType>((result << 8) | static_cast<uint8>(at[i]));
+            }
+            return result;
+        }
+
+        /// Write unsigned integer in the network byte order
+        template <typename UIntType>
+        inline void write_uint(char * at, UIntType x) noexcept {
+            for (size_t i = sizeof(UIntType); i > 0; --i) {
+                at[i - 1] = static_cast<char>(x & 0xFF);
+                x = static_cast<UIntType>(x >> 8);
+            }
+        }
+
+        /// Commands that don't reply on success (`getq` family doesn't reply on miss)
+        bool is_quiet(uint8 opcode) noexcept;
+
+        /// Handle one of the: `get`, `getq`, `getk`, `getkq`, `gat`, `gatq`, `gatk`, `gatkq` commands
+        net::ConversationReply handle_retrieval_command(const Request & req, io_buffer & send_buf, cache::ShardedCache & cache_api);
+
+        /// Handle one of the: `set`, `add`, `replace` commands and their quiet versions
+        net::ConversationReply handle_storage_command(const Request & req, io_buffer & send_buf, cache::ShardedCache & cache_api);
+
+        /// Handle one of the: `append`, `prepend` commands and their quiet versions
+        net::ConversationReply handle_extend_command(const Request & req, io_buffer & send_buf, cache::ShardedCache & cache_api);
+
+        /// Handle the `delete` command
+        net::ConversationReply handle_delete_command(const Request & req, io_buffer & send_buf, cache::ShardedCache & cache_api);
+
+        /// Handle one of the: `increment` `decrement` commands
+        net::ConversationReply handle_arithmetic_command(const Request & req, io_buffer & send_buf, cache::ShardedCache & cache_api);
+
+        /// Handle the `touch` command
+        net::ConversationReply handle_touch_command(const Request & req, io_buffer & send_buf, cache::ShardedCache & cache_api);
+
+        /// Handle the `stat` command
+        net::ConversationReply handle_statistics_command(const Request & req, io_buffer & send_buf, cache::ShardedCache & cache_api);
+
+        /// Write response packet header followed by the `extras` and the `key`, value of `value_length` must be written next
+        void write_response_header(io_buffer & send_buf, const Request & req, uint16 status, const slice extras, const slice key, const size_t value_length, const uint64 cas);
+
+        /// Write response packet
+        void write_response(io_buffer & send_buf, const Request & req, uint16 status, const slice extras, const slice key, const slice value, const uint64 cas);
+
+        /// Write response with the given status code and its description
+        net::ConversationReply reply_with_status(io_buffer & send_buf, const Request & req, uint16 status, slice message = slice());
+
+        /// Write success response unless command is quiet
+        net::ConversationReply reply_with_success(io_buffer & send_buf, const Request & req, const uint64 cas = 0);
+
+        /// Convert error code to the binary protocol response status
+        uint16 status_from_error(const error_code & code) noexcept;
+
+        // hash function
+        inline cache::hash_type calc_hash(const slice key) noexcept {
+            cache::HashFunction do_calc_hash;
+            return do_calc_hash(key);
+        }
+
+        // the largest request body: extras, the key and the value of the maximal size
+        inline size_t max_body_length() noexcept {
+            return std::numeric_limits<uint8>::max() + static_cast<size_t>(cache::Item::max_key_length) + settings.cache.max_item_size;
+        }
+
+        // check request packet format
+        inline void expect(bool condition) {
+            if (not condition) {
+                throw system_error(error::broken_request);
+            }
+        }
+
+
+        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::ShardedCache & cache_api) {
+            if (recv_buf.non_read() < HEADER_LENGTH) {
+                return net::READ_MORE;
+            }
+            protocol_binary_request_header header;
+            std::memcpy(header.bytes, recv_buf.begin_read(), HEADER_LENGTH);
+            const auto raw_header = reinterpret_cast<const char *>(header.bytes);
+            const uint32 body_length = read_uint<uint32>(raw_header + 8);
+            if (body_length > max_body_length()) {
+                // packet can't hold a valid item, refuse it without growing the buffer; the body is never read,
+                // so the stream can't be followed any further
+                recv_buf.confirm_read(HEADER_LENGTH);
+                Request req;
+                req.opcode = header.request.opcode;
+                req.opaque = header.request.opaque;
+                reply_with_status(send_buf, req, PROTOCOL_BINARY_RESPONSE_E2BIG);
+                return net::SEND_REPLY_AND_CLOSE;
+            }
+            if (recv_buf.non_read() < HEADER_LENGTH + body_length) {
+                // help buffer to grow up to the necessary size
+                recv_buf.ensure_capacity(HEADER_LENGTH + body_length - recv_buf.non_read());
+                return net::READ_MORE;
+            }
+            // whole packet is received
+            const slice packet = recv_buf.confirm_read(HEADER_LENGTH + body_length);
+            Request req;
+            req.opcode = header.request.opcode;
+            req.opaque = header.request.opaque; // opaque is returned as is, no need to convert
+            req.cas = read_uint<uint64>(raw_header + 16);
+            const uint16 key_length = read_uint<uint16>(raw_header + 2);
+            const uint8 extras_length = header.request.extlen;
+            auto w_savepoint = send_buf.write_savepoint();
+            try {
+                expect(static_cast<uint32>(extras_length) + key_length <= body_length);
+                const char * body = packet.begin() + HEADER_LENGTH;
+                req.extras = slice(body, extras_length);
+                req.key = slice(body + extras_length, key_length);
+                req.value = slice(body + extras_length + key_length, body_length - extras_length - key_length);
+                switch (req.opcode) {
+                // retrieval commands
+                case PROTOCOL_BINARY_CMD_GET:
+                case PROTOCOL_BINARY_CMD_GETQ:
+                case PROTOCOL_BINARY_CMD_GETK:
+                case PROTOCOL_BINARY_CMD_GETKQ:
+                case PROTOCOL_BINARY_CMD_GAT:
+                case PROTOCOL_BINARY_CMD_GATQ:
+                case PROTOCOL_BINARY_CMD_GATK:
+                case PROTOCOL_BINARY_CMD_GATKQ:
+                    return handle_retrieval_command(req, send_buf, cache_api);
+                // storage commands
+                case PROTOCOL_BINARY_CMD_SET:
+                case PROTOCOL_BINARY_CMD_SETQ:
+                case PROTOCOL_BINARY_CMD_ADD:
+                case PROTOCOL_BINARY_CMD_ADDQ:
+                case PROTOCOL_BINARY_CMD_REPLACE:
+                case PROTOCOL_BINARY_CMD_REPLACEQ:
+                    return handle_storage_command(req, send_buf, cache_api);
+                case PROTOCOL_BINARY_CMD_APPEND:
+                case PROTOCOL_BINARY_CMD_APPENDQ:
+                case PROTOCOL_BINARY_CMD_PREPEND:
+                case PROTOCOL_BINARY_CMD_PREPENDQ:
+                    return handle_extend_command(req, send_buf, cache_api);
+                // delete
+                case PROTOCOL_BINARY_CMD_DELETE:
+                case PROTOCOL_BINARY_CMD_DELETEQ:
+                    return handle_delete_command(req, send_buf, cache_api);
+                // arithmetic
+                case PROTOCOL_BINARY_CMD_INCREMENT:
+                case PROTOCOL_BINARY_CMD_INCREMENTQ:
+                case PROTOCOL_BINARY_CMD_DECREMENT:
+                case PROTOCOL_BINARY_CMD_DECREMENTQ:
+                    return handle_arithmetic_command(req, send_buf, cache_api);
+                // touch
+                case PROTOCOL_BINARY_CMD_TOUCH:
+                    return handle_touch_command(req, send_buf, cache_api);
+                // statistics retrieval
+                case PROTOCOL_BINARY_CMD_STAT:
+                    return handle_statistics_command(req, send_buf, cache_api);
+                case PROTOCOL_BINARY_CMD_VERSION:
+                    expect(body_length == 0);
+                    write_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS, slice(), slice(), slice::from_literal(CACHELOT_VERSION_FULL), 0);
+                    return net::SEND_REPLY_AND_READ;
+                case PROTOCOL_BINARY_CMD_FLUSH:
+                case PROTOCOL_BINARY_CMD_FLUSHQ:
+                    // optional expiration time is ignored, the same way as in ascii protocol
+                    expect((extras_length == 0 || extras_length == sizeof(uint32)) && key_length == 0 && req.value.empty());
+                    cache_api.do_flush_all();
+                    return reply_with_success(send_buf, req);
+                // no-op is used by clients as a barrier after the batch of quiet commands
+                case PROTOCOL_BINARY_CMD_NOOP:
+                    expect(body_length == 0);
+                    return reply_with_success(send_buf, req);
+                // terminate session, only the quiet version closes silently
+                case PROTOCOL_BINARY_CMD_QUIT:
+                case PROTOCOL_BINARY_CMD_QUITQ:
+                    expect(body_length == 0);
+                    reply_with_success(send_buf, req);
+                    return net::SEND_REPLY_AND_CLOSE;
+                // unknown command
+                default:
+                    return reply_with_status(send_buf, req, PROTOCOL_BINARY_RESPONSE_UNKNOWN_COMMAND);
+                }
+            } catch (const system_error & syserr) {
+                // discard any written data to write error message instead
+                send_buf.rollback_write_transaction(w_savepoint);
+                const auto errmsg = syserr.code().message();
+                return reply_with_status(send_buf, req, status_from_error(syserr.code()), slice(errmsg.c_str(), errmsg.length()));
+            } catch (const std::exception & exc) {
+                // discard any written data to write error message instead
+                send_buf.rollback_write_transaction(w_savepoint);
+                return reply_with_status(send_buf, req, PROTOCOL_BINARY_RESPONSE_EINVAL, slice(exc.what(), std::strlen(exc.what())));
+            }
+        }
+
+
+        inline bool is_quiet(uint8 opcode) noexcept {
+            switch (opcode) {
+            case PROTOCOL_BINARY_CMD_GETQ:
+            case PROTOCOL_BINARY_CMD_GETKQ:
+            case PROTOCOL_BINARY_CMD_GATQ:
+            case PROTOCOL_BINARY_CMD_GATKQ:
+            case PROTOCOL_BINARY_CMD_SETQ:
+            case PROTOCOL_BINARY_CMD_ADDQ:
+            case PROTOCOL_BINARY_CMD_REPLACEQ:
+            case PROTOCOL_BINARY_CMD_APPENDQ:
+            case PROTOCOL_BINARY_CMD_PREPENDQ:
+            case PROTOCOL_BINARY_CMD_DELETEQ:
+            case PROTOCOL_BINARY_CMD_INCREMENTQ:
+            case PROTOCOL_BINARY_CMD_DECREMENTQ:
+            case PROTOCOL_BINARY_CMD_FLUSHQ:
+            case PROTOCOL_BINARY_CMD_QUITQ:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+
+        inline net::ConversationReply handle_retrieval_command(const Request & req, io_buffer & send_buf, cache::ShardedCache & cache_api) {
+            const bool get_and_touch = req.opcode == PROTOCOL_BINARY_CMD_GAT || req.opcode == PROTOCOL_BINARY_CMD_GATQ
+                                    || req.opcode == PROTOCOL_BINARY_CMD_GATK || req.opcode == PROTOCOL_BINARY_CMD_GATKQ;
+            const bool with_key = req.opcode == PROTOCOL_BINARY_CMD_GETK || req.opcode == PROTOCOL_BINARY_CMD_GETKQ
+                               || req.opcode == PROTOCOL_BINARY_CMD_GATK || req.opcode == PROTOCOL_BINARY_CMD_GATKQ;
+            expect(req.extras.length() == (get_and_touch ? sizeof(uint32) : 0) && req.value.empty());
+            validate_key(req.key);
+            const auto hash = calc_hash(req.key);
+            const auto write_item_header = [&](cache::ConstItemPtr i) {
+                char flags[sizeof(uint32)];
+                write_uint<uint32>(flags, i->opaque_flags());
+                write_response_header(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS, slice(flags, sizeof(flags)), with_key ? i->key() : slice(), i->uncompressed_length(), i->timestamp());
+            };
+            bool found;
+            if (settings.cache.has_concurrent_reads && not get_and_touch) {
+                // shard isn't locked, item may be removed right after the lookup, so its value is copied
+                found = cache_api.do_get(req.key, hash, [&](cache::ConstItemPtr i) {
+                    write_item_header(i);
+                    copy_value(send_buf, i);
+                });
+            } else {
+                auto shard = cache_api.lock_shard_for(hash);
+                if (get_and_touch) {
+                    shard->do_touch(req.key, hash, cache::seconds(read_uint<uint32>(req.extras.begin())));
+                }
+                auto i = shard->do_get(req.key, hash);
+                found = i != nullptr;
+                if (found) {
+                    write_item_header(i);
+                    write_value(send_buf, i, *shard, cache_api);
+                }
+            }
+            if (found) {
+                return net::SEND_REPLY_AND_READ;
+            } else if (is_quiet(req.opcode)) {
+                return net::READ_MORE;
+            } else {
+                write_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_ENOENT, slice(), with_key ? req.key : slice(), slice::from_literal("Not found"), 0);
+                return net::SEND_REPLY_AND_READ;
+            }
+        }
+
+
+        inline net::ConversationReply handle_storage_command(const Request & req, io_buffer & send_buf, cache::ShardedCache & cache_api) {
+            expect(req.extras.length() == sizeof(uint32) * 2);
+            validate_key(req.key);
+            const uint32 flags = read_uint<uint32>(req.extras.begin());
+            // item flags are 16-bit
+            expect(flags <= std::numeric_limits<cache::opaque_flags_type>::max());
+            // `add` with the cas makes no sense
+            expect(req.cas == 0 || (req.opcode != PROTOCOL_BINARY_CMD_ADD && req.opcode != PROTOCOL_BINARY_CMD_ADDQ));
+            const auto keep_alive_duration = cache::seconds(read_uint<uint32>(req.extras.begin() + sizeof(uint32)));
+            if (req.value.length() > settings.cache.max_item_size) {
+                throw system_error(error::value_length);
+            }
+            // create new item and execute the cache API
+            const auto hash = calc_hash(req.key);
+            auto shard = cache_api.lock_shard_for(hash);
+            cache::ItemPtr new_item = nullptr;
+            try {
+                new_item = shard->create_item(req.key, hash, req.value, static_cast<cache::opaque_flags_type>(flags), keep_alive_duration);
+            } catch (const system_error & syserr) {
+                if (syserr.code() != error::not_admitted) {
+                    throw;
+                }
+                // key is not in the cache, reply as if the item was stored and evicted right away
+                const bool stores_new_key = req.cas == 0 && req.opcode != PROTOCOL_BINARY_CMD_REPLACE && req.opcode != PROTOCOL_BINARY_CMD_REPLACEQ;
+                return stores_new_key ? reply_with_success(send_buf, req, 0) : reply_with_status(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_ENOENT);
+            }
+            // new item may be freed by the cache, remember its cas beforehand
+            const auto new_cas = new_item->timestamp();
+            bool found = false; bool stored = false;
+            switch (req.opcode) {
+            case PROTOCOL_BINARY_CMD_SET:
+            case PROTOCOL_BINARY_CMD_SETQ:
+                if (req.cas == 0) {
+                    shard->do_set(new_item);
+                    return reply_with_success(send_buf, req, new_cas);
+                }
+                // `set` with the non-zero cas is the `cas` command
+                tie(found, stored) = shard->do_cas(new_item, req.cas);
+                break;
+            case PROTOCOL_BINARY_CMD_ADD:
+            case PROTOCOL_BINARY_CMD_ADDQ:
+                if (shard->do_add(new_item)) {
+                    return reply_with_success(send_buf, req, new_cas);
+                }
+                return reply_with_status(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_EEXISTS);
+            case PROTOCOL_BINARY_CMD_REPLACE:
+            case PROTOCOL_BINARY_CMD_REPLACEQ:
+                if (req.cas == 0) {
+                    found = stored = shard->do_replace(new_item);
+                } else {
+                    tie(found, stored) = shard->do_cas(new_item, req.cas);
+                }
+                break;
+            default:
+                debug_assert(false);
+                throw system_error(error::unknown_error);
+            }
+            if (not found) {
+                return reply_with_status(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_ENOENT);
+            } else if (not stored) {
+                return reply_with_status(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_EEXISTS);
+            }
+            return reply_with_success(send_buf, req, new_cas);
+        }
+
+
+        inline net::ConversationReply handle_extend_command(const Request & req, io_buffer & send_buf, cache::ShardedCache & cache_api) {
+            expect(req.extras.empty());
+            validate_key(req.key);
+            if (req.value.length() > settings.cache.max_item_size) {
+                throw system_error(error::value_length);
+            }
+            const auto hash = calc_hash(req.key);
+            auto shard = cache_api.lock_shard_for(hash);
+            cache::ItemPtr piece = nullptr;
+            try {
+                piece = shard->create_item(req.key, hash, req.value.length(), 0, cache::Item::infinite_TTL);
+            } catch (const system_error & syserr) {
+                if (syserr.code() != error::not_admitted) {
+                    throw;
+                }
+                // there is no item to extend
+                return reply_with_status(send_buf, req, PROTOCOL_BINARY_RESPONSE_NOT_STORED);
+            }
+            piece->assign_value(req.value);
+            bool found;
+            if (req.opcode == PROTOCOL_BINARY_CMD_APPEND || req.opcode == PROTOCOL_BINARY_CMD_APPENDQ) {
+                found = shard->do_append(piece);
+            } else {
+                found = shard->do_prepend(piece);
+            }
+            return found ? reply_with_success(send_buf, req) : reply_with_status(send_buf, req, PROTOCOL_BINARY_RESPONSE_NOT_STORED);
+        }
+
+
+        inline net::ConversationReply handle_delete_command(const Request & req, io_buffer & send_buf, cache::ShardedCache & cache_api) {
+            expect(req.extras.empty() && req.value.empty());
+            validate_key(req.key);
+            const auto hash = calc_hash(req.key);
+            bool found = cache_api.lock_shard_for(hash)->do_delete(req.key, hash);
+            return found ? reply_with_success(send_buf, req) : reply_with_status(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_ENOENT);
+        }
+
+
+        inline net::ConversationReply handle_arithmetic_command(const Request & req, io_buffer & send_buf, cache::ShardedCache & cache_api) {
+            // extras are: <delta:8> <initial:8> <expiration:4>
+            expect(req.extras.length() == sizeof(uint64) * 2 + sizeof(uint32) && req.value.empty());
+            validate_key(req.key);
+            const uint64 delta = read_uint<uint64>(req.extras.begin());
+            const uint64 initial = read_uint<uint64>(req.extras.begin() + sizeof(uint64));
+            const uint32 expiration = read_uint<uint32>(req.extras.begin() + sizeof(uint64) * 2);
+            const bool incr = req.opcode == PROTOCOL_BINARY_CMD_INCREMENT || req.opcode == PROTOCOL_BINARY_CMD_INCREMENTQ;
+            const auto hash = calc_hash(req.key);
+            auto shard = cache_api.lock_shard_for(hash);
+            bool found; uint64 new_value;
+            tie(found, new_value) = incr ? shard->do_incr(req.key, hash, delta) : shard->do_decr(req.key, hash, delta);
+            if (not found) {
+                if (expiration == DONT_CREATE_COUNTER) {
+                    return reply_with_status(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_ENOENT);
+                }
+                // create counter with the initial value
+                char ascii_value[internal::numeric<uint64>::max_str_length];
+                const size_t ascii_length = int_to_str(initial, ascii_value);
+                try {
+                    auto counter = shard->create_item(req.key, hash, ascii_length, 0, cache::seconds(expiration));
+                    counter->assign_value(slice(ascii_value, ascii_length));
+                    shard->do_set(counter);
+                } catch (const system_error & syserr) {
+                    if (syserr.code() != error::not_admitted) {
+                        throw;
+                    }
+                    // counter is created and evicted right away
+                }
+                new_value = initial;
+            }
+            if (is_quiet(req.opcode)) {
+                return net::READ_MORE;
+            }
+            char value[sizeof(uint64)];
+            write_uint<uint64>(value, new_value);
+            write_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS, slice(), slice(), slice(value, sizeof(value)), 0);
+            return net::SEND_REPLY_AND_READ;
+        }
+
+
+        inline net::ConversationReply handle_touch_command(const Request & req, io_buffer & send_buf, cache::ShardedCache & cache_api) {
+            expect(req.extras.length() == sizeof(uint32) && req.value.empty());
+            validate_key(req.key);
+            const cache::seconds keep_alive_duration(read_uint<uint32>(req.extras.begin()));
+            const auto hash = calc_hash(req.key);
+            bool found = cache_api.lock_shard_for(hash)->do_touch(req.key, hash, keep_alive_duration);
+            return found ? reply_with_success(send_buf, req) : reply_with_status(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_ENOENT);
+        }
+
+
+        // Convert stat value to the ascii string
+        inline slice stat_to_str(char * buf, const uint64 value) noexcept {
+            return slice(buf, int_to_str(value, buf));
+        }
+
+        inline slice stat_to_str(char *, const bool value) noexcept {
+            return value ? slice::from_literal("1") : slice::from_literal("0");
+        }
+
+
+        inline net::ConversationReply handle_statistics_command(const Request & req, io_buffer & send_buf, cache::ShardedCache & cache_api) {
+            expect(req.extras.empty() && req.value.empty());
+            if (not req.key.empty()) {
+                // stat groups are not supported
+                return reply_with_status(send_buf, req, PROTOCOL_BINARY_RESPONSE_KEY_ENOENT);
+            }
+            const auto totals = cache_api.collect_stats();
+            char ascii_value[internal::numeric<uint64>::max_str_length];
+            // every stat is sent as a separate packet with the stat name as a key and the stat value as a value
+            #define SERIALIZE_STAT(stat_group, stat_type, stat_name, stat_description) \
+                write_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS, slice(), slice::from_literal(CACHELOT_PP_STR(stat_name)), stat_to_str(ascii_value, totals.stat_group.stat_name), 0);
+
+            #define SERIALIZE_CACHE_STAT(typ, name, desc) SERIALIZE_STAT(cache, typ, name, desc)
+            CACHE_STATS(SERIALIZE_CACHE_STAT)
+            #undef SERIALIZE_CACHE_STAT
+
+            #define SERIALIZE_MEM_STAT(typ, name, desc) SERIALIZE_STAT(mem, typ, name, desc)
+            MEMORY_STATS(SERIALIZE_MEM_STAT)
+            #undef SERIALIZE_MEM_STAT
+
+            #undef SERIALIZE_STAT
+            // empty packet terminates the sequence
+            write_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS, slice(), slice(), slice(), 0);
+            return net::SEND_REPLY_AND_READ;
+        }
+
+
+        inline void write_response_header(io_buffer & send_buf, const Request & req, uint16 status, const slice extras, const slice key, const size_t value_length, const uint64 cas) {
+            const size_t body_length = extras.length() + key.length() + value_length;
+            char * dest = send_buf.begin_write(HEADER_LENGTH + extras.length() + key.length());
+            protocol_binary_response_header header;
+            std::memset(header.bytes, 0, HEADER_LENGTH);
+            header.response.magic = PROTOCOL_BINARY_RES;
+            header.response.opcode = req.opcode;
+            header.response.extlen = static_cast<uint8>(extras.length());
+            header.response.datatype = PROTOCOL_BINARY_RAW_BYTES;
+            header.response.opaque = req.opaque;
+            auto raw_header = reinterpret_cast<char *>(header.bytes);
+            write_uint<uint16>(raw_header + 2, static_cast<uint16>(key.length()));
+            write_uint<uint16>(raw_header + 6, status);
+            write_uint<uint32>(raw_header + 8, static_cast<uint32>(body_length));
+            write_uint<uint64>(raw_header + 16, cas);
+            std::memcpy(dest, header.bytes, HEADER_LENGTH);
+            dest += HEADER_LENGTH;
+            std::memcpy(dest, extras.begin(), extras.length());
+            dest += extras.length();
+            std::memcpy(dest, key.begin(), key.length());
+            send_buf.confirm_write(HEADER_LENGTH + extras.length() + key.length());
+        }
+
+
+        inline void write_response(io_buffer & send_buf, const Request & req, uint16 status, const slice extras, const slice key, const slice value, const uint64 cas) {
+            write_response_header(send_buf, req, status, extras, key, value.length(), cas);
+            if (value) {
+                std::memcpy(send_buf.begin_write(value.length()), value.begin(), value.length());
+                send_buf.confirm_write(value.length());
+            }
+        }
+
+
+        inline net::ConversationReply reply_with_status(io_buffer & send_buf, const Request & req, uint16 status, slice message) {
+            if (message.empty()) {
+                switch (status) {
+                case PROTOCOL_BINARY_RESPONSE_KEY_ENOENT: message = slice::from_literal("Not found"); break;
+                case PROTOCOL_BINARY_RESPONSE_KEY_EEXISTS: message = slice::from_literal("Data exists for key"); break;
+                case PROTOCOL_BINARY_RESPONSE_NOT_STORED: message = slice::from_literal("Not stored"); break;
+                case PROTOCOL_BINARY_RESPONSE_UNKNOWN_COMMAND: message = slice::from_literal("Unknown command"); break;
+                default: break;
+                }
+            }
+            write_response(send_buf, req, status, slice(), slice(), message, 0);
+            return net::SEND_REPLY_AND_READ;
+        }
+
+
+        inline net::ConversationReply reply_with_success(io_buffer & send_buf, const Request & req, const uint64 cas) {
+            if (is_quiet(req.opcode)) {
+                return net::READ_MORE;
+            }
+            write_response(send_buf, req, PROTOCOL_BINARY_RESPONSE_SUCCESS, slice(), slice(), slice(), cas);
+            return net::SEND_REPLY_AND_READ;
+        }
+
+
+        inline uint16 status_from_error(const error_code & code) noexcept {
+            if (code.category() == get_protocol_error_category()) {
+                return code.value() == error::value_length ? PROTOCOL_BINARY_RESPONSE_E2BIG : PROTOCOL_BINARY_RESPONSE_EINVAL;
+            }
+            switch (code.value()) {
+            case error::out_of_memory:
+                return PROTOCOL_BINARY_RESPONSE_ENOMEM;
+            case error::item_too_big:
+                return PROTOCOL_BINARY_RESPONSE_E2BIG;
+            case error::numeric_convert:
+            case error::numeric_overflow:
+                // non-numeric value of the `incr` / `decr` counter
+                return PROTOCOL_BINARY_RESPONSE_DELTA_BADVAL;
+            case error::not_implemented:
+                return PROTOCOL_BINARY_RESPONSE_UNKNOWN_COMMAND;
+            default:
+                return PROTOCOL_BINARY_RESPONSE_EINVAL;
+            }
         }
 
     }} // namespace memcached::binary
 
 } // namespace cachelot
-
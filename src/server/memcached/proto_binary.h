@@ -22,7 +22,7 @@ namespace cachelot { namespace memcached {
         const extern uint8 MAGIC;
 
         /// Main function that process binary protocol packets
-        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::Cache & cache_api);
+        net::ConversationReply handle_received_data(io_buffer & recv_buf, io_buffer & send_buf, cache::ShardedCache & cache_api);
 
 
     } // namespace binary
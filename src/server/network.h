@@ -25,8 +25,6 @@
 #  pragma warning(push, 1)
 #endif
 #ifndef BOOST_ASIO_HPP
-// TODO: Build system options
-#define BOOST_ASIO_DISABLE_THREADS
 //#define BOOST_ASIO_ENABLE_HANDLER_TRACKING
 #  include <boost/asio.hpp>
 #endif
@@ -52,9 +50,31 @@ namespace cachelot {
 
         namespace io_error = asio::error;
 
+    #if defined(SO_REUSEPORT)
+        /// Socket option to bind multiple sockets to the same address, kernel balances connections among them
+        /// Models the Asio `SettableSocketOption` concept, so it relies only on the public API
+        class reuse_port {
+        public:
+            explicit reuse_port(bool enabled) noexcept : m_value(enabled ? 1 : 0) {}
+
+            template <typename Protocol> int level(const Protocol &) const noexcept { return SOL_SOCKET; }
+            template <typename Protocol> int name(const Protocol &) const noexcept { return SO_REUSEPORT; }
+            template <typename Protocol> const int * data(const Protocol &) const noexcept { return &m_value; }
+            template <typename Protocol> std::size_t size(const Protocol &) const noexcept { return sizeof(m_value); }
+
+        private:
+            int m_value;
+        };
+        /// Whether `reuse_port` is supported by the platform
+        constexpr bool has_reuse_port = true;
+    #else
+        constexpr bool has_reuse_port = false;
+    #endif
+
         enum ConversationReply {
             READ_MORE,
             SEND_REPLY_AND_READ,
+            SEND_REPLY_AND_CLOSE,
             CLOSE_IMMEDIATELY
         };
 
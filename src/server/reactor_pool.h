@@ -0,0 +1,137 @@
+#ifndef CACHELOT_NET_REACTOR_POOL_H_INCLUDED
+#define CACHELOT_NET_REACTOR_POOL_H_INCLUDED
+
+//
+//  (C) Copyright 2015 Iurii Krasnoshchok
+//
+//  Distributed under the terms of Simplified BSD License
+//  see LICENSE file
+
+#ifndef CACHELOT_NETWORK_H_INCLUDED
+#  include <server/network.h>
+#endif
+
+#include <thread>
+#if defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+
+namespace cachelot { namespace net {
+
+    /**
+     * reactor_pool is a set of independent reactors (`io_service`), each one is run by its own thread
+     *
+     * Reactor `0` is the main one, it is run by the thread which called `run()`.
+     * Connections are bound to a single reactor, so the handlers of one connection are never executed concurrently
+     * @ingroup net
+     */
+    class reactor_pool {
+    public:
+        /// constructor
+        /// @p num_reactors - number of reactors (threads)
+        /// @p pin_threads - pin the thread of the reactor `N` to the `N`th available CPU
+        explicit reactor_pool(const size_t num_reactors, const bool pin_threads = false)
+            : m_next(0)
+            , m_pin_threads(pin_threads) {
+            debug_assert(num_reactors > 0);
+        #if defined(__linux__)
+            // remember CPUs process is allowed to run on before any thread is pinned
+            CPU_ZERO(&m_allowed_cpus);
+            if (sched_getaffinity(0, sizeof(m_allowed_cpus), &m_allowed_cpus) != 0) {
+                CPU_ZERO(&m_allowed_cpus);
+            }
+        #endif
+            for (size_t n = 0; n < num_reactors; ++n) {
+                m_reactors.emplace_back(new io_service());
+                // prevent reactor from exiting when it has no work
+                m_work.emplace_back(new io_service::work(*m_reactors.back()));
+            }
+        }
+
+        reactor_pool(const reactor_pool &) = delete;
+        reactor_pool & operator= (const reactor_pool &) = delete;
+
+        /// number of reactors
+        size_t size() const noexcept { return m_reactors.size(); }
+
+        /// main reactor (run by the thread which called `run()`)
+        io_service & main() noexcept { return *m_reactors.front(); }
+
+        /// reactor by its number
+        io_service & at(const size_t n) noexcept {
+            debug_assert(n < m_reactors.size());
+            return *m_reactors[n];
+        }
+
+        /// pick the next reactor in a round-robin manner
+        io_service & next() noexcept {
+            return at(m_next++ % m_reactors.size());
+        }
+
+        /// run every reactor in its own thread, block until all reactors are stopped
+        void run() {
+            std::vector<std::thread> threads;
+            for (size_t n = 1; n < m_reactors.size(); ++n) {
+                threads.emplace_back([=]() { this->run_reactor(n); });
+            }
+            run_reactor(0);
+            for (auto & t : threads) {
+                t.join();
+            }
+        }
+
+        /// stop all reactors
+        void stop() noexcept {
+            for (auto & reactor : m_reactors) {
+                reactor->stop();
+            }
+        }
+
+    private:
+        void run_reactor(const size_t n) {
+            if (m_pin_threads) {
+                pin_current_thread(n);
+            }
+            auto & reactor = at(n);
+            do {
+                reactor.run();
+            } while (not reactor.stopped());
+        }
+
+        /// bind calling thread to the `n`th CPU of the ones process is allowed to run on (best effort)
+        void pin_current_thread(const size_t n) noexcept {
+        #if defined(__linux__)
+            if (CPU_COUNT(&m_allowed_cpus) == 0) {
+                return;
+            }
+            size_t nth = n % static_cast<size_t>(CPU_COUNT(&m_allowed_cpus));
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &m_allowed_cpus) && nth-- == 0) {
+                    cpu_set_t target;
+                    CPU_ZERO(&target);
+                    CPU_SET(cpu, &target);
+                    pthread_setaffinity_np(pthread_self(), sizeof(target), &target);
+                    return;
+                }
+            }
+        #else
+            (void)n;
+        #endif
+        }
+
+    private:
+        std::vector<std::unique_ptr<io_service>> m_reactors;
+        std::vector<std::unique_ptr<io_service::work>> m_work;
+        size_t m_next;
+        const bool m_pin_threads;
+    #if defined(__linux__)
+        cpu_set_t m_allowed_cpus;
+    #endif
+    };
+
+}} // namespace cachelot::net
+
+
+#endif // CACHELOT_NET_REACTOR_POOL_H_INCLUDED
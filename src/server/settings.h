@@ -7,6 +7,12 @@
 //  Distributed under the terms of Simplified BSD License
 //  see LICENSE file
 
+#ifndef CACHELOT_HASH_FUNCTION_H_INCLUDED
+#  include <cachelot/hash_function.h>
+#endif
+#ifndef CACHELOT_MEMALLOC_H_INCLUDED
+#  include <cachelot/memalloc.h>
+#endif
 
 namespace cachelot {
 
@@ -17,12 +23,22 @@ namespace cachelot {
         struct {
             size_t memory_limit = 64 * Megabyte; // 64Mb
             size_t page_size =  1 * Megabyte; // 1Mb
+            size_t max_item_size = 1 * Megabyte; // items larger than the page are stored in the chain of pages
             size_t initial_hash_table_size = 65536;
+            bool has_background_rehash = false; // hash table is expanded by the idle-time task rather than by requests
+            bool has_concurrent_reads = false; // `get` looks items up without locking the shard
+            hash_algorithm hash_function = hash_algorithm::CACHELOT_DEFAULT_HASH;
             bool has_CAS = true;
             bool has_evictions = true;
+            memalloc::eviction_policy eviction_policy = memalloc::eviction_policy::page_lru;
+            bool has_admission_filter = false;
+            size_t compression_threshold = 0; // 0 - compression is disabled
+            bool has_huge_pages = false;
+            int numa_node = -1; // -1 - default memory policy
         } cache;
         struct {
             size_t number_of_threads = 4;
+            bool has_reuse_port = false;
             bool has_TCP = true;
             string listen_interface = "localhost";
             uint16 TCP_port = 11211;
@@ -89,7 +89,8 @@ namespace cachelot { namespace net {
                 m_recv_buf.confirm_write(bytes_recvd);
                 if (not error) {
                     try {
-                        if (handle_data(m_recv_buf, m_send_buf) == SEND_REPLY_AND_READ) {
+                        const auto reply = handle_data(m_recv_buf, m_send_buf);
+                        if (reply == SEND_REPLY_AND_READ || reply == SEND_REPLY_AND_CLOSE) {
                             async_send_all(m_remote_endpoint);
                         }
                         m_recv_buf.compact();
@@ -48,6 +48,9 @@ namespace cachelot { namespace net {
         /// underlying socket
         SocketType & socket() noexcept { return m_socket; }
 
+        /// reactor serving this connection
+        io_service & get_io_service() noexcept { return m_ios; }
+
         /// check whether connection is open
         bool is_open() const noexcept { return m_socket.is_open(); }
 
@@ -62,20 +65,29 @@ namespace cachelot { namespace net {
         /// start asynchronous receive operation, call the Conversation::handle_data on complete
         void async_receive_some() noexcept;
 
-        /// start asynchronous send of the send buffer
-        void async_send_all() noexcept;
+        /// let the Conversation handle received data and decide what to do next
+        void process_received_data() noexcept;
+
+        /// start asynchronous send of the send buffer, continue with received data on complete
+        /// @p close_when_sent - close the connection after the send instead of reading further requests
+        void async_send_all(const bool close_when_sent = false) noexcept;
+
+        /// start asynchronous receive of data requested by the Conversation directly into its memory
+        void async_receive_external() noexcept;
 
         /// schedule arbitrary function into IO loop
         template <typename Function>
-        void post(Function fun) noexcept { m_socket.get_io_service().post(fun); }
+        void post(Function fun) noexcept { m_ios.post(fun); }
 
         /// publish dynamic stats
         void publish_stats() noexcept;
 
     private:
+        io_service & m_ios;
         SocketType m_socket;
         io_buffer m_recv_buf;
         io_buffer m_send_buf;
+        std::vector<asio::const_buffer> m_send_pieces;
         bool m_killed;
     };
 
@@ -86,8 +98,8 @@ namespace cachelot { namespace net {
      * @tparam SocketType -     Socket implementation from the boost::asio
      * @tparam ImplType -       Actual protocol_type Server implementation class, must be derived from stream_server
      *                          stream_server expects that ImplType class provides the following functions:
-     *                          `ConversationType * new_conversation()` to create new conversations
-     *                          `delete_conversation(ConversationType *)` to delete broken / expired conversations
+     *                          `std::shared_ptr<ConversationType> new_conversation()` to create new conversations,
+     *                          conversation may be bound to any reactor, not necessarily to the one of the acceptor
      * @ingroup net
      */
     template <class SocketType, class ImplType>
@@ -107,7 +119,8 @@ namespace cachelot { namespace net {
         stream_server & operator= (const stream_server &) = delete;
 
         /// start accept connections
-        void start(const typename protocol_type::endpoint bind_addr);
+        /// @p enable_reuse_port - allow other acceptors to bind the same address (SO_REUSEPORT)
+        void start(const typename protocol_type::endpoint bind_addr, const bool enable_reuse_port = false);
 
         /// interrupt all activity
         void stop() noexcept {
@@ -118,6 +131,9 @@ namespace cachelot { namespace net {
 
         io_service & get_io_service() noexcept { return m_ios; }
 
+        /// address server is bound to (useful when bound to the port `0`)
+        typename protocol_type::endpoint local_endpoint() const { return m_acceptor.local_endpoint(); }
+
     private:
         void async_accept();
 
@@ -132,11 +148,17 @@ namespace cachelot { namespace net {
 
     template <class Sock, class Conversation>
     inline stream_connection<Sock, Conversation>::stream_connection(io_service & io_svc, const size_t rcvbuf_max, const size_t sndbuf_max)
-        : m_socket(io_svc)
+        : m_ios(io_svc)
+        , m_socket(io_svc)
         , m_recv_buf(default_min_buffer_size, rcvbuf_max)
         , m_send_buf(default_min_buffer_size, sndbuf_max)
+        , m_send_pieces()
         , m_killed(false) {
         static_assert(std::is_base_of<stream_connection<Sock, Conversation>, Conversation>::value, "Conversation must be derived class");
+        // reply may reference large data instead of copying, it's sent with the gather IO
+        m_send_buf.enable_external();
+        // large request may be received directly into its destination
+        m_recv_buf.enable_external();
     }
 
 
@@ -145,21 +167,9 @@ namespace cachelot { namespace net {
         auto self = this->shared_from_this();
         m_socket.async_read_some(asio::buffer(m_recv_buf.begin_write(), m_recv_buf.available()),
             [=](const error_code error, const size_t bytes_received) {
-                slice receive_result;
                 if (not error) {
                     self->m_recv_buf.confirm_write(bytes_received);
-                    ConversationReply reply = handle_data(m_recv_buf, m_send_buf);
-                    self->m_recv_buf.compact();
-                    switch (reply) {
-                    case SEND_REPLY_AND_READ:
-                        self->async_send_all();
-                        // there is no `break` so we'll continue receive
-                    case READ_MORE:
-                        self->async_receive_some();
-                        break;
-                    case CLOSE_IMMEDIATELY:
-                        break;
-                    }
+                    self->process_received_data();
                 } else {
                     if (error == io_error::message_size) {
                         self->m_recv_buf.confirm_write(bytes_received);
@@ -171,15 +181,74 @@ namespace cachelot { namespace net {
 
 
     template <class Sock, class Conversation>
-    inline void stream_connection<Sock, Conversation>::async_send_all() noexcept {
+    inline void stream_connection<Sock, Conversation>::process_received_data() noexcept {
+        // Conversation handles as many requests as available at once and accumulates the replies,
+        // next read starts only after the reply was sent, so there is only one operation in progress
+        ConversationReply reply = handle_data(m_recv_buf, m_send_buf);
+        m_recv_buf.compact();
+        if (reply != CLOSE_IMMEDIATELY && reply != SEND_REPLY_AND_CLOSE && m_recv_buf.external_receive_pending()) {
+            // the rest of request goes directly into the Conversation memory, replies are sent after it
+            async_receive_external();
+            return;
+        }
+        switch (reply) {
+        case SEND_REPLY_AND_READ:
+            async_send_all();
+            break;
+        case SEND_REPLY_AND_CLOSE:
+            async_send_all(/*close_when_sent=*/true);
+            break;
+        case READ_MORE:
+            async_receive_some();
+            break;
+        case CLOSE_IMMEDIATELY:
+            break;
+        }
+    }
+
+
+    template <class Sock, class Conversation>
+    inline void stream_connection<Sock, Conversation>::async_send_all(const bool close_when_sent) noexcept {
         if (m_killed) { return; }
         auto self = this->shared_from_this();
-        asio::async_write(m_socket, asio::buffer(m_send_buf.begin_read(), m_send_buf.non_read()), asio::transfer_all(),
+        // send buffer and referenced external data with a single writev
+        m_send_pieces.clear();
+        m_send_buf.for_each_non_read([this](const slice piece) {
+            m_send_pieces.emplace_back(piece.begin(), piece.length());
+        });
+        asio::async_write(m_socket, m_send_pieces, asio::transfer_all(),
             [=](error_code error, size_t bytes_sent) {
                 if (not error) {
-                    debug_assert(self->m_send_buf.non_read() == bytes_sent);
-                    self->m_send_buf.confirm_read(bytes_sent);
+                    debug_assert(self->m_send_buf.non_read_with_external() == bytes_sent); (void)bytes_sent;
+                    self->m_send_buf.read_all();
+                    // release external data
                     self->m_send_buf.compact();
+                    if (close_when_sent) {
+                        self->close();
+                    } else if (self->m_recv_buf.non_read() > 0) {
+                        // requests left over when the reply has been flushed
+                        self->process_received_data();
+                    } else {
+                        self->async_receive_some();
+                    }
+                }
+            });
+    }
+
+
+    template <class Sock, class Conversation>
+    inline void stream_connection<Sock, Conversation>::async_receive_external() noexcept {
+        auto self = this->shared_from_this();
+        asio::async_read(m_socket, asio::buffer(m_recv_buf.external_receive_dest(), m_recv_buf.external_receive_length()), asio::transfer_all(),
+            [=](const error_code error, const size_t) {
+                if (not error) {
+                    // Conversation completes the request, it may write a reply
+                    self->m_recv_buf.complete_external_receive();
+                    if (self->m_send_buf.non_read_with_external() > 0) {
+                        self->async_send_all();
+                    } else {
+                        self->async_receive_some();
+                    }
                 }
             });
     }
@@ -200,10 +269,17 @@ namespace cachelot { namespace net {
 
 
     template <class SocketType, class ImplType>
-    inline void stream_server<SocketType, ImplType>::start(const typename protocol_type::endpoint bind_addr) {
+    inline void stream_server<SocketType, ImplType>::start(const typename protocol_type::endpoint bind_addr, const bool enable_reuse_port) {
         m_acceptor.open(bind_addr.protocol());
         error_code ignore_error;
         m_acceptor.set_option(typename protocol_type::acceptor::reuse_address(true), ignore_error);
+        if (enable_reuse_port) {
+        #if defined(SO_REUSEPORT)
+            m_acceptor.set_option(net::reuse_port(true));
+        #else
+            throw system_error(error::not_implemented);
+        #endif
+        }
         m_acceptor.bind(bind_addr);
         m_acceptor.listen();
         async_accept();
@@ -217,7 +293,8 @@ namespace cachelot { namespace net {
             m_acceptor.async_accept(new_conversation->socket(),
                 [=](const error_code error) {
                     if (not error) {
-                        new_conversation->start();
+                        // start conversation in the context of its own reactor
+                        new_conversation->get_io_service().post([=]() { new_conversation->start(); });
                     }
                     if (not m_ios.stopped()) {
                         this->async_accept();
@@ -3,6 +3,7 @@
 #include <string.h>
 
 #include <unistd.h>
+#include <pthread.h>
 
 #include <cachelot/c_api.h>
 
@@ -114,6 +115,34 @@ bool test_basic(CachelotPtr c, CachelotError * out_err) {
 }
 
 
+bool test_get_multi(CachelotPtr c, CachelotError * out_err) {
+    CachelotItemPtr i1;
+    NEW_ITEM(i1, "Multi1", "Value1");
+    CACHELOT_SET(i1);
+    NEW_ITEM(i1, "Multi2", "Value2");
+    CACHELOT_SET(i1);
+    const CachelotItemKey keys[] = { new_key("Multi1"), new_key("Missing"), new_key("Multi2") };
+    CachelotConstItemPtr items[3];
+    if (!cachelot_get_multi(c, keys, 3, items, out_err)) {
+        print_cachelot_error("cachelot_get_multi failed", out_err);
+        return false;
+    }
+    if (items[0] == NULL || strncmp(cachelot_item_get_value(items[0]), "Value1", strlen("Value1")) != 0) {
+        printf("cachelot_get_multi: unexpected value of 'Multi1'\n");
+        return false;
+    }
+    if (items[1] != NULL) {
+        printf("cachelot_get_multi: non-existing key was found\n");
+        return false;
+    }
+    if (items[2] == NULL || strncmp(cachelot_item_get_value(items[2]), "Value2", strlen("Value2")) != 0) {
+        printf("cachelot_get_multi: unexpected value of 'Multi2'\n");
+        return false;
+    }
+    return true;
+}
+
+
 bool test_arith(CachelotPtr c, CachelotError * out_err) {
     CachelotItemPtr i1;
     // create new item with int value
@@ -336,6 +365,152 @@ bool test_on_eviction_callback(CachelotError * out_err) {
 }
 
 
+bool test_huge_pages(CachelotError * out_err) {
+    const CachelotOptions hugePagesCache = {
+        .memory_limit = 4u*1024*1024,
+        .mem_page_size = 4096u,
+        .initial_dict_size = 1024u,
+        .enable_evictions = true,
+        .huge_pages = true,
+    };
+    // huge pages are best effort, cache must work whether system has them or not
+    CachelotPtr c = cachelot_init(hugePagesCache, out_err);
+    if (c == NULL) {
+        print_cachelot_error("test huge_pages: failed to create cache", out_err);
+        return false;
+    }
+    bool ret = true;
+    for (int i = 0; i < 100; ++i) {
+        char theKey[8];
+        sprintf(theKey, "Item%02d", i);
+        CachelotItemPtr item = new_item(c, theKey, __large_value, out_err);
+        if (item == NULL || !cachelot_set(c, item, out_err)) {
+            print_cachelot_error("test huge_pages: failed to set new item", out_err);
+            ret = false; goto cleanup;
+        }
+    }
+    for (int i = 0; i < 100; ++i) {
+        char theKey[8];
+        sprintf(theKey, "Item%02d", i);
+        if (!check_value_eq(c, theKey, __large_value, out_err)) {
+            ret = false; goto cleanup;
+        }
+    }
+    cleanup:
+        cachelot_destroy(c);
+    return ret;
+}
+
+
+#define SHARDED_NUM_THREADS 4
+#define SHARDED_NUM_KEYS 1000
+
+struct sharded_thread_args {
+    CachelotShardedPtr cache;
+    int thread_no;
+    bool succeeded;
+};
+
+void * __sharded_thread(void * arg) {
+    struct sharded_thread_args * args = (struct sharded_thread_args *)arg;
+    CachelotError error_struct;
+    CachelotError * out_err = &error_struct;
+    char theKey[32], theValue[32], buffer[32];
+    args->succeeded = true;
+    for (int i = 0; i < SHARDED_NUM_KEYS; ++i) {
+        sprintf(theKey, "Thread%d:Item%d", args->thread_no, i);
+        sprintf(theValue, "Value%d", i);
+        if (!cachelot_sharded_set(args->cache, new_key(theKey), theValue, strlen(theValue), cachelot_infinite_TTL, out_err)) {
+            print_cachelot_error("test sharded: failed to set new item", out_err);
+            args->succeeded = false; return NULL;
+        }
+        // every thread increments the same counter
+        if (!cachelot_sharded_incr(args->cache, new_key("Counter"), 1, NULL, out_err)) {
+            print_cachelot_error("test sharded: failed to increment counter", out_err);
+            args->succeeded = false; return NULL;
+        }
+    }
+    for (int i = 0; i < SHARDED_NUM_KEYS; ++i) {
+        size_t valuelen;
+        sprintf(theKey, "Thread%d:Item%d", args->thread_no, i);
+        sprintf(theValue, "Value%d", i);
+        if (!cachelot_sharded_get(args->cache, new_key(theKey), buffer, sizeof(buffer), &valuelen, out_err)) {
+            printf("test sharded: key '%s' was not found\n", theKey);
+            args->succeeded = false; return NULL;
+        }
+        if (valuelen != strlen(theValue) || strncmp(buffer, theValue, valuelen) != 0) {
+            printf("test sharded: unexpected value of '%s'\n", theKey);
+            args->succeeded = false; return NULL;
+        }
+    }
+    return NULL;
+}
+
+bool test_sharded(CachelotError * out_err) {
+    const CachelotOptions shardedCache = {
+        .memory_limit = 4u*1024*1024,
+        .mem_page_size = 4096u,
+        .initial_dict_size = 1024u,
+        .enable_evictions = false,
+    };
+    CachelotShardedPtr c = cachelot_init_sharded(shardedCache, 4, out_err);
+    if (c == NULL) {
+        print_cachelot_error("test sharded: failed to create cache", out_err);
+        return false;
+    }
+    bool ret = true;
+    char buffer[4];
+    size_t valuelen;
+    if (!cachelot_sharded_add(c, new_key("Counter"), "0", 1, cachelot_infinite_TTL, out_err)
+        || cachelot_sharded_add(c, new_key("Counter"), "1", 1, cachelot_infinite_TTL, out_err)) {
+        print_cachelot_error("test sharded: add", out_err);
+        ret = false; goto cleanup;
+    }
+    if (cachelot_sharded_replace(c, new_key("Does not exist"), "", 0, cachelot_infinite_TTL, out_err)) {
+        print_cachelot_error("test sharded: non-existing item was replaced", out_err);
+        ret = false; goto cleanup;
+    }
+    // too small buffer
+    if (!cachelot_sharded_set(c, new_key("Item1"), "Value1", 6, cachelot_infinite_TTL, out_err)
+        || !cachelot_sharded_get(c, new_key("Item1"), buffer, sizeof(buffer), &valuelen, out_err) || valuelen != 6) {
+        print_cachelot_error("test sharded: get into small buffer", out_err);
+        ret = false; goto cleanup;
+    }
+    pthread_t threads[SHARDED_NUM_THREADS];
+    struct sharded_thread_args args[SHARDED_NUM_THREADS];
+    for (int n = 0; n < SHARDED_NUM_THREADS; ++n) {
+        args[n].cache = c;
+        args[n].thread_no = n;
+        pthread_create(&threads[n], NULL, &__sharded_thread, &args[n]);
+    }
+    for (int n = 0; n < SHARDED_NUM_THREADS; ++n) {
+        pthread_join(threads[n], NULL);
+        ret = ret && args[n].succeeded;
+    }
+    if (!ret) {
+        goto cleanup;
+    }
+    uint64_t counter;
+    if (!cachelot_sharded_incr(c, new_key("Counter"), 0, &counter, out_err) || counter != SHARDED_NUM_THREADS * SHARDED_NUM_KEYS) {
+        printf("test sharded: unexpected counter value %llu\n", (unsigned long long)counter);
+        ret = false; goto cleanup;
+    }
+    if (!cachelot_sharded_delete(c, new_key("Counter"), out_err) || cachelot_sharded_delete(c, new_key("Counter"), out_err)) {
+        print_cachelot_error("test sharded: delete", out_err);
+        ret = false; goto cleanup;
+    }
+    // flush_all removes only expired items
+    cachelot_sharded_flush_all(c, out_err);
+    if (!cachelot_sharded_get(c, new_key("Item1"), buffer, sizeof(buffer), &valuelen, out_err)) {
+        print_cachelot_error("test sharded: item was flushed", out_err);
+        ret = false; goto cleanup;
+    }
+    cleanup:
+        cachelot_destroy_sharded(c);
+    return ret;
+}
+
+
 int main() {
     printf("Testing ver. %s C API ....\n", cachelot_version());
     printf("memory_limit = %zu\n", options.memory_limit);
@@ -355,6 +530,11 @@ int main() {
         ret = 1;
         goto cleanup;
     }
+    if (! test_get_multi(cache, err)) {
+        print_cachelot_error("get_multi tests failed", err);
+        ret = 1;
+        goto cleanup;
+    }
     if (! test_arith(cache, err)) {
         print_cachelot_error("incr/decr tests failed", err);
         ret = 1;
@@ -375,6 +555,16 @@ int main() {
         ret = 1;
         goto cleanup;
     }
+    if (! test_huge_pages(err)) {
+        print_cachelot_error("huge pages tests failed", err);
+        ret = 1;
+        goto cleanup;
+    }
+    if (! test_sharded(err)) {
+        print_cachelot_error("sharded cache tests failed", err);
+        ret = 1;
+        goto cleanup;
+    }
     printf("All tests passes\n");
 
 cleanup:
@@ -1,5 +1,6 @@
 #include "unit_test.h"
 #include <cachelot/cache.h>
+#include <thread>
 
 namespace {
 
@@ -18,6 +19,298 @@ BOOST_AUTO_TEST_CASE(test_expiration) {
 }
 
 
+// there is no memalloc in the AddressSanitizer build
+#ifndef ADDRESS_SANITIZER
+
+BOOST_AUTO_TEST_CASE(test_cached_expiration_clock) {
+    static auto calc_hash = fnv1a<cache::Cache::hash_type>::hasher();
+    auto the_cache = cache::Cache::Create(16 * Kilobyte, 4 * Kilobyte, 16, true);
+    const auto key = slice::from_literal("expiring");
+    cache::ExpirationClock::set_cached(true);
+    BOOST_CHECK(cache::ExpirationClock::is_cached());
+    auto item = the_cache.create_item(key, calc_hash(key), 1, 0, cache::seconds(1));
+    item->assign_value(slice::from_literal("1"));
+    the_cache.do_set(item);
+    // time stands still until the next tick
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    BOOST_CHECK(the_cache.do_get(key, calc_hash(key)) != nullptr);
+    cache::ExpirationClock::tick();
+    BOOST_CHECK(the_cache.do_get(key, calc_hash(key)) == nullptr);
+    cache::ExpirationClock::set_cached(false);
+    BOOST_CHECK(not cache::ExpirationClock::is_cached());
+}
+
+BOOST_AUTO_TEST_CASE(test_pinned_items) {
+    static auto calc_hash = fnv1a<cache::Cache::hash_type>::hasher();
+    auto the_cache = cache::Cache::Create(16 * Kilobyte, 4 * Kilobyte, 16, true);
+    const auto set_item = [&the_cache](const string & k, const string & v) {
+        const auto key = slice(k.c_str(), k.length());
+        auto item = the_cache.create_item(key, calc_hash(key), v.length(), 0, cache::Item::infinite_TTL);
+        item->assign_value(slice(v.c_str(), v.length()));
+        the_cache.do_set(item);
+    };
+    const string value(3 * Kilobyte, 'x');
+    set_item("pinned", value);
+    auto pinned = the_cache.do_get(slice::from_literal("pinned"), calc_hash(slice::from_literal("pinned")));
+    BOOST_CHECK(pinned != nullptr);
+    the_cache.pin_item(pinned);
+    // replace pinned item and force evictions, its memory must remain intact
+    set_item("pinned", string(value.length(), 'y'));
+    for (int n = 0; n < 16; ++n) {
+        set_item(std::to_string(n), string(value.length(), 'z'));
+    }
+    BOOST_CHECK(pinned->key() == slice::from_literal("pinned"));
+    BOOST_CHECK(pinned->value() == slice(value.c_str(), value.length()));
+    the_cache.unpin_item(pinned);
+}
+
+BOOST_AUTO_TEST_CASE(test_admission_filter) {
+    static auto calc_hash = fnv1a<cache::Cache::hash_type>::hasher();
+    auto the_cache = cache::Cache::Create(16 * Kilobyte, 4 * Kilobyte, 16, true, cache::EvictionPolicy::page_lru, true);
+    const string value(900, 'x');
+    const auto set_item = [&the_cache, &value](const string & k) {
+        const auto key = slice(k.c_str(), k.length());
+        auto item = the_cache.create_item(key, calc_hash(key), value.length(), 0, cache::Item::infinite_TTL);
+        item->assign_value(slice(value.c_str(), value.length()));
+        the_cache.do_set(item);
+    };
+    const auto get_item = [&the_cache](const string & k) {
+        const auto key = slice(k.c_str(), k.length());
+        return the_cache.do_get(key, calc_hash(key));
+    };
+    // fill up the cache with the frequently used items
+    std::vector<string> hot_keys;
+    for (int n = 0; n < 16; ++n) {
+        hot_keys.push_back("hot" + std::to_string(n));
+        set_item(hot_keys.back());
+        for (int i = 0; i < 4; ++i) {
+            BOOST_CHECK(get_item(hot_keys.back()) != nullptr);
+        }
+    }
+    // one-time key can't push them out
+    BOOST_CHECK_THROW(set_item("once"), system_error);
+    BOOST_CHECK(get_item("once") == nullptr);
+    for (const auto & k : hot_keys) {
+        BOOST_CHECK(get_item(k) != nullptr);
+    }
+    // existing items are updated regardless of their frequency
+    set_item(hot_keys.front());
+    // key gets admitted once it's requested often enough
+    for (int i = 0; i < 8; ++i) {
+        get_item("frequent");
+    }
+    set_item("frequent");
+    BOOST_CHECK(get_item("frequent") != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(test_cache_without_cas) {
+    static auto calc_hash = fnv1a<cache::Cache::hash_type>::hasher();
+    auto the_cache = cache::Cache::Create(16 * Kilobyte, 4 * Kilobyte, 16, true, cache::EvictionPolicy::page_lru, false, false);
+    const auto key = slice::from_literal("Key");
+    const auto create_item = [&the_cache, &key](const slice value) {
+        auto item = the_cache.create_item(key, calc_hash(key), value.length(), 0, cache::Item::infinite_TTL);
+        item->assign_value(value);
+        return item;
+    };
+    the_cache.do_set(create_item(slice::from_literal("Value")));
+    auto item = the_cache.do_get(key, calc_hash(key));
+    BOOST_REQUIRE(item != nullptr);
+    BOOST_CHECK(not item->has_timestamp());
+    BOOST_CHECK_EQUAL(item->timestamp(), 0);
+    // items are re-created without the timestamp too
+    BOOST_CHECK(the_cache.do_append(create_item(slice::from_literal("Tail"))));
+    item = the_cache.do_get(key, calc_hash(key));
+    BOOST_CHECK(not item->has_timestamp());
+    BOOST_CHECK(item->value() == slice::from_literal("ValueTail"));
+    BOOST_CHECK_THROW(the_cache.do_cas(create_item(slice::from_literal("New")), 0), system_error);
+    BOOST_CHECK(the_cache.do_get(key, calc_hash(key))->value() == slice::from_literal("ValueTail"));
+}
+
+BOOST_AUTO_TEST_CASE(test_touch_item_without_expiration) {
+    static auto calc_hash = fnv1a<cache::Cache::hash_type>::hasher();
+    auto the_cache = cache::Cache::Create(16 * Kilobyte, 4 * Kilobyte, 16, true);
+    const auto key = slice::from_literal("Key");
+    auto item = the_cache.create_item(key, calc_hash(key), 5, 7, cache::Item::infinite_TTL);
+    item->assign_value(slice::from_literal("Value"));
+    const auto timestamp = item->timestamp();
+    the_cache.do_set(item);
+    // item is re-created with the expiration time
+    BOOST_CHECK(the_cache.do_touch(key, calc_hash(key), cache::seconds(100)));
+    auto touched = the_cache.do_get(key, calc_hash(key));
+    BOOST_REQUIRE(touched != nullptr);
+    BOOST_CHECK(touched->ttl() > cache::seconds(0));
+    BOOST_CHECK(touched->value() == slice::from_literal("Value"));
+    BOOST_CHECK_EQUAL(touched->opaque_flags(), 7);
+    BOOST_CHECK_EQUAL(touched->timestamp(), timestamp);
+    // and then updated in place
+    BOOST_CHECK(the_cache.do_touch(key, calc_hash(key), cache::Item::infinite_TTL));
+    BOOST_CHECK(the_cache.do_get(key, calc_hash(key)) == touched);
+    BOOST_CHECK(touched->ttl() == cache::Item::infinite_TTL);
+}
+
+BOOST_AUTO_TEST_CASE(test_value_compression) {
+    static auto calc_hash = fnv1a<cache::Cache::hash_type>::hasher();
+    auto the_cache = cache::Cache::Create(64 * Kilobyte, 16 * Kilobyte, 16, true, cache::EvictionPolicy::page_lru, false, true, 1024);
+    const auto set_item = [&the_cache](const string & k, const string & v) {
+        const auto key = slice(k.c_str(), k.length());
+        // value is compressed before allocation
+        the_cache.do_set(the_cache.create_item(key, calc_hash(key), slice(v.c_str(), v.length()), 0, cache::Item::infinite_TTL));
+    };
+    const auto get_item = [&the_cache](const string & k) {
+        const auto key = slice(k.c_str(), k.length());
+        return the_cache.do_get(key, calc_hash(key));
+    };
+    const auto uncompressed = [](cache::ConstItemPtr item) {
+        string value(item->uncompressed_length(), '\0');
+        item->uncompress_value(&value[0]);
+        return value;
+    };
+    string json;
+    while (json.size() < 8 * Kilobyte) {
+        json += "{\"key\": \"value\", \"number\": " + std::to_string(json.size()) + "}, ";
+    }
+    // short values are stored as is
+    set_item("short", json.substr(0, 1000));
+    BOOST_CHECK(not get_item("short")->is_compressed());
+    // long ones are compressed
+    set_item("long", json);
+    auto item = get_item("long");
+    BOOST_REQUIRE(item != nullptr);
+    BOOST_CHECK(item->is_compressed());
+    BOOST_CHECK(item->value().length() < json.size() / 2);
+    BOOST_CHECK_EQUAL(item->uncompressed_length(), json.size());
+    BOOST_CHECK(uncompressed(item) == json);
+    // compressed items take less memory, so more of them fit the cache
+    for (int n = 0; n < 32; ++n) {
+        set_item("json" + std::to_string(n), json);
+    }
+    for (int n = 0; n < 32; ++n) {
+        BOOST_CHECK(get_item("json" + std::to_string(n)) != nullptr);
+    }
+    // append works with uncompressed value, new item is compressed when stored
+    auto tail = the_cache.create_item(slice::from_literal("long"), calc_hash(slice::from_literal("long")), 4, 0, cache::Item::infinite_TTL);
+    tail->assign_value(slice::from_literal("tail"));
+    BOOST_CHECK(the_cache.do_append(tail));
+    item = get_item("long");
+    BOOST_CHECK(item->is_compressed());
+    BOOST_CHECK(uncompressed(item) == json + "tail");
+    // touch keeps value compressed
+    BOOST_CHECK(the_cache.do_touch(slice::from_literal("long"), calc_hash(slice::from_literal("long")), cache::seconds(100)));
+    item = get_item("long");
+    BOOST_CHECK(item->is_compressed());
+    BOOST_CHECK(uncompressed(item) == json + "tail");
+    BOOST_CHECK_THROW(cache::Cache::Create(64 * Kilobyte, 16 * Kilobyte, 16, true, cache::EvictionPolicy::page_lru, false, true, 10), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_chained_items) {
+    static auto calc_hash = fnv1a<cache::Cache::hash_type>::hasher();
+    const auto value_of = [](const string & k, const size_t length) {
+        string value(length, '\0');
+        for (size_t n = 0; n < length; ++n) {
+            value[n] = k[n % k.length()] + static_cast<char>(n % 7);
+        }
+        return value;
+    };
+    const auto gathered = [](cache::ConstItemPtr item) {
+        string value;
+        item->foreach_value_piece([&value](const slice piece) { value.append(piece.begin(), piece.length()); });
+        return value;
+    };
+    for (auto policy : { cache::EvictionPolicy::page_lru, cache::EvictionPolicy::item_clock }) {
+        auto the_cache = cache::Cache::Create(64 * Kilobyte, 4 * Kilobyte, 16, true, policy);
+        const auto set_item = [&](const string & k, const size_t length) {
+            const auto key = slice(k.c_str(), k.length());
+            const auto v = value_of(k, length);
+            the_cache.do_set(the_cache.create_item(key, calc_hash(key), slice(v.c_str(), v.length()), 0, cache::Item::infinite_TTL));
+        };
+        const auto get_item = [&the_cache](const string & k) {
+            const auto key = slice(k.c_str(), k.length());
+            return the_cache.do_get(key, calc_hash(key));
+        };
+        // value larger than the page is stored in the chain of chunks
+        set_item("large", 10 * Kilobyte);
+        auto item = get_item("large");
+        BOOST_REQUIRE(item != nullptr);
+        BOOST_CHECK(item->is_chained());
+        BOOST_CHECK_EQUAL(item->uncompressed_length(), 10 * Kilobyte);
+        size_t num_pieces = 0;
+        item->foreach_value_piece([&num_pieces](const slice) { num_pieces += 1; });
+        BOOST_CHECK_EQUAL(num_pieces, 3);
+        BOOST_CHECK(gathered(item) == value_of("large", 10 * Kilobyte));
+        string uncompressed(item->uncompressed_length(), '\0');
+        item->uncompress_value(&uncompressed[0]);
+        BOOST_CHECK(uncompressed == value_of("large", 10 * Kilobyte));
+        // append makes the chain longer
+        auto tail = the_cache.create_item(slice::from_literal("large"), calc_hash(slice::from_literal("large")), 4, 0, cache::Item::infinite_TTL);
+        tail->assign_value(slice::from_literal("tail"));
+        BOOST_CHECK(the_cache.do_append(tail));
+        item = get_item("large");
+        BOOST_CHECK(item->is_chained());
+        BOOST_CHECK(gathered(item) == value_of("large", 10 * Kilobyte) + "tail");
+        // chained item can always be made expiring in place
+        BOOST_CHECK(the_cache.do_touch(slice::from_literal("large"), calc_hash(slice::from_literal("large")), cache::seconds(100)));
+        BOOST_CHECK(get_item("large") == item);
+        // pinned chain survives the replacement and evictions
+        the_cache.pin_item(item);
+        set_item("large", 5 * Kilobyte);
+        for (int n = 0; n < 32; ++n) {
+            set_item("evict" + std::to_string(n), (n % 3 + 1) * 3 * Kilobyte);
+        }
+        BOOST_CHECK(gathered(item) == value_of("large", 10 * Kilobyte) + "tail");
+        the_cache.unpin_item(item);
+        // eviction of any part of the chain removes the whole item, the rest of items stay intact
+        for (int n = 0; n < 64; ++n) {
+            set_item("key" + std::to_string(n), n % 2 == 0 ? (n % 5 + 1) * 2 * Kilobyte : 100);
+            for (int m = 0; m <= n; ++m) {
+                const string k = "key" + std::to_string(m);
+                auto i = get_item(k);
+                if (i != nullptr) {
+                    BOOST_CHECK(gathered(i) == value_of(k, m % 2 == 0 ? (m % 5 + 1) * 2 * Kilobyte : 100));
+                }
+            }
+        }
+        BOOST_CHECK(get_item("key63") != nullptr);
+        // value must leave memory for the rest of items
+        BOOST_CHECK_THROW(set_item("huge", 33 * Kilobyte), system_error);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_background_rehash) {
+    static auto calc_hash = fnv1a<cache::Cache::hash_type>::hasher();
+    auto the_cache = cache::Cache::Create(1 * Megabyte, 4 * Kilobyte, 16, true, cache::EvictionPolicy::page_lru, false, true, 0, cache::ArenaOptions(), false, true);
+    const auto set_item = [&the_cache](const string & k) {
+        const auto key = slice(k.c_str(), k.length());
+        the_cache.do_set(the_cache.create_item(key, calc_hash(key), key, 0, cache::Item::infinite_TTL));
+    };
+    const auto has_item = [&the_cache](const string & k) {
+        const auto key = slice(k.c_str(), k.length());
+        return the_cache.do_get(key, calc_hash(key)) != nullptr;
+    };
+    // 11 items fill 75% of the threshold (93% of 16)
+    for (int n = 0; n < 11; ++n) {
+        set_item("key" + std::to_string(n));
+    }
+    the_cache.publish_stats();
+    BOOST_CHECK_EQUAL(STAT_GET(cache,hash_capacity), 16);
+    BOOST_CHECK_EQUAL(STAT_GET(cache,hash_is_expanding), false);
+    // table is expanded within the single call as it's small
+    BOOST_CHECK(not the_cache.do_background_work(std::chrono::milliseconds(100)));
+    the_cache.publish_stats();
+    BOOST_CHECK_EQUAL(STAT_GET(cache,hash_capacity), 32);
+    BOOST_CHECK_EQUAL(STAT_GET(cache,hash_is_expanding), false);
+    // requests expand the table themselves if there is no background work
+    for (int n = 11; n < 1000; ++n) {
+        set_item("key" + std::to_string(n));
+    }
+    for (int n = 0; n < 1000; ++n) {
+        BOOST_CHECK(has_item("key" + std::to_string(n)));
+    }
+    BOOST_CHECK(not the_cache.do_background_work(std::chrono::milliseconds(100)));
+}
+
+#endif // ifndef ADDRESS_SANITIZER
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
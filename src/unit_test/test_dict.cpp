@@ -2,19 +2,26 @@
 #include <cachelot/dict.h>
 #include <cachelot/random.h>
 #include <unordered_map>
+#include <vector>
 #include <functional>
 
 namespace {
 
 using namespace cachelot;
 
+struct GroupProbingOptions : internal::DefaultOptions {
+    static constexpr bool group_probing = true;
+};
+
 typedef dict<string, string> dict_type;
+typedef dict<string, string, std::equal_to<string>, internal::hash_table_entry<string, string>, GroupProbingOptions> group_dict_type;
 
 BOOST_AUTO_TEST_SUITE(test_dict)
 
 // insert several random elements into dict and std::unordered_map
 // and check their contents are equal
-BOOST_AUTO_TEST_CASE(test_dict_basic) {
+template <class dict_type>
+void check_dict_basic() {
     static const size_t num_elements = 100000;
     std::unordered_map<string, string> stock_map;
     dict_type the_dict;
@@ -24,7 +31,7 @@ BOOST_AUTO_TEST_CASE(test_dict_basic) {
         string key = random_string(14, 45);
         string value = random_string(4, 400);
         stock_map.insert(std::make_pair(key, value));
-        bool found; dict_type::iterator at; auto hash = hasher(key);
+        bool found; typename dict_type::iterator at; auto hash = hasher(key);
         tie(found, at) = the_dict.entry_for(key, hash);
         BOOST_CHECK(not found);
         the_dict.insert(at, key, hash, value);
@@ -37,7 +44,7 @@ BOOST_AUTO_TEST_CASE(test_dict_basic) {
         const string & key = kv.first;
         auto hash = hasher(key);
         BOOST_CHECK(the_dict.contains(key, hash));
-        bool found; dict_type::mapped_type dict_value;
+        bool found; typename dict_type::mapped_type dict_value;
         std::tie(found, dict_value) = the_dict.get(key, hash);
         BOOST_CHECK(found);
         BOOST_CHECK_EQUAL(kv.second, dict_value);
@@ -47,6 +54,213 @@ BOOST_AUTO_TEST_CASE(test_dict_basic) {
     BOOST_CHECK_EQUAL(the_dict.size(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(test_dict_basic) {
+    check_dict_basic<dict_type>();
+}
+
+BOOST_AUTO_TEST_CASE(test_dict_group_probing) {
+    check_dict_basic<group_dict_type>();
+}
+
+BOOST_AUTO_TEST_CASE(test_dict_concurrent_get) {
+    epoch_domain epochs;
+    group_dict_type the_dict(16);
+    the_dict.enable_concurrent_reads(epochs);
+    std::hash<string> hasher;
+    const auto concurrent_get = [&](const string & key) -> tuple<bool, bool, string> {
+        return the_dict.concurrent_get(hasher(key), [&](const string & value) { return value == "value of " + key; });
+    };
+    bool completed, found; string value;
+    std::tie(completed, found, value) = concurrent_get("missing");
+    BOOST_CHECK(completed && not found);
+    for (int n = 0; n < 1000; ++n) {
+        const string key = "key" + std::to_string(n);
+        bool __; group_dict_type::iterator at;
+        tie(__, at) = the_dict.entry_for(key, hasher(key));
+        the_dict.insert(at, key, hasher(key), "value of " + key);
+        std::tie(completed, found, value) = concurrent_get(key);
+        // readers fallback to the locked path while dict is expanding
+        BOOST_CHECK_EQUAL(completed, not the_dict.is_expanding());
+        if (completed) {
+            BOOST_CHECK(found);
+            BOOST_CHECK_EQUAL(value, "value of " + key);
+        }
+    }
+    // finish the expansion
+    while (the_dict.is_expanding()) {
+        the_dict.del("missing", hasher("missing"));
+    }
+    for (int n = 0; n < 1000; ++n) {
+        const string key = "key" + std::to_string(n);
+        std::tie(completed, found, value) = concurrent_get(key);
+        BOOST_CHECK(completed && found);
+        BOOST_CHECK(the_dict.del(key, hasher(key)));
+        std::tie(completed, found, value) = concurrent_get(key);
+        BOOST_CHECK(completed && not found);
+    }
+}
+
+// expansion is done by rehash_step() and falls back to the update operations only if it's not called
+template <class dict_type>
+void check_dict_background_rehash() {
+    static const size_t initial_size = 1024;
+    // threshold is at 93% of the capacity, background expansion begins at 75% of it
+    static const size_t num_before_expansion = initial_size * 93 / 100 * 75 / 100;
+    dict_type the_dict(initial_size, true);
+    BOOST_CHECK(the_dict.background_rehash());
+    std::hash<string> hasher;
+    std::vector<string> keys;
+    const auto insert_next = [&]() {
+        keys.push_back("key" + std::to_string(keys.size()));
+        const string & key = keys.back();
+        bool found; typename dict_type::iterator at;
+        std::tie(found, at) = the_dict.entry_for(key, hasher(key));
+        BOOST_CHECK(not found);
+        the_dict.insert(at, key, hasher(key), key);
+    };
+    const auto check_contents = [&]() {
+        BOOST_CHECK_EQUAL(the_dict.size(), keys.size());
+        for (const auto & key : keys) {
+            bool found; string value;
+            std::tie(found, value) = the_dict.get(key, hasher(key));
+            BOOST_CHECK(found);
+            BOOST_CHECK_EQUAL(value, key);
+        }
+    };
+    // nothing to do until the table is filled enough
+    while (keys.size() < num_before_expansion - 1) {
+        insert_next();
+    }
+    BOOST_CHECK(not the_dict.rehash_step(64));
+    insert_next();
+    BOOST_CHECK(not the_dict.is_expanding());
+    BOOST_CHECK_EQUAL(the_dict.capacity(), initial_size);
+    // new table is allocated by the background step only
+    BOOST_CHECK(the_dict.rehash_step(64));
+    BOOST_CHECK(the_dict.is_expanding());
+    BOOST_CHECK_EQUAL(the_dict.capacity(), initial_size * 2);
+    // update operations don't move items
+    for (size_t n = 0; n < 100; ++n) {
+        insert_next();
+    }
+    BOOST_CHECK(the_dict.is_expanding());
+    check_contents();
+    size_t num_steps = 0;
+    while (the_dict.rehash_step(64)) {
+        num_steps += 1;
+    }
+    BOOST_CHECK(num_steps >= num_before_expansion / 64);
+    BOOST_CHECK(not the_dict.is_expanding());
+    check_contents();
+    // without background steps update operations expand the table
+    while (keys.size() < initial_size * 16) {
+        insert_next();
+    }
+    BOOST_CHECK(the_dict.capacity() >= initial_size * 16);
+    check_contents();
+    for (const auto & key : keys) {
+        BOOST_CHECK(the_dict.del(key, hasher(key)));
+    }
+    BOOST_CHECK(the_dict.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_dict_background_rehash) {
+    check_dict_background_rehash<dict_type>();
+    check_dict_background_rehash<group_dict_type>();
+}
+
+// table shrinks back after the mass removal, but not below its initial size
+template <class dict_type>
+void check_dict_shrink(const bool background_rehash) {
+    static const size_t initial_size = 64;
+    static const size_t num_elements = 20000;
+    dict_type the_dict(initial_size, background_rehash);
+    std::hash<string> hasher;
+    const auto key_of = [](size_t n) { return "key" + std::to_string(n); };
+    // update operations do the work themselves unless it's left to the background
+    const auto rehash_all = [&]() {
+        while (background_rehash && the_dict.rehash_step(64)) {
+        }
+    };
+    for (size_t n = 0; n < num_elements; ++n) {
+        const string key = key_of(n);
+        bool found; typename dict_type::iterator at;
+        std::tie(found, at) = the_dict.entry_for(key, hasher(key));
+        the_dict.insert(at, key, hasher(key), key);
+    }
+    rehash_all();
+    const auto peak_capacity = the_dict.capacity();
+    BOOST_CHECK(peak_capacity >= 32768);
+    // remove 99% of items
+    for (size_t n = 0; n < num_elements; ++n) {
+        if (n % 100 != 0) {
+            const string key = key_of(n);
+            BOOST_CHECK(the_dict.del(key, hasher(key)));
+        }
+    }
+    // removal leaves it to the caller
+    BOOST_CHECK_EQUAL(the_dict.capacity(), peak_capacity);
+    the_dict.shrink_if_sparse();
+    rehash_all();
+    BOOST_CHECK(not the_dict.is_expanding());
+    BOOST_CHECK_EQUAL(the_dict.size(), num_elements / 100);
+    BOOST_CHECK(the_dict.capacity() <= 1024);
+    for (size_t n = 0; n < num_elements; n += 100) {
+        const string key = key_of(n);
+        bool found; string value;
+        std::tie(found, value) = the_dict.get(key, hasher(key));
+        BOOST_CHECK(found);
+        BOOST_CHECK_EQUAL(value, key);
+    }
+    // table is sparse again once the rest is removed
+    the_dict.remove_if([](const string &) { return true; });
+    the_dict.shrink_if_sparse();
+    rehash_all();
+    BOOST_CHECK(the_dict.empty());
+    BOOST_CHECK(not the_dict.is_expanding());
+    BOOST_CHECK_EQUAL(the_dict.capacity(), initial_size);
+}
+
+BOOST_AUTO_TEST_CASE(test_dict_shrink) {
+    check_dict_shrink<dict_type>(false);
+    check_dict_shrink<dict_type>(true);
+    check_dict_shrink<group_dict_type>(false);
+    check_dict_shrink<group_dict_type>(true);
+}
+
+// steady-size set/delete workload must not grow the table, even when deleted slots fill it up
+template <class dict_type>
+void check_dict_steady_size(const bool background_rehash) {
+    static const size_t initial_size = 1024;
+    static const size_t num_live = 400;
+    dict_type the_dict(initial_size, background_rehash);
+    std::hash<string> hasher;
+    const auto key_of = [](size_t n) { return "key" + std::to_string(n); };
+    size_t max_capacity = 0;
+    for (size_t n = 0; n < 200000; ++n) {
+        const string key = key_of(n);
+        bool found; typename dict_type::iterator at;
+        std::tie(found, at) = the_dict.entry_for(key, hasher(key));
+        BOOST_CHECK(not found);
+        the_dict.insert(at, key, hasher(key), key);
+        if (n >= num_live) {
+            const string old_key = key_of(n - num_live);
+            BOOST_CHECK(the_dict.del(old_key, hasher(old_key)));
+        }
+        while (background_rehash && the_dict.rehash_step(64)) {
+        }
+        max_capacity = std::max<size_t>(max_capacity, the_dict.capacity());
+    }
+    BOOST_CHECK_EQUAL(max_capacity, initial_size);
+    BOOST_CHECK_EQUAL(the_dict.size(), num_live);
+}
+
+BOOST_AUTO_TEST_CASE(test_dict_steady_size) {
+    check_dict_steady_size<dict_type>(false);
+    check_dict_steady_size<group_dict_type>(false);
+    check_dict_steady_size<group_dict_type>(true);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
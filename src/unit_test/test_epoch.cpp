@@ -0,0 +1,94 @@
+#include "unit_test.h"
+#include <cachelot/epoch.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace cachelot;
+
+BOOST_AUTO_TEST_SUITE(test_epoch)
+
+BOOST_AUTO_TEST_CASE(test_reclaim) {
+    epoch_domain epochs;
+    int first = 1, second = 2;
+    std::vector<void *> reclaimed;
+    const auto collect = [&reclaimed](void * ptr) { reclaimed.push_back(ptr); };
+    // nobody reads
+    epochs.retire(&first);
+    BOOST_CHECK_EQUAL(epochs.num_retired(), 1);
+    BOOST_CHECK_EQUAL(epochs.reclaim(collect), 1);
+    BOOST_REQUIRE_EQUAL(reclaimed.size(), 1);
+    BOOST_CHECK_EQUAL(reclaimed[0], &first);
+    reclaimed.clear();
+    // reader which entered before the removal blocks reclamation
+    {
+        epoch_domain::read_guard reader(epochs);
+        BOOST_REQUIRE(reader.ok());
+        BOOST_CHECK(reader.slot() < epoch_domain::max_readers);
+        epochs.retire(&second);
+        BOOST_CHECK_EQUAL(epochs.reclaim(collect), 0);
+        BOOST_CHECK_EQUAL(epochs.num_retired(), 1);
+    }
+    // reader which entered after the removal does not
+    {
+        epoch_domain::read_guard reader(epochs);
+        BOOST_CHECK_EQUAL(epochs.reclaim(collect), 1);
+        BOOST_REQUIRE_EQUAL(reclaimed.size(), 1);
+        BOOST_CHECK_EQUAL(reclaimed[0], &second);
+    }
+    BOOST_CHECK_EQUAL(epochs.num_retired(), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_synchronize) {
+    epoch_domain epochs;
+    // nobody reads, returns immediately
+    epochs.synchronize();
+    std::atomic<bool> entered(false);
+    std::atomic<bool> leaving(false);
+    std::thread reader_thread([&]() {
+        epoch_domain::read_guard reader(epochs);
+        entered.store(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        leaving.store(true);
+    });
+    while (not entered.load()) {
+        std::this_thread::yield();
+    }
+    epochs.synchronize();
+    BOOST_CHECK(leaving.load());
+    reader_thread.join();
+}
+
+
+BOOST_AUTO_TEST_CASE(test_reader_slots) {
+    epoch_domain epochs;
+    constexpr size_t num_threads = 8;
+    std::vector<size_t> slots(num_threads, size_t(epoch_domain::max_readers));
+    std::atomic<size_t> num_entered(0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            epoch_domain::read_guard reader(epochs);
+            if (reader.ok()) {
+                slots[t] = reader.slot();
+            }
+            // hold the slot until every thread got its own
+            num_entered.fetch_add(1);
+            while (num_entered.load() < num_threads) {
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    std::sort(slots.begin(), slots.end());
+    BOOST_CHECK(slots.back() < epoch_domain::max_readers);
+    BOOST_CHECK(std::adjacent_find(slots.begin(), slots.end()) == slots.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // anonymous namespace
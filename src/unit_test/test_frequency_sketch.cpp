@@ -0,0 +1,49 @@
+#include "unit_test.h"
+#include <cachelot/frequency_sketch.h>
+
+namespace {
+
+using namespace cachelot;
+
+BOOST_AUTO_TEST_SUITE(test_frequency_sketch)
+
+BOOST_AUTO_TEST_CASE(test_estimate) {
+    frequency_sketch<uint32> sketch(1000);
+    BOOST_CHECK_EQUAL(sketch.num_counters(), 1024);
+    for (uint32 hash = 0; hash < 1000; ++hash) {
+        BOOST_CHECK_EQUAL(sketch.estimate(hash), 0);
+    }
+    // count-min sketch never underestimates
+    for (uint32 hash = 0; hash < 100; ++hash) {
+        for (uint32 n = 0; n < hash % 8; ++n) {
+            sketch.increment(hash);
+        }
+    }
+    for (uint32 hash = 0; hash < 100; ++hash) {
+        BOOST_CHECK(sketch.estimate(hash) >= hash % 8);
+    }
+    // counters are saturated at the max value
+    for (uint32 n = 0; n < 100; ++n) {
+        sketch.increment(7777);
+    }
+    BOOST_CHECK_EQUAL(sketch.estimate(7777), frequency_sketch<uint32>::max_frequency);
+}
+
+BOOST_AUTO_TEST_CASE(test_aging) {
+    frequency_sketch<uint32> sketch(1024);
+    for (uint32 n = 0; n < 12; ++n) {
+        sketch.increment(42);
+    }
+    BOOST_CHECK_EQUAL(sketch.estimate(42), 12);
+    sketch.age();
+    BOOST_CHECK_EQUAL(sketch.estimate(42), 6);
+    // sketch ages itself after the `num_counters()` increments
+    for (uint32 hash = 1000; hash < 1000 + sketch.num_counters(); ++hash) {
+        sketch.increment(hash);
+    }
+    BOOST_CHECK(sketch.estimate(42) < 6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
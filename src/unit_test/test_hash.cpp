@@ -0,0 +1,75 @@
+#include "unit_test.h"
+#include <cachelot/hash_function.h>
+
+namespace {
+
+using namespace cachelot;
+
+BOOST_AUTO_TEST_SUITE(test_hash)
+
+BOOST_AUTO_TEST_CASE(test_crc32c) {
+    // check value of the CRC-32C
+    const slice check_str = slice::from_literal("123456789");
+    BOOST_CHECK_EQUAL(~internal::crc32c_software(~uint32(0), check_str), 0xE3069283u);
+#if defined(CACHELOT_HAS_CRC32C_INSTRUCTION)
+    if (crc32c_hasher::hardware_supported()) {
+        BOOST_CHECK_EQUAL(~internal::crc32c_hardware(~uint32(0), check_str), 0xE3069283u);
+        // hardware and software calculations must match on any length and alignment
+        const string data = random_string(300, 300);
+        for (size_t offset = 0; offset < 8; ++offset) {
+            for (size_t length = 0; length < data.size() - offset; length += 7) {
+                const slice piece(data.c_str() + offset, length);
+                BOOST_CHECK_EQUAL(internal::crc32c_hardware(0, piece), internal::crc32c_software(0, piece));
+            }
+        }
+    }
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(test_wyhash) {
+    // reference test vectors of the wyhash (the seed is the index of a message)
+    static const char * const messages[] = {
+        "",
+        "a",
+        "abc",
+        "message digest",
+        "abcdefghijklmnopqrstuvwxyz",
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+        "12345678901234567890123456789012345678901234567890123456789012345678901234567890"
+    };
+    static const uint64 expected[] = {
+        0x0409638ee2bde459ull,
+        0xa8412d091b5fe0a9ull,
+        0x32dd92e4b2915153ull,
+        0x8619124089a3a16bull,
+        0x7a43afb61d7f5f40ull,
+        0xff42329b90e50d58ull,
+        0xc39cab13b115aad3ull
+    };
+    for (size_t n = 0; n < sizeof(expected) / sizeof(expected[0]); ++n) {
+        BOOST_CHECK_EQUAL(internal::wyhash64(slice(messages[n], std::strlen(messages[n])), n), expected[n]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_selectable_hasher) {
+    typedef selectable_hasher<uint32> hasher_type;
+    const hash_algorithm initial = hasher_type::selected();
+    const slice key = slice::from_literal("some:key:12345");
+    hash_algorithm algorithm;
+    BOOST_CHECK(not hash_algorithm_from_name(slice::from_literal("md5"), algorithm));
+    BOOST_CHECK(hash_algorithm_from_name(slice::from_literal("fnv1a"), algorithm));
+    hasher_type::select(algorithm);
+    BOOST_CHECK(hasher_type::selected() == hash_algorithm::fnv1a);
+    BOOST_CHECK_EQUAL(hasher_type()(key), fnv1a<uint32>::hasher()(key));
+    BOOST_CHECK(hash_algorithm_from_name(slice::from_literal("crc32c"), algorithm));
+    hasher_type::select(algorithm);
+    BOOST_CHECK_EQUAL(hasher_type()(key), crc32c_hasher()(key));
+    BOOST_CHECK(hash_algorithm_from_name(slice::from_literal("wyhash"), algorithm));
+    hasher_type::select(algorithm);
+    BOOST_CHECK_EQUAL(hasher_type()(key), wyhash<uint32>::hasher()(key));
+    hasher_type::select(initial);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // anonymous namespace
@@ -1,11 +1,19 @@
 #include "unit_test.h"
 #include <cachelot/hash_table.h>
+#include <cachelot/group_hash_table.h>
+#include <cachelot/random.h>
+#include <unordered_map>
 
 namespace {
 
 using namespace cachelot;
 
+struct GroupProbingOptions : internal::DefaultOptions {
+    static constexpr bool group_probing = true;
+};
+
 typedef hash_table<string, void *, std::equal_to<string>> table_type;
+typedef group_hash_table<string, void *, std::equal_to<string>, internal::hash_table_entry<string, void *>, GroupProbingOptions> group_table_type;
 typedef table_type::hash_type hash_type;
 
 BOOST_AUTO_TEST_SUITE(test_hash_table)
@@ -19,7 +27,8 @@ BOOST_AUTO_TEST_CASE(test_hash_table_low_level_operations) {
 
 
 // test operations add / insert / get / replace  / del
-BOOST_AUTO_TEST_CASE(test_hash_table_operations) {
+template <class table_type>
+void check_table_operations() {
     static const size_t DefaultCapacity = 16;
     table_type the_dict(DefaultCapacity);
     // check initial state
@@ -43,7 +52,7 @@ BOOST_AUTO_TEST_CASE(test_hash_table_operations) {
     BOOST_CHECK(the_dict.put("some key 5", the_hash, the_value) == true);
     // check stored value
     bool found;
-    table_type::mapped_type value;
+    typename table_type::mapped_type value;
     tie(found, value) = the_dict.get(the_key, the_hash);
     BOOST_CHECK(found && value == the_value);
     // check that now hash_table is non-empty
@@ -92,6 +101,124 @@ BOOST_AUTO_TEST_CASE(test_hash_table_operations) {
 }
 
 
+BOOST_AUTO_TEST_CASE(test_hash_table_operations) {
+    check_table_operations<table_type>();
+}
+
+
+BOOST_AUTO_TEST_CASE(test_group_hash_table_operations) {
+    check_table_operations<group_table_type>();
+}
+
+
+// fill group_hash_table up to the threshold with interleaved deletions to produce deleted slots
+BOOST_AUTO_TEST_CASE(test_group_hash_table_deleted_slots) {
+    static const size_t Capacity = 1024;
+    group_table_type table(Capacity);
+    std::unordered_map<string, hash_type> stock_map;
+    std::hash<string> hasher;
+    size_t n = 0;
+    while (not table.threshold_reached()) {
+        string key = random_string(10, 20) + std::to_string(n++);
+        auto hash = hasher(key);
+        BOOST_CHECK(table.put(key, hash, nullptr));
+        stock_map[key] = hash;
+        if (n % 3 == 0) {
+            // delete some random element
+            auto victim = stock_map.begin();
+            BOOST_CHECK(table.del(victim->first, victim->second));
+            stock_map.erase(victim);
+        }
+    }
+    BOOST_CHECK_EQUAL(table.size(), stock_map.size());
+    for (const auto & kv : stock_map) {
+        BOOST_CHECK(table.contains(kv.first, kv.second));
+    }
+    // check lookup of missing keys terminates
+    for (size_t i = 0; i < 1000; ++i) {
+        string key = "missing" + std::to_string(i);
+        BOOST_CHECK(not table.contains(key, hasher(key)));
+    }
+    table.remove_if([](void *) { return true; });
+    BOOST_CHECK(table.empty());
+}
+
+
+// entry counting reads of its key, with the fingerprint of the key
+size_t num_key_reads = 0;
+size_t num_fingerprints = 0;
+
+struct counting_entry : internal::hash_table_entry<string, void *> {
+    counting_entry() = default;
+    explicit counting_entry(const string & the_key, void * const & the_value) : internal::hash_table_entry<string, void *>(the_key, the_value) {}
+
+    const string & key() const noexcept {
+        num_key_reads += 1;
+        return internal::hash_table_entry<string, void *>::key();
+    }
+
+    static uint32 fingerprint(const string & key) noexcept {
+        num_fingerprints += 1;
+        return static_cast<uint32>(std::hash<string>()(key + "#"));
+    }
+};
+
+struct FingerprintOptions : GroupProbingOptions {
+    static constexpr bool key_fingerprints = true;
+};
+
+// keys are compared only if both the hash and the fingerprint match
+BOOST_AUTO_TEST_CASE(test_group_hash_table_key_fingerprints) {
+    group_hash_table<string, void *, std::equal_to<string>, counting_entry, FingerprintOptions> table(1024);
+    // every key has the same hash
+    const hash_type hash = 42;
+    for (size_t n = 0; n < 500; ++n) {
+        BOOST_CHECK(table.put("key" + std::to_string(n), hash, nullptr));
+    }
+    num_key_reads = 0;
+    for (size_t n = 0; n < 500; ++n) {
+        BOOST_CHECK(table.contains("key" + std::to_string(n), hash));
+        BOOST_CHECK(not table.contains("missing" + std::to_string(n), hash));
+    }
+    // the only one key comparison per hit
+    BOOST_CHECK_EQUAL(num_key_reads, 500);
+    for (size_t n = 0; n < 500; n += 2) {
+        BOOST_CHECK(table.del("key" + std::to_string(n), hash));
+    }
+    BOOST_CHECK_EQUAL(table.size(), 250);
+    for (size_t n = 0; n < 500; ++n) {
+        BOOST_CHECK_EQUAL(table.contains("key" + std::to_string(n), hash), n % 2 != 0);
+    }
+}
+
+// moved entries keep their fingerprints, keys are neither read nor fingerprinted again
+BOOST_AUTO_TEST_CASE(test_group_hash_table_move_from) {
+    typedef group_hash_table<string, void *, std::equal_to<string>, counting_entry, FingerprintOptions> table_type;
+    table_type from(512), to(1024);
+    const hash_type hash = 42;
+    for (size_t n = 0; n < 400; ++n) {
+        BOOST_CHECK(from.put("key" + std::to_string(n), hash, nullptr));
+    }
+    num_key_reads = 0;
+    num_fingerprints = 0;
+    for (size_t pos = 0; pos < from.capacity(); ++pos) {
+        if (not from.empty_at(pos)) {
+            const size_t new_pos = to.move_from(from, pos);
+            BOOST_CHECK(not to.empty_at(new_pos));
+        }
+    }
+    BOOST_CHECK_EQUAL(num_key_reads, 0);
+    BOOST_CHECK_EQUAL(num_fingerprints, 0);
+    BOOST_CHECK(from.empty());
+    BOOST_CHECK_EQUAL(to.size(), 400);
+    for (size_t n = 0; n < 400; ++n) {
+        BOOST_CHECK(to.contains("key" + std::to_string(n), hash));
+    }
+    // fingerprints were copied, so there is still the only one key comparison per hit
+    BOOST_CHECK_EQUAL(num_key_reads, 400);
+}
+
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
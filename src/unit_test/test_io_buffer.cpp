@@ -62,6 +62,78 @@ BOOST_AUTO_TEST_CASE(test_io_buffer_savepoint) {
     BOOST_CHECK_EQUAL(buf.non_read(), 16);
 }
 
+BOOST_AUTO_TEST_CASE(test_io_buffer_external) {
+    io_buffer buf(0, 64);
+    buf.enable_external();
+    static const char external[] = "external";
+    size_t num_released = 0;
+    const auto release = [&num_released]() { num_released += 1; };
+    const auto gather = [&buf]() -> string {
+        string result;
+        buf.for_each_non_read([&result](const slice piece) { result.append(piece.begin(), piece.length()); });
+        return result;
+    };
+    // write [head][external][tail]
+    std::memcpy(buf.begin_write(4), "head", 4);
+    buf.confirm_write(4);
+    buf.write_external(slice(external, std::strlen(external)), release);
+    std::memcpy(buf.begin_write(4), "tail", 4);
+    buf.confirm_write(4);
+    BOOST_CHECK_EQUAL(buf.non_read(), 8);
+    BOOST_CHECK_EQUAL(buf.non_read_with_external(), 8 + std::strlen(external));
+    BOOST_CHECK_EQUAL(gather(), string("headexternaltail"));
+    // rollback releases only data written after the savepoint
+    auto w_savepoint = buf.write_savepoint();
+    buf.write_external(slice(external, std::strlen(external)), release);
+    BOOST_CHECK_EQUAL(gather(), string("headexternaltailexternal"));
+    buf.rollback_write_transaction(w_savepoint);
+    BOOST_CHECK_EQUAL(num_released, 1);
+    BOOST_CHECK_EQUAL(gather(), string("headexternaltail"));
+    // external data is released when buffer is read and compacted
+    buf.read_all();
+    buf.compact();
+    BOOST_CHECK_EQUAL(num_released, 2);
+    BOOST_CHECK_EQUAL(buf.non_read_with_external(), 0);
+    BOOST_CHECK_EQUAL(gather(), string());
+    // external data is released on reset
+    buf.write_external(slice(external, std::strlen(external)), release);
+    BOOST_CHECK_EQUAL(gather(), string("external"));
+    buf.reset();
+    BOOST_CHECK_EQUAL(num_released, 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_io_buffer_external_receive) {
+    char dest[16] = { 0 };
+    std::vector<bool> completions;
+    const auto on_received = [&completions](bool received) { completions.push_back(received); };
+    {
+        io_buffer buf(0, 64);
+        buf.enable_external();
+        BOOST_CHECK(not buf.external_receive_pending());
+        buf.receive_external(dest, 8, on_received);
+        BOOST_CHECK(buf.external_receive_pending());
+        BOOST_CHECK(buf.external_receive_dest() == dest);
+        BOOST_CHECK_EQUAL(buf.external_receive_length(), 8);
+        // owner fills the memory and completes the request
+        std::memcpy(buf.external_receive_dest(), "external", 8);
+        buf.complete_external_receive();
+        BOOST_CHECK(not buf.external_receive_pending());
+        BOOST_CHECK_EQUAL(completions.size(), 1);
+        BOOST_CHECK(completions.back() == true);
+        BOOST_CHECK_EQUAL(string(dest, 8), string("external"));
+        // pending request is cancelled on reset
+        buf.receive_external(dest, 8, on_received);
+        buf.reset();
+        BOOST_CHECK(not buf.external_receive_pending());
+        BOOST_CHECK_EQUAL(completions.size(), 2);
+        BOOST_CHECK(completions.back() == false);
+        // and when buffer is destroyed
+        buf.receive_external(dest, 8, on_received);
+    }
+    BOOST_CHECK_EQUAL(completions.size(), 3);
+    BOOST_CHECK(completions.back() == false);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // anonymouse namespace
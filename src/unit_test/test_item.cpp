@@ -3,5 +3,132 @@
 
 namespace {
 
+using namespace cachelot;
+
+BOOST_AUTO_TEST_SUITE(test_item)
+
+typedef cache::Item::timestamp_type timestamp_type;
+typedef cache::Item::opaque_flags_type opaque_flags_type;
+
+BOOST_AUTO_TEST_CASE(test_item_without_timestamp) {
+    const auto key = slice::from_literal("Key");
+    const auto value = slice::from_literal("Value");
+    const size_t with_cas = cache::Item::CalcSizeRequired(key, value.length(), 2, cache::Item::infinite_TTL, true);
+    const size_t without_cas = cache::Item::CalcSizeRequired(key, value.length(), 2, cache::Item::infinite_TTL, false);
+    BOOST_CHECK_EQUAL(with_cas - without_cas, sizeof(timestamp_type));
+    uint8 mem1[64], mem2[64];
+    BOOST_REQUIRE(with_cas <= sizeof(mem1));
+    auto i1 = new (mem1) cache::Item(key, 1, value.length(), 2, cache::Item::infinite_TTL, timestamp_type(42));
+    i1->assign_value(value);
+    BOOST_CHECK(i1->has_timestamp());
+    BOOST_CHECK_EQUAL(i1->timestamp(), 42);
+    auto i2 = new (mem2) cache::Item(key, 1, value.length(), 2, cache::Item::infinite_TTL);
+    i2->assign_value(value);
+    BOOST_CHECK(not i2->has_timestamp());
+    BOOST_CHECK_EQUAL(i2->timestamp(), 0);
+    // the rest of item is the same
+    for (auto i : { i1, i2 }) {
+        BOOST_CHECK(i->key() == key);
+        BOOST_CHECK(i->value() == value);
+        BOOST_CHECK_EQUAL(i->opaque_flags(), 2);
+        BOOST_CHECK_EQUAL(i->hash(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_compact_header) {
+    const auto key = slice::from_literal("Key");
+    const auto value = slice::from_literal("Value");
+    const size_t minimal = cache::Item::CalcSizeRequired(key, value.length(), 0, cache::Item::infinite_TTL, false);
+    // hash, key length, header format and the single byte of value length
+    BOOST_CHECK_EQUAL(minimal, sizeof(cache::Item::hash_type) + 3 + key.length() + value.length());
+    // optional fields take room only when present
+    BOOST_CHECK_EQUAL(cache::Item::CalcSizeRequired(key, value.length(), 1, cache::Item::infinite_TTL, false), minimal + sizeof(opaque_flags_type));
+    BOOST_CHECK_EQUAL(cache::Item::CalcSizeRequired(key, value.length(), 0, cache::seconds(1), false), minimal + sizeof(cache::Item::expiration_time_point));
+    BOOST_CHECK_EQUAL(cache::Item::CalcSizeRequired(key, value.length(), 0, cache::Item::infinite_TTL, false, true), minimal + sizeof(cache::Item::expiration_time_point));
+    // value length takes as few bytes as needed
+    BOOST_CHECK_EQUAL(cache::Item::CalcSizeRequired(key, 255, 0, cache::Item::infinite_TTL, false) - 255, minimal - value.length());
+    BOOST_CHECK_EQUAL(cache::Item::CalcSizeRequired(key, 256, 0, cache::Item::infinite_TTL, false) - 256, minimal - value.length() + 1);
+    BOOST_CHECK_EQUAL(cache::Item::CalcSizeRequired(key, 0x1000000, 0, cache::Item::infinite_TTL, false) - 0x1000000, minimal - value.length() + 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_item_fields) {
+    std::vector<uint8> mem(1024);
+    const auto key = slice::from_literal("Key");
+    const string long_value(300, 'x');
+    for (size_t offset = 0; offset < 8; ++offset) {
+        // header fields are unaligned
+        auto i = new (mem.data() + offset) cache::Item(key, 0xDEADBEEF, long_value.length(), 0xABCD, cache::seconds(100), timestamp_type(0x0102030405060708ull));
+        i->assign_value(slice(long_value.c_str(), long_value.length()));
+        BOOST_CHECK_EQUAL(i->hash(), 0xDEADBEEF);
+        BOOST_CHECK_EQUAL(i->opaque_flags(), 0xABCD);
+        BOOST_CHECK_EQUAL(i->timestamp(), 0x0102030405060708ull);
+        BOOST_CHECK(i->ttl() <= cache::seconds(100) && i->ttl() >= cache::seconds(99));
+        BOOST_CHECK(i->key() == key);
+        BOOST_CHECK(i->value() == slice(long_value.c_str(), long_value.length()));
+        // value length keeps its width when value shrinks
+        i->truncate_value(10);
+        BOOST_CHECK(i->value() == slice(long_value.c_str(), 10));
+        BOOST_CHECK(i->key() == key);
+        BOOST_CHECK(i->set_ttl(cache::Item::infinite_TTL));
+        BOOST_CHECK(i->ttl() == cache::Item::infinite_TTL);
+    }
+    // item without expiration time can't get one
+    auto i = new (mem.data()) cache::Item(key, 1, 0, 0, cache::Item::infinite_TTL);
+    BOOST_CHECK(not i->is_expired());
+    BOOST_CHECK(i->set_ttl(cache::Item::infinite_TTL));
+    BOOST_CHECK(not i->set_ttl(cache::seconds(1)));
+    BOOST_CHECK(i->ttl() == cache::Item::infinite_TTL);
+    BOOST_CHECK_EQUAL(i->opaque_flags(), 0);
+    BOOST_CHECK(i->value().empty());
+    // unless it was reserved
+    const bool mutable_ttl = true;
+    i = new (mem.data()) cache::Item(key, 1, 0, 0, cache::Item::infinite_TTL, mutable_ttl);
+    BOOST_CHECK(i->ttl() == cache::Item::infinite_TTL);
+    BOOST_CHECK(i->set_ttl(cache::seconds(10)));
+    BOOST_CHECK(i->ttl() > cache::seconds(0));
+}
+
+BOOST_AUTO_TEST_CASE(test_chained_item) {
+    const auto key = slice::from_literal("Key");
+    const string value = "Value stored in three chunks";
+    const size_t head_size = cache::Item::CalcHeadSizeRequired(key, value.length(), 0, cache::Item::infinite_TTL);
+    BOOST_CHECK(head_size < cache::Item::CalcSizeRequired(key, value.length(), 0, cache::Item::infinite_TTL));
+    alignas(8) uint8 head_mem[64];
+    alignas(8) uint8 chunk_mem[3][64];
+    auto i = new (head_mem) cache::Item(key, 0xDEADBEEF, value.length(), 0, cache::Item::infinite_TTL, timestamp_type(1));
+    const uint32 chunk_lengths[3] = { 10, 10, 8 };
+    cache::Item::Chunk * prev = nullptr;
+    for (int n = 0; n < 3; ++n) {
+        auto chunk = new (chunk_mem[n]) cache::Item::Chunk(i, chunk_lengths[n]);
+        if (prev != nullptr) {
+            prev->set_next(chunk);
+        } else {
+            i->attach_chunks(chunk);
+        }
+        prev = chunk;
+    }
+    BOOST_CHECK(i->is_chained());
+    BOOST_CHECK_EQUAL(i->size(), head_size);
+    BOOST_CHECK(not cache::Item::IsChunk(i));
+    i->assign_value(slice(value.c_str(), value.length()));
+    string gathered;
+    int n = 0;
+    i->foreach_value_piece([&](const slice piece) {
+        BOOST_CHECK(cache::Item::IsChunk(chunk_mem[n]));
+        BOOST_CHECK(reinterpret_cast<cache::Item::Chunk *>(chunk_mem[n])->owner() == i);
+        // chunk looks like its owner to the eviction
+        BOOST_CHECK_EQUAL(reinterpret_cast<cache::Item *>(chunk_mem[n])->hash(), i->hash());
+        BOOST_CHECK_EQUAL(piece.length(), chunk_lengths[n++]);
+        gathered.append(piece.begin(), piece.length());
+    });
+    BOOST_CHECK(gathered == value);
+    BOOST_CHECK_EQUAL(i->uncompressed_length(), value.length());
+    string uncompressed(value.length(), '\0');
+    i->uncompress_value(&uncompressed[0]);
+    BOOST_CHECK(uncompressed == value);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 } // anonymouse namespace
 
@@ -0,0 +1,79 @@
+#include "unit_test.h"
+#include <cachelot/lz4.h>
+#include <cachelot/random.h>
+
+namespace {
+
+using namespace cachelot;
+
+BOOST_AUTO_TEST_SUITE(test_lz4)
+
+// compress `data`, decompress it back and check the result, return compressed size
+size_t round_trip(const string & data) {
+    std::vector<char> compressed(lz4::compress_bound(data.size()));
+    const size_t compressed_length = lz4::compress(data.data(), data.size(), compressed.data(), compressed.size());
+    BOOST_REQUIRE(compressed_length > 0);
+    string decompressed(data.size(), '\0');
+    BOOST_CHECK(lz4::decompress(compressed.data(), compressed_length, &decompressed[0], decompressed.size()));
+    BOOST_CHECK(decompressed == data);
+    return compressed_length;
+}
+
+BOOST_AUTO_TEST_CASE(test_round_trip) {
+    // too short to have a match
+    round_trip("");
+    round_trip("a");
+    round_trip("abcdefghijkl");
+    // long runs (overlapping matches and long lengths)
+    BOOST_CHECK(round_trip(string(100000, 'x')) < 1000);
+    // repeated text
+    string text;
+    for (int n = 0; text.size() < 64 * 1024; ++n) {
+        text += "{\"id\": " + std::to_string(n) + ", \"name\": \"item\", \"tags\": [\"cache\", \"json\"]},";
+    }
+    BOOST_CHECK(round_trip(text) < text.size() / 3);
+    // random data is incompressible
+    random_int<int> rnd_byte(0, 255);
+    string noise(10000, '\0');
+    for (auto & c : noise) {
+        c = static_cast<char>(rnd_byte());
+    }
+    BOOST_CHECK(round_trip(noise) > noise.size());
+    // mix of all the above
+    BOOST_CHECK(round_trip(noise + text + string(300, 'y') + noise.substr(0, 17)) < noise.size() * 2 + text.size() / 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_reference_format) {
+    // 32 x 'a' encoded by the LZ4 block format spec: literal 'a', match of 26 bytes at offset 1, 5 last literals
+    const char compressed[] = "\x1f\x61\x01\x00\x07\x50\x61\x61\x61\x61\x61";
+    char decompressed[32];
+    BOOST_CHECK(lz4::decompress(compressed, sizeof(compressed) - 1, decompressed, sizeof(decompressed)));
+    BOOST_CHECK(string(decompressed, sizeof(decompressed)) == string(32, 'a'));
+}
+
+BOOST_AUTO_TEST_CASE(test_insufficient_space) {
+    const string data(1000, 'z');
+    char dst[4];
+    BOOST_CHECK_EQUAL(lz4::compress(data.data(), data.size(), dst, sizeof(dst)), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_malformed_input) {
+    const string data(1000, 'z');
+    std::vector<char> compressed(lz4::compress_bound(data.size()));
+    const size_t compressed_length = lz4::compress(data.data(), data.size(), compressed.data(), compressed.size());
+    string decompressed(data.size(), '\0');
+    // truncated input
+    BOOST_CHECK(not lz4::decompress(compressed.data(), compressed_length - 1, &decompressed[0], decompressed.size()));
+    // wrong length of the result
+    BOOST_CHECK(not lz4::decompress(compressed.data(), compressed_length, &decompressed[0], decompressed.size() - 1));
+    BOOST_CHECK(not lz4::decompress(compressed.data(), compressed_length, &decompressed[0], decompressed.size() - 500));
+    // offset beyond the beginning of the output
+    const char bad_offset[] = "\x14\x61\x10\x00\x50\x61\x61\x61\x61\x61";
+    char out[32];
+    BOOST_CHECK(not lz4::decompress(bad_offset, sizeof(bad_offset) - 1, out, 14));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // anonymous namespace
+
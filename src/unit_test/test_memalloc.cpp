@@ -152,6 +152,226 @@ BOOST_AUTO_TEST_CASE(test_pages) {
     BOOST_CHECK_EQUAL((const void *)page_end, (const void *)(arena_begin + 4));
     BOOST_CHECK_EQUAL(&fixture.all_pages[0], fixture.lru_pages.front());
     BOOST_CHECK_EQUAL(fixture.all_pages[0].num_evictions, 1);
+    // value aware eviction
+    memalloc::pages value_aware(4, arena_begin, arena_end, memalloc::eviction_policy::value_aware);
+    for (uint8 * addr = arena_begin; addr < arena_end; addr += page_size) {
+        value_aware.add_used(addr, page_size);
+    }
+    //      LRU order is 3, 2, 0, 1
+    value_aware.touch(arena_begin + 0);
+    BOOST_CHECK_EQUAL(&value_aware.all_pages[1], value_aware.lru_pages.back());
+    //      page #2 is the same age as the LRU tail, but almost empty
+    value_aware.remove_used(arena_begin + 8, 3);
+    BOOST_CHECK_EQUAL(value_aware.all_pages[2].used_bytes, 1);
+    tie(page_beg, page_end) = value_aware.page_to_reuse();
+    BOOST_CHECK_EQUAL((const void *)page_beg, (const void *)(arena_begin + 8));
+    BOOST_CHECK_EQUAL(value_aware.all_pages[2].used_bytes, 0);
+    BOOST_CHECK_EQUAL(&value_aware.all_pages[2], value_aware.lru_pages.front());
+    //      reused page is filled again, page #1 is the cheapest now
+    value_aware.add_used(arena_begin + 8, page_size);
+    tie(page_beg, page_end) = value_aware.page_to_reuse();
+    BOOST_CHECK_EQUAL((const void *)page_beg, (const void *)(arena_begin + 4));
+    // FIFO eviction, pages are reused in the round robin order
+    memalloc::pages fifo(4, arena_begin, arena_end, memalloc::eviction_policy::page_fifo);
+    fifo.touch(arena_begin + 0);
+    tie(page_beg, page_end) = fifo.page_to_reuse();
+    BOOST_CHECK_EQUAL((const void *)page_beg, (const void *)(arena_begin + 0));
+    fifo.touch(arena_begin + 4);
+    tie(page_beg, page_end) = fifo.page_to_reuse();
+    BOOST_CHECK_EQUAL((const void *)page_beg, (const void *)(arena_begin + 4));
+    // CLOCK eviction, accessed pages get the second chance
+    memalloc::pages clock(4, arena_begin, arena_end, memalloc::eviction_policy::page_clock);
+    clock.touch(arena_begin + 0);
+    clock.touch(arena_begin + 4);
+    BOOST_CHECK(clock.page_to_evict() == &clock.all_pages[2]);
+    //      hand has moved to the candidate, passed pages are not scanned again
+    BOOST_CHECK(clock.lru_pages.back() == &clock.all_pages[2]);
+    BOOST_CHECK(not clock.all_pages[0].referenced && not clock.all_pages[1].referenced);
+    BOOST_CHECK(clock.page_to_evict() == &clock.all_pages[2]);
+    tie(page_beg, page_end) = clock.page_to_reuse();
+    BOOST_CHECK_EQUAL((const void *)page_beg, (const void *)(arena_begin + 8));
+    tie(page_beg, page_end) = clock.page_to_reuse();
+    BOOST_CHECK_EQUAL((const void *)page_beg, (const void *)(arena_begin + 12));
+    //      pages #0 and #1 have lost their reference bits
+    tie(page_beg, page_end) = clock.page_to_reuse();
+    BOOST_CHECK_EQUAL((const void *)page_beg, (const void *)(arena_begin + 0));
+    // segmented LRU eviction, protected segment is limited to 3 pages
+    memalloc::pages slru(4, arena_begin, arena_end, memalloc::eviction_policy::page_slru);
+    slru.touch(arena_begin + 0);
+    BOOST_CHECK(slru.all_pages[0].is_protected);
+    tie(page_beg, page_end) = slru.page_to_reuse();
+    BOOST_CHECK_EQUAL((const void *)page_beg, (const void *)(arena_begin + 4));
+    BOOST_CHECK(not slru.all_pages[1].is_protected);
+    slru.touch(arena_begin + 8);
+    slru.touch(arena_begin + 12);
+    //      page #0 is demoted to the probationary segment
+    slru.touch(arena_begin + 4);
+    BOOST_CHECK(not slru.all_pages[0].is_protected);
+    BOOST_CHECK_EQUAL(slru.num_protected_pages, 3);
+    tie(page_beg, page_end) = slru.page_to_reuse();
+    BOOST_CHECK_EQUAL((const void *)page_beg, (const void *)(arena_begin + 0));
+    //      reused page has to be accessed again to be protected
+    tie(page_beg, page_end) = slru.page_to_reuse();
+    BOOST_CHECK_EQUAL((const void *)page_beg, (const void *)(arena_begin + 0));
+    //      probationary segment is empty, the least recently used protected page is evicted
+    slru.touch(arena_begin + 0);
+    BOOST_CHECK_EQUAL(slru.num_protected_pages, 3);
+    BOOST_CHECK(slru.page_to_evict() == &slru.all_pages[2]);
+    // mark_read / apply_read_marks
+    memalloc::pages marked(4, arena_begin, arena_end);
+    marked.enable_read_marks();
+    //      page is queued once no matter how many times it was read
+    marked.mark_read(arena_begin + 4);
+    marked.mark_read(arena_begin + 5);
+    marked.mark_read(arena_begin + 15);
+    BOOST_CHECK_EQUAL(marked.num_marked.load(), 2);
+    marked.apply_read_marks();
+    BOOST_CHECK_EQUAL(marked.all_pages[0].num_hits, 0);
+    BOOST_CHECK_EQUAL(marked.all_pages[1].num_hits, 1);
+    BOOST_CHECK_EQUAL(marked.all_pages[2].num_hits, 0);
+    BOOST_CHECK_EQUAL(marked.all_pages[3].num_hits, 1);
+    //      nothing is applied twice
+    marked.apply_read_marks();
+    BOOST_CHECK_EQUAL(marked.all_pages[1].num_hits, 1);
+    BOOST_CHECK_EQUAL(marked.all_pages[3].num_hits, 1);
+    //      queue wraps around
+    for (int n = 0; n < 10; ++n) {
+        for (size_t page_no = 0; page_no < 4; ++page_no) {
+            marked.mark_read(arena_begin + page_no * page_size);
+        }
+        marked.apply_read_marks();
+    }
+    BOOST_CHECK_EQUAL(marked.all_pages[0].num_hits, 10);
+    BOOST_CHECK_EQUAL(marked.all_pages[1].num_hits, 11);
+    BOOST_CHECK_EQUAL(marked.all_pages[2].num_hits, 10);
+    BOOST_CHECK_EQUAL(marked.all_pages[3].num_hits, 11);
+}
+
+BOOST_AUTO_TEST_CASE(test_pinned_pages) {
+    constexpr size_t page_size = 1 * Kilobyte;
+    memalloc allocator(4 * page_size, page_size);
+    // every allocation occupies the whole page
+    const auto whole_page = page_size - memalloc::header_size();
+    void * pinned = allocator.alloc(whole_page);
+    BOOST_CHECK(pinned != nullptr);
+    allocator.pin(pinned);
+    allocator.pin(pinned);
+    BOOST_CHECK(allocator.is_pinned(pinned));
+    // pinned page must never be evicted
+    for (int n = 0; n < 16; ++n) {
+        void * ptr = allocator.alloc_or_evict(whole_page, true, [=](void * evicted) {
+            BOOST_CHECK(evicted != pinned);
+        });
+        BOOST_CHECK(ptr != nullptr && ptr != pinned);
+    }
+    BOOST_CHECK(not allocator.unpin(pinned));
+    BOOST_CHECK(allocator.is_pinned(pinned));
+    BOOST_CHECK(allocator.unpin(pinned));
+    BOOST_CHECK(not allocator.is_pinned(pinned));
+    // unpinned page can be evicted again
+    bool pinned_evicted = false;
+    for (int n = 0; n < 4; ++n) {
+        allocator.alloc_or_evict(whole_page, true, [&](void * evicted) {
+            pinned_evicted = pinned_evicted || evicted == pinned;
+        });
+    }
+    BOOST_CHECK(pinned_evicted);
+}
+
+BOOST_AUTO_TEST_CASE(test_retired_memory) {
+    constexpr size_t page_size = 1 * Kilobyte;
+    memalloc allocator(4 * page_size, page_size, memalloc::eviction_policy::page_lru, arena_options(), true);
+    BOOST_REQUIRE(allocator.epochs() != nullptr);
+    const auto whole_page = page_size - memalloc::header_size();
+    void * retired = allocator.alloc(whole_page);
+    BOOST_CHECK(retired != nullptr);
+    // memory of the active reader is neither reused nor evicted
+    {
+        epoch_domain::read_guard reader(*allocator.epochs());
+        BOOST_CHECK(reader.ok());
+        allocator.retire(retired);
+        BOOST_CHECK(allocator.is_pinned(retired));
+        BOOST_CHECK_EQUAL(allocator.reclaim(), 0);
+        BOOST_CHECK(allocator.is_pinned(retired));
+    }
+    // reader has left, retired memory is reused before anything is evicted
+    for (int n = 0; n < 4; ++n) {
+        void * ptr = allocator.alloc_or_evict(whole_page, true, [=](void *) {
+            BOOST_ERROR("nothing must be evicted");
+        });
+        BOOST_CHECK(ptr != nullptr);
+        BOOST_CHECK(n < 3 || ptr == retired);
+    }
+    BOOST_CHECK(not allocator.is_pinned(retired));
+    // memory pinned by the user waits for the unpin
+    allocator.pin(retired);
+    allocator.retire(retired);
+    BOOST_CHECK_EQUAL(allocator.reclaim(), 0);
+    BOOST_CHECK(allocator.is_pinned(retired));
+    // the last unpin frees it, it's the only free page
+    BOOST_CHECK(allocator.unpin(retired));
+    BOOST_CHECK(allocator.alloc(whole_page) == retired);
+}
+
+BOOST_AUTO_TEST_CASE(test_item_clock_eviction) {
+    constexpr size_t page_size = 1 * Kilobyte;
+    constexpr size_t item_size = 100;
+    memalloc allocator(4 * page_size, page_size, memalloc::eviction_policy::item_clock);
+    // fill up the arena
+    std::vector<void *> allocated;
+    for (void * ptr = allocator.alloc(item_size); ptr != nullptr; ptr = allocator.alloc(item_size)) {
+        allocated.push_back(ptr);
+    }
+    BOOST_REQUIRE(allocated.size() > 8);
+    // touch every second block in the arena order
+    std::sort(allocated.begin(), allocated.end());
+    for (size_t n = 0; n < allocated.size(); n += 2) {
+        allocator.touch(allocated[n]);
+    }
+    // each allocation must evict single cold block
+    const size_t num_cold = allocated.size() / 2;
+    for (size_t n = 0; n < num_cold; ++n) {
+        std::vector<void *> evicted;
+        void * ptr = allocator.alloc_or_evict(item_size, true, [&evicted](void * evicted_ptr) {
+            evicted.push_back(evicted_ptr);
+        });
+        BOOST_CHECK(ptr != nullptr);
+        BOOST_REQUIRE_EQUAL(evicted.size(), 1);
+        BOOST_CHECK_EQUAL(evicted[0], allocated[2 * n + 1]);
+        BOOST_CHECK_EQUAL(ptr, evicted[0]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_item_clock_victims) {
+    constexpr size_t page_size = 1 * Kilobyte;
+    constexpr size_t item_size = 100;
+    constexpr size_t num_pages = memalloc::victim_search_pages * 4;
+    // fill up the arena, every block is hot except the `cold` one
+    const auto victims_with_cold = [=](const size_t cold) -> std::pair<std::vector<void *>, void *> {
+        memalloc allocator(num_pages * page_size, page_size, memalloc::eviction_policy::item_clock);
+        std::vector<void *> allocated;
+        for (void * ptr = allocator.alloc(item_size); ptr != nullptr; ptr = allocator.alloc(item_size)) {
+            allocated.push_back(ptr);
+        }
+        std::sort(allocated.begin(), allocated.end());
+        const size_t cold_no = std::min(cold, allocated.size() - 1);
+        for (size_t n = 0; n < allocated.size(); ++n) {
+            if (n != cold_no) {
+                allocator.touch(allocated[n]);
+            }
+        }
+        std::vector<void *> victims;
+        allocator.foreach_eviction_victim(item_size, [&victims](void * ptr) { victims.push_back(ptr); });
+        return std::make_pair(victims, allocated[cold_no]);
+    };
+    // cold block close to the CLOCK hand is found
+    auto result = victims_with_cold(1);
+    BOOST_REQUIRE_EQUAL(result.first.size(), 1);
+    BOOST_CHECK_EQUAL(result.first[0], result.second);
+    // cold block far behind the hand is not searched for, the whole page is reported instead
+    result = victims_with_cold(std::numeric_limits<size_t>::max());
+    BOOST_CHECK(result.first.size() > 1);
+    BOOST_CHECK(std::find(result.first.begin(), result.first.end(), result.second) == result.first.end());
 }
 
 BOOST_AUTO_TEST_CASE(test_realloc_inplace) {
@@ -215,7 +435,38 @@ BOOST_AUTO_TEST_CASE(memalloc_basic_stats) {
     BOOST_CHECK_EQUAL(STAT_GET(mem,num_free_table_hits), 0u);
     BOOST_CHECK_EQUAL(STAT_GET(mem,num_free_table_weak_hits), 0u);
     BOOST_CHECK_EQUAL(STAT_GET(mem,evictions), 0u);
+    // arena is allocated on the heap
+    BOOST_CHECK_EQUAL(STAT_GET(mem,hugetlb_bytes), 0u);
+    BOOST_CHECK_EQUAL(STAT_GET(mem,thp_advised_bytes), 0u);
+    BOOST_CHECK(not STAT_GET(mem,numa_bound));
+
+}
 
+
+BOOST_AUTO_TEST_CASE(test_huge_pages_arena) {
+    ResetStats();
+    constexpr size_t memory_limit = 4*Megabyte;
+    constexpr size_t page_size = 64*Kilobyte;
+    arena_options options;
+    options.huge_pages = true;
+    memalloc allocator(memory_limit, page_size, memalloc::eviction_policy::page_lru, options);
+    // huge pages are best effort, the whole arena is either backed by them or not
+    const auto hugetlb_bytes = STAT_GET(mem,hugetlb_bytes);
+    const auto thp_advised_bytes = STAT_GET(mem,thp_advised_bytes);
+    BOOST_CHECK(hugetlb_bytes == 0 || hugetlb_bytes == memory_limit);
+    BOOST_CHECK(thp_advised_bytes == 0 || thp_advised_bytes == memory_limit);
+    BOOST_CHECK(hugetlb_bytes == 0 || thp_advised_bytes == 0);
+    BOOST_CHECK(not STAT_GET(mem,numa_bound));
+    // the whole arena is usable
+    std::vector<void *> allocated;
+    while (void * ptr = allocator.alloc(page_size - memalloc::header_size())) {
+        std::memset(ptr, 0xAB, page_size - memalloc::header_size());
+        allocated.push_back(ptr);
+    }
+    BOOST_CHECK_EQUAL(allocated.size(), memory_limit / page_size);
+    for (auto ptr : allocated) {
+        allocator.free(ptr);
+    }
 }
 
 // allocate and free blocks of a random size
@@ -0,0 +1,203 @@
+#include "unit_test.h"
+#include <cachelot/sharded_cache.h>
+#include <cachelot/random.h>
+#include <thread>
+
+namespace {
+
+using namespace cachelot;
+
+BOOST_AUTO_TEST_SUITE(test_sharded_cache)
+
+static auto calc_hash = fnv1a<cache::Cache::hash_type>::hasher();
+
+void SetItem(cache::ShardedCache & c, const string & k, const string & v) {
+    const auto key = slice(k.c_str(), k.length());
+    const auto value = slice(v.c_str(), v.length());
+    const auto hash = calc_hash(key);
+    auto shard = c.lock_shard_for(hash);
+    auto item = shard->create_item(key, hash, value.length(), 0, cache::Item::infinite_TTL);
+    item->assign_value(value);
+    shard->do_set(item);
+}
+
+bool HasItem(cache::ShardedCache & c, const string & k, const string & v) {
+    const auto key = slice(k.c_str(), k.length());
+    const auto hash = calc_hash(key);
+    auto shard = c.lock_shard_for(hash);
+    auto item = shard->do_get(key, hash);
+    return item != nullptr && item->value() == slice(v.c_str(), v.length());
+}
+
+
+BOOST_AUTO_TEST_CASE(test_create) {
+    BOOST_CHECK_THROW(cache::ShardedCache::Create(0, 4 * Megabyte, 4 * Kilobyte, 16, false), std::invalid_argument);
+    BOOST_CHECK_THROW(cache::ShardedCache::Create(3, 4 * Megabyte, 4 * Kilobyte, 16, false), std::invalid_argument);
+    // not enough memory for 4 pages per shard
+    BOOST_CHECK_THROW(cache::ShardedCache::Create(8, 64 * Kilobyte, 4 * Kilobyte, 16, false), std::invalid_argument);
+    auto the_cache = cache::ShardedCache::Create(4, 4 * Megabyte, 4 * Kilobyte, 16, false);
+    BOOST_CHECK_EQUAL(the_cache.num_shards(), 4);
+    const auto totals = the_cache.collect_stats();
+    BOOST_CHECK_EQUAL(totals.mem.limit_maxbytes, 4 * Megabyte);
+    BOOST_CHECK_EQUAL(totals.mem.page_size, 4 * Kilobyte);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_shard_selection) {
+    auto single = cache::ShardedCache::Create(1, 4 * Megabyte, 4 * Kilobyte, 16, false);
+    BOOST_CHECK_EQUAL(single.shard_no(0), 0);
+    BOOST_CHECK_EQUAL(single.shard_no(0xFFFFFFFF), 0);
+    auto the_cache = cache::ShardedCache::Create(4, 4 * Megabyte, 4 * Kilobyte, 16, false);
+    // shard is determined by the most significant bits of the hash
+    BOOST_CHECK_EQUAL(the_cache.shard_no(0x00000003), 0);
+    BOOST_CHECK_EQUAL(the_cache.shard_no(0x40000000), 1);
+    BOOST_CHECK_EQUAL(the_cache.shard_no(0x80000001), 2);
+    BOOST_CHECK_EQUAL(the_cache.shard_no(0xFFFFFFFF), 3);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_shards_stats) {
+    ResetStats();
+    auto the_cache = cache::ShardedCache::Create(4, 4 * Megabyte, 4 * Kilobyte, 16, false);
+    constexpr size_t num_items = 1000;
+    for (size_t n = 0; n < num_items; ++n) {
+        SetItem(the_cache, std::to_string(n), std::to_string(n));
+    }
+    for (size_t n = 0; n < num_items; ++n) {
+        BOOST_CHECK(HasItem(the_cache, std::to_string(n), std::to_string(n)));
+    }
+    // stats of the shards must not leak into the stats of the thread
+    BOOST_CHECK_EQUAL(STAT_GET(cache, cmd_set), 0);
+    BOOST_CHECK_EQUAL(STAT_GET(cache, cmd_get), 0);
+    auto totals = the_cache.collect_stats();
+    BOOST_CHECK_EQUAL(totals.cache.cmd_set, num_items);
+    BOOST_CHECK_EQUAL(totals.cache.cmd_get, num_items);
+    BOOST_CHECK_EQUAL(totals.cache.get_hits, num_items);
+    BOOST_CHECK_EQUAL(totals.cache.curr_items, num_items);
+    the_cache.do_flush_all();
+    totals = the_cache.collect_stats();
+    BOOST_CHECK_EQUAL(totals.cache.cmd_flush, the_cache.num_shards());
+}
+
+
+BOOST_AUTO_TEST_CASE(test_get_batch) {
+    ResetStats();
+    auto the_cache = cache::ShardedCache::Create(4, 4 * Megabyte, 4 * Kilobyte, 16, false);
+    constexpr size_t num_keys = 200;
+    std::vector<string> key_strings;
+    for (size_t n = 0; n < num_keys; ++n) {
+        key_strings.push_back(std::to_string(n));
+        // store every other key
+        if (n % 2 == 0) {
+            SetItem(the_cache, key_strings.back(), "value" + key_strings.back());
+        }
+    }
+    std::vector<slice> keys; std::vector<cache::hash_type> hashes;
+    for (const auto & k : key_strings) {
+        keys.emplace_back(k.c_str(), k.length());
+        hashes.push_back(calc_hash(keys.back()));
+    }
+    std::vector<cache::ConstItemPtr> items(num_keys);
+    {
+        auto locked = the_cache.do_get_batch(keys.data(), hashes.data(), num_keys, items.data());
+        for (size_t n = 0; n < num_keys; ++n) {
+            if (n % 2 == 0) {
+                BOOST_CHECK(items[n] != nullptr && items[n]->key() == keys[n]);
+                const string expected = "value" + key_strings[n];
+                BOOST_CHECK(items[n] != nullptr && items[n]->value() == slice(expected.c_str(), expected.length()));
+            } else {
+                BOOST_CHECK(items[n] == nullptr);
+            }
+        }
+    }
+    // every shard is unlocked afterwards
+    BOOST_CHECK(HasItem(the_cache, "0", "value0"));
+    const auto totals = the_cache.collect_stats();
+    BOOST_CHECK_EQUAL(totals.cache.cmd_get, num_keys + 1);
+    BOOST_CHECK_EQUAL(totals.cache.get_hits, num_keys / 2 + 1);
+    BOOST_CHECK_EQUAL(STAT_GET(cache, cmd_get), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_concurrent_access) {
+    auto the_cache = cache::ShardedCache::Create(4, 16 * Megabyte, 64 * Kilobyte, 1024, false);
+    constexpr size_t num_threads = 4;
+    constexpr size_t num_items = 2000;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&the_cache, t]() {
+            for (size_t n = 0; n < num_items; ++n) {
+                const auto key = std::to_string(t) + ":" + std::to_string(n);
+                SetItem(the_cache, key, key);
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    for (size_t t = 0; t < num_threads; ++t) {
+        for (size_t n = 0; n < num_items; ++n) {
+            const auto key = std::to_string(t) + ":" + std::to_string(n);
+            BOOST_CHECK(HasItem(the_cache, key, key));
+        }
+    }
+    BOOST_CHECK_EQUAL(the_cache.collect_stats().cache.curr_items, num_threads * num_items);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_concurrent_reads) {
+    // small shards, so items are evicted and the hash tables are expanded while they're read
+    auto the_cache = cache::ShardedCache::Create(2, 1 * Megabyte, 4 * Kilobyte, 16, true, cache::EvictionPolicy::page_lru, false, true, 0, cache::ArenaOptions(), true);
+    BOOST_CHECK_THROW(cache::ShardedCache::Create(2, 1 * Megabyte, 4 * Kilobyte, 16, true, cache::EvictionPolicy::page_lru, true, true, 0, cache::ArenaOptions(), true), std::invalid_argument);
+    constexpr size_t num_readers = 3;
+    constexpr size_t num_keys = 10000;
+    const auto value_of = [](size_t n) { return string(16 + n % 200, static_cast<char>('a' + n % 26)); };
+    std::atomic<bool> done(false);
+    std::atomic<size_t> num_hits(0);
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < num_readers; ++t) {
+        readers.emplace_back([&, t]() {
+            string value;
+            for (size_t n = t; not done.load(); n = (n + 7) % num_keys) {
+                const string key = std::to_string(n);
+                const auto hash = calc_hash(slice(key.c_str(), key.length()));
+                const bool found = the_cache.do_get(slice(key.c_str(), key.length()), hash, [&value](cache::ConstItemPtr item) {
+                    value.assign(item->value().begin(), item->value().length());
+                });
+                // item is either missing (evicted, deleted) or intact
+                if (found) {
+                    num_hits.fetch_add(1);
+                    if (value != value_of(n)) {
+                        BOOST_ERROR("item " << key << " is corrupted");
+                        return;
+                    }
+                }
+            }
+        });
+    }
+    for (size_t round = 0; round < 3; ++round) {
+        for (size_t n = 0; n < num_keys; ++n) {
+            const string key = std::to_string(n);
+            if (n % 5 == round) {
+                const auto hash = calc_hash(slice(key.c_str(), key.length()));
+                the_cache.lock_shard_for(hash)->do_delete(slice(key.c_str(), key.length()), hash);
+            } else {
+                SetItem(the_cache, key, value_of(n));
+            }
+        }
+    }
+    done.store(true);
+    for (auto & reader : readers) {
+        reader.join();
+    }
+    const auto totals = the_cache.collect_stats();
+    BOOST_CHECK(totals.mem.evictions > 0);
+    BOOST_CHECK(totals.cache.concurrent_get_hits > 0);
+    BOOST_CHECK_EQUAL(totals.cache.concurrent_get_hits + totals.cache.get_hits, num_hits.load());
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} //anonymous namespace
+
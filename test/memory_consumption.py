@@ -29,7 +29,8 @@ KEY_ALPHABET = string.ascii_letters + string.digits
 KEY_MINLEN = 10
 KEY_MAXLEN = 60
 
-VALUE_RANGES = [('small',    10,    1024),
+VALUE_RANGES = [('tiny',     10,      30),
+                ('small',    10,    1024),
                 ('medium', 1024,    4096),
                 ('large',  4096, 1000000),
                 ('all',      10, 1000000)]
@@ -160,30 +161,32 @@ def execute_test_n_times(times, mc, minval, maxval, memlimit):
     return all_effective_mem, all_stored_items
 
 
-def execute_test_for_values_range(range_name, minval, maxval):
-    log.info('')
-    # Run dataset on cachelot
-    log.info('*** CACHELOT - range "%s" [%d:%d]' % (range_name, minval, maxval))
-    cache_process = shell_exec(CACHELOTD + ' -p 11211')
+def execute_test_on_server(server_name, command, port, range_name, minval, maxval):
+    "Run dataset on the freshly started caching server"
+    log.info('*** %s - range "%s" [%d:%d]' % (server_name, range_name, minval, maxval))
+    cache_process = shell_exec(command + ' -p %d' % port)
     time.sleep(1) # ensure network is up
-    mc = memcached.connect_tcp('localhost', 11211)
-    cachelot_eff_mem, cachelot_items = execute_test_n_times(NUM_RUNS, mc, minval, maxval, MEMORY_LIMIT)
+    mc = memcached.connect_tcp('localhost', port)
+    eff_mem, items = execute_test_n_times(NUM_RUNS, mc, minval, maxval, MEMORY_LIMIT)
     cache_process.terminate()
     log.info('-' * 60)
+    return eff_mem, items
 
-    # Run dataset on memcached
-    log.info('*** MEMCACHED - range "%s" [%d:%d]' % (range_name, minval, maxval))
-    cache_process = shell_exec(MEMCACHED + ' -p 11212')
-    time.sleep(1)
-    mc = memcached.connect_tcp('localhost', 11212)
-    memcached_eff_mem, memcached_items = execute_test_n_times(NUM_RUNS, mc, minval, maxval, MEMORY_LIMIT)
-    cache_process.terminate()
-    log.info('-' * 60)
+
+def execute_test_for_values_range(range_name, minval, maxval):
+    log.info('')
+    cachelot_eff_mem, cachelot_items = execute_test_on_server('CACHELOT', CACHELOTD, 11211, range_name, minval, maxval)
+    # items are 8 bytes smaller without the CAS timestamp
+    nocas_eff_mem, nocas_items = execute_test_on_server('CACHELOT --no-cas', CACHELOTD + ' --no-cas', 11213, range_name, minval, maxval)
+    memcached_eff_mem, memcached_items = execute_test_on_server('MEMCACHED', MEMCACHED, 11212, range_name, minval, maxval)
     log.info('\n\n')
     r  = 'cachelot: [%s]\n' % ', '.join('%.02f' % toMb(mem) for mem in cachelot_eff_mem)
+    r += 'cachelotNoCAS: [%s]\n' % ', '.join('%.02f' % toMb(mem) for mem in nocas_eff_mem)
     r += 'memcached: [%s]\n' % ', '.join('%.02f' % toMb(mem) for mem in memcached_eff_mem)
     r += 'memDiff: [%s]\n' % ', '.join('%.02f' % toMb(abs(m1 - m2)) for m1, m2 in zip(cachelot_eff_mem, memcached_eff_mem))
+    r += 'noCASSaving: [%s]\n' % ', '.join('%.02f' % toMb(m2 - m1) for m1, m2 in zip(cachelot_eff_mem, nocas_eff_mem))
     r += 'cachelotItems: [%s]\n' % ', '.join('%d' % i for i in cachelot_items)
+    r += 'cachelotNoCASItems: [%s]\n' % ', '.join('%d' % i for i in nocas_items)
     r += 'memcachedItems: [%s]\n' % ', '.join('%d' % i for i in memcached_items)
     return r
 
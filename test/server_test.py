@@ -11,6 +11,8 @@ import memcached
 import time
 import os
 import subprocess
+import socket
+import struct
 
 
 SELF, _ = os.path.splitext(os.path.basename(sys.argv[0]))
@@ -160,6 +162,245 @@ def basic_arithmetic_test(mc):
     log.info("-   success")
 
 
+def receive_until_closed(sock):
+    "Read everything server sends until it closes the connection"
+    received = ''
+    while True:
+        chunk = sock.recv(65536)
+        if not chunk:
+            return received
+        received += chunk
+
+
+def pipelined_quit_test(mc):
+    log.info("replies to the requests pipelined before quit")
+    k = random_key()
+    v = random_value()
+    mc.set(k, v)
+    sock = socket.create_connection(('localhost', 11211))
+    try:
+        sock.sendall('get %s\r\nquit\r\n' % k)
+        reply = receive_until_closed(sock)
+    finally:
+        sock.close()
+    CHECK( reply.startswith('VALUE %s ' % k) )
+    CHECK( reply.endswith(v + '\r\nEND\r\n') )
+    log.info("-   success")
+
+
+# binary protocol opcodes
+BIN_GET, BIN_SET, BIN_ADD, BIN_REPLACE, BIN_DELETE, BIN_INCR, BIN_DECR, BIN_QUIT, BIN_FLUSH, BIN_GETQ, BIN_NOOP = range(0x00, 0x0b)
+BIN_GETK, BIN_GETKQ, BIN_SETQ, BIN_QUITQ = 0x0c, 0x0d, 0x11, 0x17
+# binary protocol response statuses
+BIN_SUCCESS, BIN_ENOENT, BIN_EEXISTS, BIN_E2BIG, BIN_EINVAL = range(0, 5)
+BIN_HEADER = struct.Struct('!BBHBBHIIQ')
+
+
+class BinaryConnection(object):
+    "Raw memcached binary protocol connection"
+
+    def __init__(self, port=11211):
+        self.sock = socket.create_connection(('localhost', port))
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+    def close(self):
+        self.sock.close()
+
+    @staticmethod
+    def packet(opcode, key='', value='', extras='', cas=0, opaque=0, body_length=None):
+        if body_length is None:
+            body_length = len(extras) + len(key) + len(value)
+        return BIN_HEADER.pack(0x80, opcode, len(key), len(extras), 0, 0, body_length, opaque, cas) + extras + key + value
+
+    def send(self, data, chunk_size=None):
+        "Send data at once or by chunks of `chunk_size` bytes, pausing to let the server read them separately"
+        if chunk_size is None:
+            self.sock.sendall(data)
+            return
+        for pos in range(0, len(data), chunk_size):
+            self.sock.sendall(data[pos:pos + chunk_size])
+            time.sleep(0.002)
+
+    def receive_exactly(self, size):
+        received = ''
+        while len(received) < size:
+            chunk = self.sock.recv(size - len(received))
+            if not chunk:
+                raise memcached.ConnectionAbortedException()
+            received += chunk
+        return received
+
+    def response(self):
+        "Read response packet as (opcode, status, opaque, cas, extras, key, value)"
+        magic, opcode, key_len, extras_len, _, status, body_len, opaque, cas = BIN_HEADER.unpack(self.receive_exactly(BIN_HEADER.size))
+        CHECK_EQ( magic, 0x81 )
+        body = self.receive_exactly(body_len)
+        return opcode, status, opaque, cas, body[:extras_len], body[extras_len:extras_len + key_len], body[extras_len + key_len:]
+
+    def request(self, opcode, key='', value='', extras='', cas=0):
+        self.send(self.packet(opcode, key, value, extras, cas))
+        return self.response()
+
+    def is_closed(self):
+        return self.sock.recv(1) == ''
+
+
+def storage_extras(flags=0, exptime=0):
+    return struct.pack('!II', flags, exptime)
+
+
+def arithmetic_extras(delta, initial=0, exptime=0):
+    return struct.pack('!QQI', delta, initial, exptime)
+
+
+def binary_framing_test(mc):
+    log.info("binary protocol: requests split across many reads")
+    conn = BinaryConnection()
+    try:
+        k = random_key()
+        v = random_value()[:2000]
+        # byte by byte, including the header
+        conn.send(conn.packet(BIN_SET, k, v, storage_extras(7)), chunk_size=1)
+        CHECK_EQ( conn.response()[1], BIN_SUCCESS )
+        # pipelined requests broken at arbitrary boundaries
+        conn.send(conn.packet(BIN_GET, k, opaque=1) + conn.packet(BIN_NOOP, opaque=2), chunk_size=7)
+        opcode, status, opaque, _, extras, _, value = conn.response()
+        CHECK_EQ( (opcode, status, opaque, extras, value), (BIN_GET, BIN_SUCCESS, 1, storage_extras(7)[:4], v) )
+        CHECK_EQ( conn.response()[:3], (BIN_NOOP, BIN_SUCCESS, 2) )
+    finally:
+        conn.close()
+    log.info("-   success")
+
+
+def binary_storage_test(mc):
+    log.info("binary protocol: get/getk/getq and set/add/replace/cas")
+    conn = BinaryConnection()
+    try:
+        k = random_key()
+        v1 = random_value()[:1000]
+        v2 = random_value()[:1000]
+        CHECK_EQ( conn.request(BIN_GET, k)[1], BIN_ENOENT )
+        CHECK_EQ( conn.request(BIN_REPLACE, k, v1, storage_extras())[1], BIN_ENOENT )
+        _, status, _, cas1, _, _, _ = conn.request(BIN_ADD, k, v1, storage_extras(1))
+        CHECK_EQ( status, BIN_SUCCESS )
+        CHECK_EQ( conn.request(BIN_ADD, k, v2, storage_extras())[1], BIN_EEXISTS )
+        _, status, _, cas, extras, key, value = conn.request(BIN_GET, k)
+        CHECK_EQ( (status, cas, extras, key, value), (BIN_SUCCESS, cas1, struct.pack('!I', 1), '', v1) )
+        _, status, _, _, _, key, value = conn.request(BIN_GETK, k)
+        CHECK_EQ( (status, key, value), (BIN_SUCCESS, k, v1) )
+        # cas is the set with non-zero cas value
+        CHECK_EQ( conn.request(BIN_SET, k, v2, storage_extras(), cas=cas1 + 1)[1], BIN_EEXISTS )
+        _, status, _, cas2, _, _, _ = conn.request(BIN_SET, k, v2, storage_extras(2), cas=cas1)
+        CHECK_EQ( status, BIN_SUCCESS )
+        CHECK_EQ( conn.request(BIN_REPLACE, k, v1, storage_extras(), cas=cas1)[1], BIN_EEXISTS )
+        CHECK_EQ( conn.request(BIN_GET, k)[6], v2 )
+        CHECK_EQ( conn.request(BIN_REPLACE, k, v1, storage_extras(), cas=cas2)[1], BIN_SUCCESS )
+        CHECK_EQ( conn.request(BIN_GET, k)[6], v1 )
+        # quiet get replies only on hit
+        missing = random_key()
+        conn.send(conn.packet(BIN_GETQ, missing, opaque=1) + conn.packet(BIN_GETQ, k, opaque=2) + conn.packet(BIN_NOOP, opaque=3))
+        CHECK_EQ( conn.response()[:3], (BIN_GETQ, BIN_SUCCESS, 2) )
+        CHECK_EQ( conn.response()[:3], (BIN_NOOP, BIN_SUCCESS, 3) )
+    finally:
+        conn.close()
+    log.info("-   success")
+
+
+def binary_arithmetic_test(mc):
+    log.info("binary protocol: incr/decr/delete/flush")
+    conn = BinaryConnection()
+    try:
+        k = random_key()
+        # counter is not created with the expiration 0xFFFFFFFF
+        CHECK_EQ( conn.request(BIN_INCR, k, extras=arithmetic_extras(1, 10, 0xFFFFFFFF))[1], BIN_ENOENT )
+        _, status, _, _, _, _, value = conn.request(BIN_INCR, k, extras=arithmetic_extras(1, 10))
+        CHECK_EQ( (status, value), (BIN_SUCCESS, struct.pack('!Q', 10)) )
+        CHECK_EQ( conn.request(BIN_INCR, k, extras=arithmetic_extras(5))[6], struct.pack('!Q', 15) )
+        CHECK_EQ( conn.request(BIN_DECR, k, extras=arithmetic_extras(20))[6], struct.pack('!Q', 0) )
+        CHECK_EQ( conn.request(BIN_DELETE, k)[1], BIN_SUCCESS )
+        CHECK_EQ( conn.request(BIN_DELETE, k)[1], BIN_ENOENT )
+        # flush removes expired items, the same as the ascii `flush_all`
+        CHECK_EQ( conn.request(BIN_SET, k, '1', storage_extras(0, 1))[1], BIN_SUCCESS )
+        time.sleep(2)
+        CHECK_EQ( conn.request(BIN_FLUSH)[1], BIN_SUCCESS )
+        CHECK_EQ( conn.request(BIN_GET, k)[1], BIN_ENOENT )
+    finally:
+        conn.close()
+    log.info("-   success")
+
+
+def binary_quiet_batch_test(mc):
+    log.info("binary protocol: batch of quiet commands")
+    conn = BinaryConnection()
+    try:
+        batch = dict((random_key(), random_value()[:100]) for _ in range(10))
+        # quiet storage commands reply nothing on success, noop is the batch barrier
+        conn.send(''.join(conn.packet(BIN_SETQ, k, v, storage_extras()) for k, v in batch.items()) + conn.packet(BIN_NOOP, opaque=1))
+        CHECK_EQ( conn.response()[:3], (BIN_NOOP, BIN_SUCCESS, 1) )
+        keys = batch.keys() + [random_key()]
+        conn.send(''.join(conn.packet(BIN_GETKQ, k) for k in keys) + conn.packet(BIN_NOOP, opaque=2))
+        received = {}
+        while True:
+            opcode, status, opaque, _, _, key, value = conn.response()
+            if opcode == BIN_NOOP:
+                CHECK_EQ( opaque, 2 )
+                break
+            CHECK_EQ( (opcode, status), (BIN_GETKQ, BIN_SUCCESS) )
+            received[key] = value
+        CHECK_EQ( received, batch )
+    finally:
+        conn.close()
+    log.info("-   success")
+
+
+def binary_malformed_request_test(mc):
+    log.info("binary protocol: malformed and oversized requests")
+    conn = BinaryConnection()
+    try:
+        # key and extras exceed the body
+        conn.send(conn.packet(BIN_GET, 'key', body_length=2)[:BIN_HEADER.size + 2])
+        CHECK_EQ( conn.response()[1], BIN_EINVAL )
+        # connection is still usable
+        CHECK_EQ( conn.request(BIN_NOOP)[1], BIN_SUCCESS )
+        # body that can't fit any item is refused without being read
+        conn.send(conn.packet(BIN_SET, body_length=0xFFFFFFF0))
+        CHECK_EQ( conn.response()[1], BIN_E2BIG )
+        CHECK( conn.is_closed() )
+    finally:
+        conn.close()
+    log.info("-   success")
+
+
+def binary_quit_test(mc):
+    log.info("binary protocol: quit/quitq")
+    conn = BinaryConnection()
+    try:
+        conn.send(conn.packet(BIN_NOOP, opaque=1) + conn.packet(BIN_QUIT, opaque=2))
+        CHECK_EQ( conn.response()[:3], (BIN_NOOP, BIN_SUCCESS, 1) )
+        CHECK_EQ( conn.response()[:3], (BIN_QUIT, BIN_SUCCESS, 2) )
+        CHECK( conn.is_closed() )
+    finally:
+        conn.close()
+    conn = BinaryConnection()
+    try:
+        conn.send(conn.packet(BIN_QUITQ))
+        CHECK( conn.is_closed() )
+    finally:
+        conn.close()
+    log.info("-   success")
+
+
+def run_binary_protocol_test(mc):
+    log.info("Test binary protocol")
+    binary_framing_test(mc)
+    binary_storage_test(mc)
+    binary_arithmetic_test(mc)
+    binary_quiet_batch_test(mc)
+    binary_malformed_request_test(mc)
+    binary_quit_test(mc)
+    log.info("all binary protocol tests passed")
+
+
 def run_smoke_test(mc):
     log.info("Test basic functionality")
     basic_storage_test(mc)
@@ -167,9 +408,125 @@ def run_smoke_test(mc):
     basic_batch_op_test(mc)
     basic_expiration_test(mc)
     basic_arithmetic_test(mc)
+    pipelined_quit_test(mc)
     log.info("all basic functionality tests passed")
 
 
+def start_server(cachelotd, *args):
+    "Start dedicated cachelotd instance, caller is responsible to terminate it"
+    return subprocess.Popen([cachelotd] + list(args), stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+
+
+def stop_server(proc):
+    if proc.poll() is None:
+        proc.terminate()
+        proc.wait()
+
+
+def reuseport_test(cachelotd):
+    log.info("--reuseport option")
+    port = '11311'
+    first = start_server(cachelotd, '-p', port, '-U', '0', '-t', '1', '--reuseport')
+    second = None
+    try:
+        if not hasattr(socket, 'SO_REUSEPORT'):
+            # server must refuse the option instead of silently ignoring it
+            output, _ = first.communicate()
+            CHECK( first.returncode != 0 )
+            CHECK( 'SO_REUSEPORT' in output )
+            log.info("-   success (SO_REUSEPORT is not available)")
+            return
+        time.sleep(1)
+        CHECK_EQ( first.poll(), None )
+        # another listener must be able to bind the same port
+        second = start_server(cachelotd, '-p', port, '-U', '0', '-t', '1', '--reuseport')
+        time.sleep(1)
+        CHECK_EQ( second.poll(), None )
+        for _ in range(8):
+            mc = memcached.connect_tcp('localhost', int(port))
+            CHECK( mc.version() )
+        # while without the option the port is busy
+        busy = start_server(cachelotd, '-p', port, '-U', '0', '-t', '1')
+        busy.communicate()
+        CHECK( busy.returncode != 0 )
+    finally:
+        stop_server(first)
+        if second:
+            stop_server(second)
+    log.info("-   success")
+
+
+def no_cas_test(cachelotd):
+    log.info("--no-cas option")
+    port = 11312
+    server = start_server(cachelotd, '-p', str(port), '-U', '0', '-t', '1', '--no-cas')
+    try:
+        time.sleep(1)
+        sock = socket.create_connection(('localhost', port))
+        try:
+            replies = []
+            # large value is received differently, but the command is rejected the same way
+            for length in (100, 200000):
+                sock.sendall('cas %s 0 0 %d 1\r\n%s\r\nversion\r\n' % (random_key(), length, 'x' * length))
+                reply = ''
+                while not reply.endswith('\r\n') or reply.count('\r\n') < 2:
+                    reply += sock.recv(4096)
+                error, version = reply.split('\r\n')[:2]
+                CHECK( version.startswith('VERSION ') )
+                replies.append(error)
+            CHECK( replies[0].startswith('SERVER_ERROR') )
+            CHECK_EQ( replies[0], replies[1] )
+        finally:
+            sock.close()
+    finally:
+        stop_server(server)
+    log.info("-   success")
+
+
+def concurrent_reads_test(cachelotd):
+    log.info("--concurrent-reads option")
+    port = 11313
+    server = start_server(cachelotd, '-p', str(port), '-U', '0', '-t', '2', '--concurrent-reads')
+    try:
+        time.sleep(1)
+        CHECK_EQ( server.poll(), None )
+        mc = memcached.connect_tcp('localhost', port)
+        # ascii get / gets / multi-get and large values read without the shard lock
+        basic_storage_test(mc)
+        basic_cas_test(mc)
+        basic_batch_op_test(mc)
+        # binary get
+        conn = BinaryConnection(port)
+        try:
+            k = random_key()
+            v = random_value()
+            CHECK_EQ( conn.request(BIN_SET, k, v, storage_extras(3))[1], BIN_SUCCESS )
+            _, status, _, _, extras, key, value = conn.request(BIN_GETK, k)
+            CHECK_EQ( (status, extras, key, value), (BIN_SUCCESS, struct.pack('!I', 3), k, v) )
+            CHECK_EQ( conn.request(BIN_GET, random_key())[1], BIN_ENOENT )
+        finally:
+            conn.close()
+        stats = dict(mc.stats())
+        CHECK( int(stats['concurrent_get_hits']) > 0 )
+        CHECK( int(stats['concurrent_get_misses']) > 0 )
+    finally:
+        stop_server(server)
+    # lock-free readers are not compatible with the admission filter
+    server = start_server(cachelotd, '-p', str(port), '-U', '0', '--concurrent-reads', '--admission')
+    output, _ = server.communicate()
+    CHECK( server.returncode != 0 )
+    CHECK( '--concurrent-reads' in output )
+    log.info("-   success")
+
+
+def run_options_test(cachelotd):
+    log.info("Test command line options")
+    reuseport_test(cachelotd)
+    no_cas_test(cachelotd)
+    concurrent_reads_test(cachelotd)
+    log.info("all command line options tests passed")
+
+
 def run_fuzzy_test(mc):
     # TODO: !!!
     pass
@@ -181,6 +538,10 @@ def main():
     ver = mc.version()
     log.info("Version: '%s'", ver)
     run_smoke_test(mc)
+    run_binary_protocol_test(mc)
+    # tests below start their own server instances
+    if len(sys.argv) > 1:
+        run_options_test(sys.argv[1])
 
 if __name__ == '__main__':
     logging.basicConfig(level=logging.DEBUG)